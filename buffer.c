@@ -0,0 +1,192 @@
+/*
+ * buffer.c: Elvis plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#include "common.h"
+#include "log.h"
+#include "buffer.h"
+
+// --- cElvisBlock -----------------------------------------------------
+
+cElvisBlock::cElvisBlock()
+: dataM(NULL),
+  lengthM(0),
+  generationM(0)
+{
+}
+
+// --- cElvisBlockBuffer -----------------------------------------------
+
+cElvisBlockBuffer::cElvisBlockBuffer()
+: memoryM(MALLOC(uchar, eBlockCount * eBlockSize)),
+  generationM(0),
+  skippedM(0),
+  writeM(0),
+  syncedM(false),
+  readM(0),
+  offsetM(0)
+{
+  if (memoryM) {
+     for (int i = 0; i < eBlockCount; ++i)
+         blocksM[i].dataM = memoryM + i * eBlockSize;
+     }
+  else
+     error("%s Out of memory", __PRETTY_FUNCTION__);
+}
+
+cElvisBlockBuffer::~cElvisBlockBuffer()
+{
+  free(memoryM);
+}
+
+bool cElvisBlockBuffer::Next(unsigned int generationP)
+{
+  // producer: the block after the newest one must not be the one being played
+  if ((writeM + 1 - __atomic_load_n(&readM, __ATOMIC_ACQUIRE)) >= eBlockCount)
+     return false;
+  cElvisBlock *b = Block(writeM + 1);
+  b->lengthM = 0;
+  b->generationM = generationP;
+  // publish the block only after it has been set up
+  __atomic_store_n(&writeM, writeM + 1, __ATOMIC_RELEASE);
+
+  return true;
+}
+
+void cElvisBlockBuffer::Advance()
+{
+  // consumer: hand the played block back to the producer
+  offsetM = 0;
+  __atomic_store_n(&readM, readM + 1, __ATOMIC_RELEASE);
+}
+
+int cElvisBlockBuffer::Sync(const uchar *dataP, int lenP)
+{
+  // producer: returns the bytes to be skipped before the first packet
+  for (int i = 0; i < lenP; ++i) {
+      if ((dataP[i] == TS_SYNC_BYTE) && ((i + TS_SIZE >= lenP) || (dataP[i + TS_SIZE] == TS_SYNC_BYTE))) {
+         syncedM = true;
+         return i;
+         }
+      }
+
+  return lenP;
+}
+
+int cElvisBlockBuffer::Free()
+{
+  unsigned int write = __atomic_load_n(&writeM, __ATOMIC_ACQUIRE);
+  unsigned int read = __atomic_load_n(&readM, __ATOMIC_ACQUIRE);
+  int length = __atomic_load_n(&Block(write)->lengthM, __ATOMIC_ACQUIRE);
+
+  return (int)(eBlockCount - 1 - (write - read)) * eBlockSize + (eBlockSize - length);
+}
+
+int cElvisBlockBuffer::Available()
+{
+  unsigned int write = __atomic_load_n(&writeM, __ATOMIC_ACQUIRE);
+  unsigned int read = __atomic_load_n(&readM, __ATOMIC_ACQUIRE);
+  int length = __atomic_load_n(&Block(write)->lengthM, __ATOMIC_ACQUIRE);
+
+  // includes the part of the oldest block already played
+  return (int)(write - read) * eBlockSize + length;
+}
+
+bool cElvisBlockBuffer::Put(const uchar *dataP, int lenP)
+{
+  unsigned int generation = __atomic_load_n(&generationM, __ATOMIC_ACQUIRE);
+
+  if (!memoryM)
+     return false;
+  if (Block(writeM)->generationM != generation) {
+     // the buffer has been cleared, so start over in a block of the current generation
+     if (!Next(generation))
+        return false;
+     syncedM = false;
+     }
+  if (!syncedM) {
+     // the packets must start at the beginning of a block to stay within it
+     int skip = Sync(dataP, lenP);
+     if (skip > 0) {
+        debug5("%s Skipped %d bytes to sync on TS packet", __PRETTY_FUNCTION__, skip);
+        __atomic_add_fetch(&skippedM, skip, __ATOMIC_RELAXED);
+        dataP += skip;
+        lenP -= skip;
+        }
+     }
+  if (lenP <= 0)
+     return true;
+  if (lenP > Free())
+     return false;
+
+  while (lenP > 0) {
+        cElvisBlock *b = Block(writeM);
+        if (b->lengthM >= eBlockSize) {
+           if (!Next(generation))
+              return false;
+           b = Block(writeM);
+           }
+        int len = min(lenP, eBlockSize - b->lengthM);
+        memcpy(b->dataM + b->lengthM, dataP, len);
+        // publish the data only after it has been copied
+        __atomic_store_n(&b->lengthM, b->lengthM + len, __ATOMIC_RELEASE);
+        dataP += len;
+        lenP -= len;
+        }
+
+  return true;
+}
+
+uchar *cElvisBlockBuffer::Get(int &lenP)
+{
+  unsigned int generation = __atomic_load_n(&generationM, __ATOMIC_ACQUIRE);
+
+  lenP = 0;
+  if (!memoryM)
+     return NULL;
+  for (;;) {
+      bool sealed = (readM != __atomic_load_n(&writeM, __ATOMIC_ACQUIRE));
+      cElvisBlock *b = Block(readM);
+      int count = __atomic_load_n(&b->lengthM, __ATOMIC_ACQUIRE) - offsetM;
+      // drop the cleared blocks and the ones played through, unless the transfer is still writing into them
+      if ((b->generationM != generation) || (count < TS_SIZE)) {
+         if (!sealed)
+            return NULL;
+         Advance();
+         continue;
+         }
+
+      uchar *p = b->dataM + offsetM;
+      if (*p != TS_SYNC_BYTE) {
+         for (int i = 1; i < count; ++i) {
+             if (p[i] == TS_SYNC_BYTE) {
+                count = i;
+                break;
+                }
+             }
+         debug5("%s Skipped %d bytes to sync on TS packet", __PRETTY_FUNCTION__, count);
+         __atomic_add_fetch(&skippedM, count, __ATOMIC_RELAXED);
+         offsetM += count;
+         return NULL;
+         }
+      lenP = count - (count % TS_SIZE);
+
+      return p;
+      }
+}
+
+void cElvisBlockBuffer::Del(int lenP)
+{
+  // consumer: the block stays put until the next Get() finds it played through
+  if (lenP > 0)
+     offsetM = min(offsetM + lenP, __atomic_load_n(&Block(readM)->lengthM, __ATOMIC_ACQUIRE));
+}
+
+void cElvisBlockBuffer::Clear()
+{
+  // both sides drop the blocks of the previous generations on their own
+  __atomic_add_fetch(&generationM, 1, __ATOMIC_ACQ_REL);
+}
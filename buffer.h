@@ -0,0 +1,74 @@
+/*
+ * buffer.h: Elvis plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#ifndef __ELVIS_BUFFER_H
+#define __ELVIS_BUFFER_H
+
+#include <vdr/remux.h>
+#include <vdr/tools.h>
+
+// --- cElvisBlock -----------------------------------------------------
+
+class cElvisBlock {
+  friend class cElvisBlockBuffer;
+private:
+  uchar *dataM;
+  int lengthM;              // published by the transfer
+  unsigned int generationM; // the buffer generation the block was started in
+  // to prevent copy constructor and assignment
+  cElvisBlock(const cElvisBlock&);
+  cElvisBlock& operator=(const cElvisBlock&);
+public:
+  cElvisBlock();
+};
+
+// --- cElvisBlockBuffer -----------------------------------------------
+
+// a lock-free ring of transport stream aligned blocks for exactly one producer and one consumer:
+// the transfer writes into the newest block and the player plays straight out of the oldest one;
+// the blocks in between belong to neither, so the only shared state are the block indices, the
+// published block lengths and the generation, which is bumped to clear the buffer from either side
+class cElvisBlockBuffer {
+private:
+  enum {
+    eBlockSize  = 348 * TS_SIZE, // in bytes
+    eBlockCount = 32             // must be a power of two
+  };
+  uchar *memoryM;
+  cElvisBlock blocksM[eBlockCount];
+  unsigned int generationM;
+  unsigned long skippedM;
+  // owned by the producer
+  unsigned int writeM;
+  bool syncedM;
+  // owned by the consumer
+  unsigned int readM;
+  int offsetM;
+  cElvisBlock *Block(unsigned int indexP) { return &blocksM[indexP % eBlockCount]; }
+  bool Next(unsigned int generationP);
+  void Advance();
+  int Sync(const uchar *dataP, int lenP);
+  // to prevent copy constructor and assignment
+  cElvisBlockBuffer(const cElvisBlockBuffer&);
+  cElvisBlockBuffer& operator=(const cElvisBlockBuffer&);
+public:
+  cElvisBlockBuffer();
+  virtual ~cElvisBlockBuffer();
+  // the bytes the producer can still store and the ones buffered for the consumer
+  int Free();
+  int Available();
+  // producer: stores either all of the data or nothing
+  bool Put(const uchar *dataP, int lenP);
+  // consumer: returns whole packets of the oldest block, which stays untouched until the matching Del()
+  uchar *Get(int &lenP);
+  void Del(int lenP);
+  // either side: drops everything buffered so far
+  void Clear();
+  unsigned long Skipped() { return __atomic_load_n(&skippedM, __ATOMIC_RELAXED); }
+};
+
+#endif // __ELVIS_BUFFER_H
@@ -25,27 +25,38 @@ static int hex2dec(char hex)
   return -1;
 }
 
+size_t strunescape(char *d, const char *s)
+{
+  // copy the plain runs in one go and decode only the escapes in between
+  char *t = d;
+  for (const char *p = strchr(s, '%'); p; p = strchr(s, '%')) {
+      memcpy(t, s, p - s);
+      t += p - s;
+      int a = p[1] ? hex2dec(p[1]) : -1;
+      int b = (a >= 0) ? hex2dec(p[2]) : -1;
+      if ((a >= 0) && (b >= 0)) {
+         *t++ = (char)((a << 4) + b);
+         s = p + 3;
+         }
+      else {
+         *t++ = *p;
+         s = p + 1;
+         }
+      }
+  size_t len = strlen(s);
+  memcpy(t, s, len + 1);
+
+  return (t - d) + len;
+}
+
 cString strunescape(const char *s)
 {
   if (s) {
-     char *buffer = strdup(s);
-     const char *p = s;
-     const char *end = p + strlen(s);
-     char *t = buffer;
-     while (*p) {
-           if (*p == '%') {
-              if ((end - p) >= 2) {
-                 int a = hex2dec(*++p) & 0xF;
-                 int b = hex2dec(*++p) & 0xF;
-                 if ((a >= 0) && (b >= 0))
-                    *t++ = (char)((a << 4) + b);
-                 }
-              }
-           else
-              *t++ = *p;
-           ++p;
-           }
-     *t = 0;
+     if (!strchr(s, '%'))
+        return cString(s);
+     // unescaping never makes the string any longer
+     char *buffer = MALLOC(char, strlen(s) + 1);
+     strunescape(buffer, s);
      return cString(buffer, true);
      }
 
@@ -114,34 +125,90 @@ cString ShortDateString(time_t t)
   return buf;
 }
 
-time_t strtotime(const char *s)
+// --- strtotime ------------------------------------------------------
+
+// days before the first day of each month in a common year
+static constexpr int monthOffsetS[12] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+
+static constexpr bool IsLeapYear(int y)
+{
+  return ((y % 4) == 0) && (((y % 100) != 0) || ((y % 400) == 0));
+}
+
+// days since the epoch; valid from 1970 onwards
+static constexpr long DaysSinceEpoch(int y, int m, int d)
 {
-  time_t r = 0;
+  return 365L * (y - 1970) + ((y - 1969) / 4) - ((y - 1901) / 100) + ((y - 1601) / 400) + monthOffsetS[m - 1] + (((m > 2) && IsLeapYear(y)) ? 1 : 0) + (d - 1);
+}
+
+// the last sunday of the month ending at the given day; the epoch was a thursday
+static constexpr long LastSunday(long daysP)
+{
+  return daysP - ((daysP + 4) % 7);
+}
 
-  if (s && *s) {
-     struct tm t;
-     char *weekday;
+static_assert(DaysSinceEpoch(2000, 3, 1) == 11017, "invalid day calculation");
+static_assert(LastSunday(DaysSinceEpoch(2010, 10, 31)) == DaysSinceEpoch(2010, 10, 31), "invalid weekday calculation");
 
-     // example inputs: "ke 22.09.2010 21:00", "19.10.2010 23:50:00"
-     if ((sscanf(s, "%m[^ ] %d.%d.%d %d:%d", &weekday, &t.tm_mday, &t.tm_mon, &t.tm_year, &t.tm_hour, &t.tm_min) == 6) ||
-         (sscanf(s, "%d.%d.%d %d:%d", &t.tm_mday, &t.tm_mon, &t.tm_year, &t.tm_hour, &t.tm_min) == 5)) {
+static void HelsinkiDst(int yearP, time_t &startP, time_t &endP)
+{
+  // europe/helsinki observes the eu rules: from the last sunday of march until the last sunday of october at 01:00 UTC
+  static __thread int yearS = 0;
+  static __thread time_t startS = 0;
+  static __thread time_t endS = 0;
+
+  if (yearP != yearS) {
+     startS = LastSunday(DaysSinceEpoch(yearP, 3, 31)) * SECSINDAY + 3600;
+     endS = LastSunday(DaysSinceEpoch(yearP, 10, 31)) * SECSINDAY + 3600;
+     yearS = yearP;
+     }
+  startP = startS;
+  endP = endS;
+}
 
-        t.tm_sec   = 0;
-        t.tm_mon  -= 1;
-        t.tm_year -= 1900;
-        t.tm_isdst = -1;
-        t.tm_zone  = "EET";
+static bool ParseNumber(const char *&s, int minDigitsP, int maxDigitsP, int &valueP)
+{
+  int digits = 0;
 
-        r = mktime(&t);
+  valueP = 0;
+  while ((digits < maxDigitsP) && isdigit(*s)) {
+        valueP = valueP * 10 + (*s++ - '0');
+        ++digits;
         }
-     else
-        error("%s (%s) Conversion failed", __PRETTY_FUNCTION__, s);
 
-     if (weekday)
-        free(weekday);
+  return (digits >= minDigitsP);
+}
+
+time_t strtotime(const char *s)
+{
+  if (!s || !*s)
+     return 0;
+
+  // example inputs: "ke 22.09.2010 21:00", "19.10.2010 23:50:00"
+  const char *p = s;
+  int day, month, year, hour, minute, second = 0;
+  if (!isdigit(*p)) {
+     // skip the weekday
+     while (*p && (*p != ' '))
+           ++p;
+     while (*p == ' ')
+           ++p;
      }
+  if (ParseNumber(p, 1, 2, day) && (*p++ == '.') && ParseNumber(p, 1, 2, month) && (*p++ == '.') && ParseNumber(p, 4, 4, year) && (*p++ == ' ') &&
+      ParseNumber(p, 1, 2, hour) && (*p++ == ':') && ParseNumber(p, 2, 2, minute) && ((*p != ':') || (ParseNumber(++p, 2, 2, second))) &&
+      (day >= 1) && (day <= 31) && (month >= 1) && (month <= 12) && (year >= 1970) && (year < 2100) && (hour < 24) && (minute < 60) && (second < 60)) {
+     time_t start, end;
+     time_t local = DaysSinceEpoch(year, month, day) * SECSINDAY + hour * 3600 + minute * 60 + second;
+     HelsinkiDst(year, start, end);
+     // the local time is two hours ahead of UTC and three hours during the daylight saving time
+     if (((local - 3 * 3600) >= start) && ((local - 3 * 3600) < end))
+        return local - 3 * 3600;
+     return local - 2 * 3600;
+     }
+
+  error("%s (%s) Conversion failed", __PRETTY_FUNCTION__, s);
 
-  return r;
+  return 0;
 }
 
 // --- cMenuEditHiddenStrItem -------------------------------------------
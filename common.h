@@ -25,6 +25,7 @@
 #define LOCK_THREAD_INSTANCE(x) cThreadLock ThreadLock(x)
 
 extern const char VERSION[];
+extern size_t     strunescape(char *d, const char *s);
 extern cString    strunescape(const char *s);
 extern cString    strescape(const char *s);
 extern cString    strstrip(const char *s, const char *r);
@@ -18,7 +18,9 @@ cElvisConfig::cElvisConfig()
   hideMenuM(0),
   replaceScheduleM(0),
   replaceTimersM(0),
-  replaceRecordingsM(0)
+  replaceRecordingsM(0),
+  requestRateM(5),
+  lazyEPGM(0)
 {
   memset(usernameM, 0, sizeof(usernameM));
   memset(passwordM, 0, sizeof(passwordM));
@@ -74,6 +76,8 @@ bool cElvisConfig::Parse(const char *nameP, const char *valueP)
   if      (!strcasecmp(nameP, "Username")) Utf8Strn0Cpy(usernameM, valueP, sizeof(usernameM));
   else if (!strcasecmp(nameP, "Password")) Utf8Strn0Cpy(passwordM, valueP, sizeof(passwordM));
   else if (!strcasecmp(nameP, "HideMenu")) hideMenuM = atoi(valueP);
+  else if (!strcasecmp(nameP, "RequestRate")) requestRateM = atoi(valueP);
+  else if (!strcasecmp(nameP, "LazyEPG")) lazyEPGM = atoi(valueP);
   else
      return false;
   return true;
@@ -84,6 +88,8 @@ bool cElvisConfig::Save()
   Store("HideMenu",  hideMenuM);
   Store("Username",  usernameM);
   Store("Password",  passwordM);
+  Store("RequestRate", requestRateM);
+  Store("LazyEPG", lazyEPGM);
 
   Sort();
 
@@ -19,6 +19,8 @@ private:
   int replaceScheduleM;
   int replaceTimersM;
   int replaceRecordingsM;
+  int requestRateM;
+  int lazyEPGM;
   char usernameM[CREDENTIALS_MAX];
   char passwordM[CREDENTIALS_MAX];
 
@@ -59,6 +61,8 @@ public:
   int GetReplaceSchedule(void) const { return replaceScheduleM; }
   int GetReplaceTimers(void) const { return replaceTimersM; }
   int GetReplaceRecordings(void) const { return replaceRecordingsM; }
+  int GetRequestRate(void) const { return requestRateM; }
+  int GetLazyEPG(void) const { return lazyEPGM; }
   const char *GetUsername(void) const { return usernameM; }
   const char *GetPassword(void) const { return passwordM; }
 
@@ -67,6 +71,8 @@ public:
   void SetReplaceSchedule(int replaceScheduleP) { replaceScheduleM = replaceScheduleP; }
   void SetReplaceTimers(int replaceTimersP) { replaceTimersM = replaceTimersP; }
   void SetReplaceRecordings(int replaceRecordingsP) { replaceRecordingsM = replaceRecordingsP; }
+  void SetRequestRate(int requestRateP) { requestRateM = requestRateP; }
+  void SetLazyEPG(int lazyEPGP) { lazyEPGM = lazyEPGP; }
   void SetUsername(const char *usernameP) { strn0cpy(usernameM, usernameP, sizeof(usernameM)); }
   void SetPassword(const char *passwordP) { strn0cpy(passwordM, passwordP, sizeof(passwordM)); }
 };
@@ -12,9 +12,14 @@
 #include "common.h"
 #include "config.h"
 #include "fetch.h"
+#include "index.h"
+#include "info.h"
 #include "menu.h"
+#include "pool.h"
 #include "resume.h"
 #include "setup.h"
+#include "snapshot.h"
+#include "transport.h"
 #include "elvisservice.h"
 
 #if defined(APIVERSNUM) && APIVERSNUM < 20400
@@ -32,6 +37,7 @@ static const char MAINMENUENTRY[] = trNOOP("Elvis");
 class cPluginElvis : public cPlugin {
 private:
   // Add any member variables or functions you may need here.
+  cString serverM;
 
 public:
   cPluginElvis();
@@ -71,21 +77,25 @@ cPluginElvis::~cPluginElvis()
 const char *cPluginElvis::CommandLineHelp()
 {
   // Return a string that describes all known command line options.
-  return "  -t <mode>, --trace=<mode>  set the tracing mode\n";
+  return "  -s <url>,  --server=<url>  use an alternative server base url\n"
+         "  -t <mode>, --trace=<mode>  set the tracing mode\n";
 }
 
 bool cPluginElvis::ProcessArgs(int argc, char *argv[])
 {
   // Implement command line argument processing here if applicable.
   static const struct option long_options[] = {
+    { "server",   required_argument, NULL, 's' },
     { "trace",    required_argument, NULL, 't' },
     { NULL,       no_argument,       NULL,  0  }
     };
 
-  cString server;
   int c;
-  while ((c = getopt_long(argc, argv, "t:", long_options, NULL)) != -1) {
+  while ((c = getopt_long(argc, argv, "s:t:", long_options, NULL)) != -1) {
     switch (c) {
+      case 's':
+           serverM = optarg;
+           break;
       case 't':
            ElvisConfig.SetTraceMode(strtol(optarg, NULL, 0));
            break;
@@ -99,37 +109,46 @@ bool cPluginElvis::ProcessArgs(int argc, char *argv[])
 bool cPluginElvis::Initialize()
 {
   // Initialize any background activities the plugin shall perform.
+  curl_global_init(CURL_GLOBAL_ALL);
   ElvisConfig.Load(ConfigDirectory(PLUGIN_NAME_I18N));
   cElvisResumeItems::GetInstance()->Load(ConfigDirectory(PLUGIN_NAME_I18N));
-  cElvisWidget::GetInstance()->Load(ConfigDirectory(PLUGIN_NAME_I18N));
+  cElvisSnapshot::GetInstance()->Load(ConfigDirectory(PLUGIN_NAME_I18N));
+  cElvisWidget::GetInstance()->Load(ConfigDirectory(PLUGIN_NAME_I18N), *serverM);
   return true;
 }
 
 bool cPluginElvis::Start()
 {
   // Start any background activities the plugin shall perform.
-  curl_global_init(CURL_GLOBAL_ALL);
   return true;
 }
 
 void cPluginElvis::Stop()
 {
   // Stop any background activities the plugin is performing.
+  cElvisSnapshot::GetInstance()->Save();
   cElvisRecordings::Destroy();
   cElvisTimers::Destroy();
   cElvisSearchTimers::Destroy();
   cElvisTopEvents::Destroy();
   cElvisVODCategories::Destroy();
   cElvisChannels::Destroy();
+  cElvisChannelIds::Destroy();
+  cElvisSnapshot::Destroy();
+  cElvisInfoCache::Destroy();
   cElvisWidget::Destroy();
   cElvisFetcher::Destroy();
   cElvisResumeItems::Destroy();
+  cElvisTimeIndexes::Destroy();
+  cElvisTransport::Destroy();
+  cElvisStringPool::Destroy();
   curl_global_cleanup();
 }
 
 void cPluginElvis::Housekeeping()
 {
   // Perform any cleanup or other regular tasks.
+  cElvisWidget::GetInstance()->Housekeeping();
 }
 
 void cPluginElvis::MainThreadHook()
@@ -179,6 +198,43 @@ bool cPluginElvis::Service(const char *idP, void *dataP)
         }
      return true;
      }
+  else if (strcmp(idP, "ElvisService-Events-v1.0") == 0) {
+     if (dataP) {
+        ElvisService_Events_v1_0 *data = reinterpret_cast<ElvisService_Events_v1_0*>(dataP);
+        cElvisChannels *channels = cElvisChannels::GetInstance();
+        cVector<cElvisEvent *> events, next;
+        time_t startTime = data->startTime ? data->startTime : time(NULL);
+        channels->Update();
+        LOCK_THREAD_INSTANCE(channels);
+        switch (data->query) {
+          case ElvisService_Events_v1_0::eQueryNowNext:
+               channels->GetNowNext(startTime, events, next);
+               for (int i = 0; i < next.Size(); ++i)
+                   events.Insert(next[i], 2 * i + 1);
+               break;
+          case ElvisService_Events_v1_0::eQueryWindow:
+               channels->GetEvents(startTime, data->endTime, events);
+               break;
+          case ElvisService_Events_v1_0::eQueryFrom:
+               channels->GetEventsFrom(startTime, max(data->count, 1), events);
+               break;
+          default:
+               return false;
+          }
+        for (int i = 0; i < events.Size(); ++i) {
+            if (events[i]) {
+               ElvisService_Event_v1_0 *event = new ElvisService_Event_v1_0;
+               event->eventId = events[i]->Id();
+               event->channel = events[i]->Channel();
+               event->title = events[i]->Name();
+               event->startTime = events[i]->StartTimeValue();
+               event->endTime = events[i]->EndTimeValue();
+               data->events.Add(event);
+               }
+            }
+        }
+     return true;
+     }
 #if defined(MAINMENUHOOKSVERSNUM)
   else if (ElvisConfig.GetReplaceSchedule() && (strcmp(idP, "MainMenuHooksPatch-v1.0::osSchedule") == 0)) {
      if (dataP) {
@@ -222,6 +278,12 @@ const char **cPluginElvis::SVDRPHelpPages()
     "    Delete an existing timer.",
     "TRAC [ <mode> ]\n"
     "    Gets and/or sets used tracing mode.\n",
+    "STAT\n"
+    "    Show transfer statistics.",
+    "BENC [ <channels> [ <days> ] ]\n"
+    "    Time the EPG indexes with synthetic events, by default 200 channels for 7 days.",
+    "BENW [ <rounds> ]\n"
+    "    Time every server call, by default for 10 rounds. Requires a local server given with --server.",
     NULL
     };
   return HelpPages;
@@ -269,6 +331,22 @@ cString cPluginElvis::SVDRPCommand(const char *commandP, const char *optionP, in
         ElvisConfig.SetTraceMode(strtol(optionP, NULL, 0));
      return cString::sprintf("Tracing mode: 0x%04X\n", ElvisConfig.GetTraceMode());
      }
+  else if (strcasecmp(commandP, "STAT") == 0) {
+     return cString::sprintf("%s\n%s\n%s\n%s\n%s\n%s", *cElvisTransport::GetInstance()->Statistics(), *cElvisWidget::GetInstance()->Statistics(), *cElvisInfoCache::GetInstance()->Statistics(),
+                             *cElvisStringPool::GetInstance()->Statistics(), *cElvisChannels::GetInstance()->Statistics(), *cElvisTopEvents::GetInstance()->Statistics());
+     }
+  else if (strcasecmp(commandP, "BENC") == 0) {
+     int channels = 200, days = 7;
+     if (optionP && *optionP)
+        sscanf(optionP, "%d %d", &channels, &days);
+     return cElvisChannels::Benchmark(channels, days);
+     }
+  else if (strcasecmp(commandP, "BENW") == 0) {
+     int rounds = 10;
+     if (optionP && *optionP)
+        rounds = atoi(optionP);
+     return cElvisWidget::GetInstance()->Benchmark(rounds);
+     }
 
   return NULL;
 }
@@ -15,5 +15,27 @@ struct ElvisService_Timer_v1_0 {
   tEventID eventId;
 };
 
+// a copy of an event, so it remains valid after the call
+struct ElvisService_Event_v1_0 : public cListObject {
+  int      eventId;
+  cString  channel;
+  cString  title;
+  time_t   startTime;
+  time_t   endTime;
+};
+
+struct ElvisService_Events_v1_0 {
+  enum {
+    eQueryNowNext = 0, // the running and the following event of each channel at startTime
+    eQueryWindow,      // the events overlapping startTime..endTime
+    eQueryFrom         // up to count events of each channel starting at or after startTime
+  };
+  int      query;
+  time_t   startTime;  // zero for the current time
+  time_t   endTime;
+  int      count;
+  cList<ElvisService_Event_v1_0> events; // filled in by the plugin
+};
+
 #endif //__ELVISSERVICE_H
 
@@ -7,61 +7,132 @@
 
 #include "common.h"
 #include "config.h"
+#include "info.h"
 #include "log.h"
 #include "timers.h"
 #include "events.h"
 
-cElvisEvent::cElvisEvent(int idP, const char *nameP, const char *simpleStartTimeP, const char *simpleEndTimeP, const char *startTimeP, const char *endTimeP, const char *descriptionP)
-: taggedM(true),
-  idM(idP),
-  nameM(nameP),
-  channelM(NULL),
-  simpleStartTimeM(simpleStartTimeP),
-  simpleEndTimeM(simpleEndTimeP),
-  startTimeM(startTimeP),
-  endTimeM(endTimeP),
-  descriptionM(descriptionP),
-  infoM(NULL),
-  startTimeValueM(strtotime(startTimeP)),
-  endTimeValueM(strtotime(endTimeM)),
-  lengthM(int(endTimeValueM - startTimeValueM) / 60)
+// --- cElvisChannelIds -----------------------------------------------
+
+cElvisChannelIds *cElvisChannelIds::instanceS = NULL;
+
+cElvisChannelIds *cElvisChannelIds::GetInstance()
 {
+  if (!instanceS)
+     instanceS = new cElvisChannelIds();
+
+  return instanceS;
 }
 
-cElvisEvent::cElvisEvent(int idP, const char *nameP, const char *channelP, const char *startTimeP, const char *endTimeP)
-: taggedM(true),
-  idM(idP),
-  nameM(nameP),
-  channelM(channelP),
-  simpleStartTimeM(NULL),
-  simpleEndTimeM(NULL),
+void cElvisChannelIds::Destroy()
+{
+  DELETE_POINTER(instanceS);
+}
+
+cElvisChannelIds::cElvisChannelIds()
+: namesM()
+{
+}
+
+cElvisChannelIds::~cElvisChannelIds()
+{
+}
+
+unsigned short cElvisChannelIds::Id(const char *nameP)
+{
+  cMutexLock MutexLock(&mutexM);
+  int id = namesM.Find(nameP ? nameP : "");
+
+  if (id < 0) {
+     namesM.Append(strdup(nameP ? nameP : ""));
+     id = namesM.Size() - 1;
+     }
+
+  return (unsigned short)id;
+}
+
+const char *cElvisChannelIds::Name(unsigned short idP)
+{
+  cMutexLock MutexLock(&mutexM);
+
+  return (idP < namesM.Size()) ? namesM[idP] : "";
+}
+
+// --- cElvisEvent -----------------------------------------------------
+
+cElvisEvent::cElvisEvent(cElvisStringArena &arenaP, int idP, const char *nameP, unsigned short channelP, time_t startTimeP, time_t endTimeP, const char *descriptionP)
+: infoM(NULL),
+  nameM(arenaP.Store(nameP ? nameP : "")),
+  descriptionM(arenaP.Store(descriptionP)),
   startTimeM(startTimeP),
   endTimeM(endTimeP),
-  descriptionM(NULL),
-  infoM(NULL),
-  startTimeValueM(strtotime(startTimeP)),
-  endTimeValueM(0),
-  lengthM(0)
+  idM(idP),
+  channelM(channelP),
+  taggedM(true)
 {
 }
 
 cElvisEvent::~cElvisEvent()
 {
-  DELETE_POINTER(infoM);
+  if (infoM) {
+     infoM->Release();
+     infoM = NULL;
+     }
 }
 
 cElvisWidgetEventInfo *cElvisEvent::Info()
 {
   if (!infoM)
-     infoM = cElvisWidget::GetInstance()->GetEventInfo(idM);
+     infoM = cElvisInfoCache::GetInstance()->GetEventInfo(idM);
 
   return infoM;
 }
 
+bool cElvisEvent::Update(cElvisEvent *eventP)
+{
+  bool dropped = (infoM != NULL);
+
+  nameM = eventP->nameM;
+  descriptionM = eventP->descriptionM;
+  startTimeM = eventP->startTimeM;
+  endTimeM = eventP->endTimeM;
+  channelM = eventP->channelM;
+  // the info describes the previous contents
+  if (infoM) {
+     infoM->Release();
+     infoM = NULL;
+     }
+
+  return dropped;
+}
+
+static inline bool strsame(const char *s1, const char *s2)
+{
+  return (s1 == s2) || (s1 && s2 && !strcmp(s1, s2));
+}
+
+bool cElvisEvent::Equals(cElvisEvent *eventP)
+{
+  return eventP && (idM == eventP->idM) && (startTimeM == eventP->startTimeM) && (endTimeM == eventP->endTimeM) && (channelM == eventP->channelM) &&
+         strsame(nameM, eventP->nameM) && strsame(descriptionM, eventP->descriptionM);
+}
+
+// --- cElvisEventLock -------------------------------------------------
+
+cElvisEventLock::cElvisEventLock()
+: channelsLockM(cElvisChannels::GetInstance()),
+  topEventsLockM(cElvisTopEvents::GetInstance())
+{
+}
+
 // --- cElvisChannel ---------------------------------------------------
 
 cElvisChannel::cElvisChannel(const char *nameP)
-: nameM(nameP)
+: nameM(nameP),
+  idM(cElvisChannelIds::GetInstance()->Id(nameP)),
+  lastUpdateM(0),
+  arenaM(eArenaChunkSize),
+  timeIndexM()
 {
 }
 
@@ -69,29 +140,169 @@ cElvisChannel::~cElvisChannel()
 {
 }
 
-void cElvisChannel::AddEvent(int idP, const char *nameP, const char *simpleStartTimeP, const char *simpleEndTimeP, const char *startTimeP, const char *endTimeP, const char *descriptionP)
+void cElvisChannel::Clear()
 {
-  Add(new cElvisEvent(idP, nameP, simpleStartTimeP, simpleEndTimeP, startTimeP, endTimeP, descriptionP));
+  timeIndexM.Clear();
+  cList<cElvisEvent>::Clear();
 }
 
-cElvisEvent *cElvisChannel::GetEvent(int idP)
+void cElvisChannel::AddEvent(int idP, const char *nameP, const char *simpleStartTimeP, const char *simpleEndTimeP, const char *startTimeP, const char *endTimeP)
+{
+  // the simple times are redundant with the parsed ones
+  AddEvent(idP, nameP, strtotime(startTimeP), strtotime(endTimeP), NULL);
+}
+
+cElvisEvent *cElvisChannel::AddEvent(int idP, const char *nameP, time_t startTimeP, time_t endTimeP, const char *descriptionP)
+{
+  cElvisEvent *event = new cElvisEvent(arenaM, idP, nameP, idM, startTimeP, endTimeP, descriptionP);
+  int i = timeIndexM.Size();
+
+  // the events arrive mostly in order, so the insertion point is searched backwards
+  while ((i > 0) && (timeIndexM[i - 1]->StartTimeValue() > event->StartTimeValue()))
+        --i;
+  if (i < timeIndexM.Size()) {
+     cList<cElvisEvent>::Ins(event, timeIndexM[i]);
+     timeIndexM.Insert(event, i);
+     }
+  else {
+     cList<cElvisEvent>::Add(event);
+     timeIndexM.Append(event);
+     }
+
+  return event;
+}
+
+int cElvisChannel::Lookup(time_t timeP)
+{
+  // returns the index of the last event starting at or before the given time
+  int lo = 0, hi = timeIndexM.Size();
+
+  while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (timeIndexM[mid]->StartTimeValue() <= timeP)
+           lo = mid + 1;
+        else
+           hi = mid;
+        }
+
+  return lo - 1;
+}
+
+cElvisEvent *cElvisChannel::Match(cElvisEvent *eventP)
 {
-  for (cElvisEvent *i = cList<cElvisEvent>::First(); i; i = cList<cElvisEvent>::Next(i)) {
-      if (i->Id() == idP)
-         return i;
+  // an equal event starts at the same time, so only those are compared
+  for (int i = Lookup(eventP->StartTimeValue()); (i >= 0) && (timeIndexM[i]->StartTimeValue() == eventP->StartTimeValue()); --i) {
+      if (!timeIndexM[i]->IsTagged() && timeIndexM[i]->Equals(eventP))
+         return timeIndexM[i];
       }
 
   return NULL;
 }
 
+bool cElvisChannel::Merge(cElvisChannel *channelP)
+{
+  // the events of the new generation replace the current ones, but the unchanged ones are kept along with their info
+  bool changed = (channelP->cList<cElvisEvent>::Count() != cList<cElvisEvent>::Count());
+
+  for (cElvisEvent *i = cList<cElvisEvent>::First(); i; i = cList<cElvisEvent>::Next(i))
+      i->Tag(false);
+  for (cElvisEvent *i = channelP->cList<cElvisEvent>::First(); i; ) {
+      cElvisEvent *next = channelP->cList<cElvisEvent>::Next(i);
+      cElvisEvent *old = Match(i);
+      if (old) {
+         old->Tag(true);
+         old->Adopt(i);
+         cList<cElvisEvent>::Del(old, false);
+         channelP->cList<cElvisEvent>::Ins(old, i);
+         channelP->cList<cElvisEvent>::Del(i);
+         }
+      else
+         changed = true;
+      i = next;
+      }
+  // the remaining events have been dropped or replaced
+  Clear();
+  while (cElvisEvent *i = channelP->cList<cElvisEvent>::First()) {
+        channelP->cList<cElvisEvent>::Del(i, false);
+        cList<cElvisEvent>::Add(i);
+        timeIndexM.Append(i);
+        }
+  channelP->Clear();
+  // every event refers to the strings of the new generation now
+  arenaM.Swap(channelP->arenaM);
+
+  return changed;
+}
+
+cElvisEvent *cElvisChannel::GetEvent(int idP)
+{
+  cElvisEvent *event = cElvisChannels::GetInstance()->GetEvent(idP);
+
+  if (event && !strcmp(event->Channel(), *nameM))
+     return event;
+
+  return NULL;
+}
+
+cElvisEvent *cElvisChannel::GetEventAt(time_t timeP)
+{
+  int i = Lookup(timeP);
+
+  if ((i >= 0) && (timeIndexM[i]->EndTimeValue() > timeP))
+     return timeIndexM[i];
+
+  return NULL;
+}
+
+cElvisEvent *cElvisChannel::GetEventAfter(time_t timeP)
+{
+  int i = Lookup(timeP) + 1;
+
+  if (i < timeIndexM.Size())
+     return timeIndexM[i];
+
+  return NULL;
+}
+
+int cElvisChannel::GetEvents(time_t startTimeP, time_t endTimeP, cVector<cElvisEvent *> &eventsP)
+{
+  // the event running at the start of the window is the first candidate
+  int count = 0;
+
+  for (int i = max(Lookup(startTimeP), 0); (i < timeIndexM.Size()) && (timeIndexM[i]->StartTimeValue() < endTimeP); ++i) {
+      if (timeIndexM[i]->EndTimeValue() > startTimeP) {
+         eventsP.Append(timeIndexM[i]);
+         ++count;
+         }
+      }
+
+  return count;
+}
+
+int cElvisChannel::GetEventsFrom(time_t timeP, int countP, cVector<cElvisEvent *> &eventsP)
+{
+  int count = 0;
+  int i = Lookup(timeP);
+
+  // skip the one started before the given time
+  if ((i < 0) || (timeIndexM[i]->StartTimeValue() < timeP))
+     ++i;
+  for (; (i < timeIndexM.Size()) && (count < countP); ++i, ++count)
+      eventsP.Append(timeIndexM[i]);
+
+  return count;
+}
+
 // --- cElvisChannels --------------------------------------------------
 
 cElvisChannels *cElvisChannels::instanceS = NULL;
 
 cElvisChannels *cElvisChannels::GetInstance()
 {
-  if (!instanceS)
+  if (!instanceS) {
      instanceS = new cElvisChannels();
+     instanceS->Restore();
+     }
 
   return instanceS;
 }
@@ -104,7 +315,18 @@ void cElvisChannels::Destroy()
 cElvisChannels::cElvisChannels()
 : cThread("cElvisChannels"),
   stateM(0),
-  lastUpdateM(0)
+  lastUpdateM(0),
+  refreshedM(false),
+  lazyM(ElvisConfig.GetLazyEPG()),
+  channelListM(this),
+  loadsM(0),
+  prefetchesM(0),
+  loadMsM(0),
+  channelHashM(),
+  eventHashM(eEventHashSize),
+  slotHashM(eEventHashSize),
+  stagingM(),
+  stagingHashM()
 {
 }
 
@@ -112,36 +334,280 @@ cElvisChannels::~cElvisChannels()
 {
   LOCK_THREAD;
   Cancel(3);
+  channelHashM.Clear();
+  eventHashM.Clear();
+  slotHashM.Clear();
+  stagingHashM.Clear();
 }
 
-void cElvisChannels::AddEvent(const char *channelP, int idP, const char *nameP, const char *simpleStartTimeP, const char *simpleEndTimeP, const char *startTimeP, const char *endTimeP, const char *descriptionP)
+void cElvisChannels::Clear()
 {
-  cElvisChannel *channel = NULL;
   LOCK_THREAD;
-  for (cElvisChannel *c = First(); c; c = Next(c)) {
-      if (!strcmp(c->Name(), channelP)) {
-         channel = c;
-         break;
+  channelHashM.Clear();
+  eventHashM.Clear();
+  slotHashM.Clear();
+  cList<cElvisChannel>::Clear();
+}
+
+cElvisChannel *cElvisChannels::Find(cList<cElvisChannel> &listP, cHash<cElvisChannel> &hashP, const char *nameP)
+{
+  cElvisChannel *channel = hashP.Get(cElvisStringPool::Hash(nameP));
+
+  if (channel && !strcmp(channel->Name(), nameP))
+     return channel;
+  // a colliding name is not indexed
+  if (channel) {
+     for (cElvisChannel *c = listP.First(); c; c = listP.Next(c)) {
+         if (!strcmp(c->Name(), nameP))
+            return c;
          }
+     }
+
+  return NULL;
+}
+
+void cElvisChannels::Index(cElvisChannel *channelP)
+{
+  // called with the thread lock held
+  unsigned int hash = cElvisStringPool::Hash(channelP->Name());
+
+  if (!channelHashM.Get(hash))
+     channelHashM.Add(channelP, hash);
+  for (cElvisEvent *i = channelP->cList<cElvisEvent>::First(); i; i = channelP->cList<cElvisEvent>::Next(i)) {
+      if (!eventHashM.Get(i->Id()))
+         eventHashM.Add(i, i->Id());
+      slotHashM.Add(i, SlotKey(channelP->Name(), i->StartTimeValue()));
+      }
+}
+
+void cElvisChannels::Unindex(cElvisChannel *channelP)
+{
+  // called with the thread lock held; the channel itself remains indexed
+  for (cElvisEvent *i = channelP->cList<cElvisEvent>::First(); i; i = channelP->cList<cElvisEvent>::Next(i)) {
+      eventHashM.Del(i, i->Id());
+      slotHashM.Del(i, SlotKey(channelP->Name(), i->StartTimeValue()));
+      }
+}
+
+bool cElvisChannels::Merge(bool channelsOnlyP)
+{
+  // called with the thread lock held; publishes the new generation built by AddEvent() or AddChannel()
+  cList<cElvisChannel> channels;
+  bool changed = (stagingM.Count() != Count());
+
+  while (cElvisChannel *c = stagingM.First()) {
+        cElvisChannel *old = Find(*this, channelHashM, c->Name());
+        stagingM.Del(c, false);
+        // keep the channel objects, as the menus refer to them
+        if (old) {
+           if (!channelsOnlyP) {
+              if (old->Merge(c))
+                 changed = true;
+              old->lastUpdateM = c->lastUpdateM;
+              }
+           Del(old, false);
+           delete c;
+           c = old;
+           }
+        else
+           changed = true;
+        channels.Add(c);
+        }
+  stagingHashM.Clear();
+  // the channels left behind are missing from the new generation
+  if (Count() > 0)
+     changed = true;
+  Clear();
+  while (cElvisChannel *c = channels.First()) {
+        channels.Del(c, false);
+        Add(c);
+        Index(c);
+        }
+  debug3("%s channels=%d changed=%d", __PRETTY_FUNCTION__, Count(), changed);
+
+  return changed;
+}
+
+cElvisChannel *cElvisChannels::GetChannel(const char *nameP)
+{
+  LOCK_THREAD;
+  return Find(*this, channelHashM, nameP);
+}
+
+cElvisEvent *cElvisChannels::GetEvent(int idP)
+{
+  LOCK_THREAD;
+  return eventHashM.Get(idP);
+}
+
+void cElvisChannels::GetNowNext(time_t timeP, cVector<cElvisEvent *> &nowP, cVector<cElvisEvent *> &nextP)
+{
+  LOCK_THREAD;
+  for (cElvisChannel *c = First(); c; c = Next(c)) {
+      nowP.Append(c->GetEventAt(timeP));
+      nextP.Append(c->GetEventAfter(timeP));
       }
+}
+
+int cElvisChannels::GetEvents(time_t startTimeP, time_t endTimeP, cVector<cElvisEvent *> &eventsP)
+{
+  LOCK_THREAD;
+  int count = 0;
+
+  for (cElvisChannel *c = First(); c; c = Next(c))
+      count += c->GetEvents(startTimeP, endTimeP, eventsP);
+
+  return count;
+}
+
+int cElvisChannels::GetEventsFrom(time_t timeP, int countP, cVector<cElvisEvent *> &eventsP)
+{
+  LOCK_THREAD;
+  int count = 0;
+
+  for (cElvisChannel *c = First(); c; c = Next(c))
+      count += c->GetEventsFrom(timeP, countP, eventsP);
+
+  return count;
+}
+
+cElvisChannel *cElvisChannels::Stage(const char *channelP)
+{
+  // the staging area is private to the refresh in progress, so the live data remains untouched
+  cElvisChannel *channel = Find(stagingM, stagingHashM, channelP);
+
   if (!channel) {
+     unsigned int hash = cElvisStringPool::Hash(channelP);
      channel = new cElvisChannel(channelP);
-     Add(channel);
+     if (!stagingHashM.Get(hash))
+        stagingHashM.Add(channel, hash);
+     stagingM.Add(channel);
      }
-  if (channel)
-     channel->AddEvent(idP, nameP, simpleStartTimeP, simpleEndTimeP, startTimeP, endTimeP, descriptionP);
-  ChangeState();
+
+  return channel;
+}
+
+void cElvisChannels::AddEvent(const char *channelP, int idP, const char *nameP, const char *simpleStartTimeP, const char *simpleEndTimeP, const char *startTimeP, const char *endTimeP, const char *descriptionP)
+{
+  // the simple times are redundant with the parsed ones
+  Stage(channelP)->AddEvent(idP, nameP, strtotime(startTimeP), strtotime(endTimeP), descriptionP);
+}
+
+void cElvisChannels::Restore()
+{
+  cElvisSnapshot *snapshot = cElvisSnapshot::GetInstance();
+  int count = snapshot->Count(cElvisSnapshot::esEPG);
+
+  if (count > 0) {
+     cMutexLock MutexLock(&refreshMutexM);
+     time_t now = time(NULL);
+     for (int i = 0; i < count; ++i) {
+         const cElvisSnapshot::cRecord *r = snapshot->Record(cElvisSnapshot::esEPG, i);
+         const char *channel = snapshot->String(r->strings[0]);
+         // the events ended since the snapshot was taken are of no use anymore
+         if (channel && (r->end > now))
+            Stage(channel)->AddEvent(r->id, snapshot->String(r->strings[1]), (time_t)r->start, (time_t)r->end, snapshot->String(r->strings[2]));
+         }
+     {
+       LOCK_THREAD;
+       if (Merge())
+          ChangeState();
+     }
+     stagingHashM.Clear();
+     stagingM.Clear();
+     debug1("%s Restored %d events", __PRETTY_FUNCTION__, count);
+     }
+}
+
+void cElvisChannels::Snapshot(cElvisSnapshot::cWriter &writerP)
+{
+  LOCK_THREAD;
+  for (cElvisChannel *c = First(); c; c = Next(c)) {
+      for (cElvisEvent *i = c->cList<cElvisEvent>::First(); i; i = c->cList<cElvisEvent>::Next(i)) {
+          cElvisSnapshot::cRecord *r = writerP.Append(cElvisSnapshot::esEPG);
+          if (!r)
+             return;
+          r->id = i->Id();
+          r->start = i->StartTimeValue();
+          r->end = i->EndTimeValue();
+          r->strings[0] = writerP.String(c->Name());
+          r->strings[1] = writerP.String(i->Name());
+          r->strings[2] = writerP.String(i->Description());
+          }
+      }
 }
 
 void cElvisChannels::Refresh(bool foregroundP)
 {
+  cMutexLock MutexLock(&refreshMutexM);
+
   lastUpdateM = time(NULL);
+  // a changed mode starts over with a complete reply
+  if (lazyM != ElvisConfig.GetLazyEPG()) {
+     lazyM = ElvisConfig.GetLazyEPG();
+     foregroundP = true;
+     }
+  if (lazyM) {
+     // only the channel list is loaded up front and the events when a channel is browsed
+     if (foregroundP)
+        channelListM.Validate(false);
+     bool result = cElvisWidget::GetInstance()->GetChannels(channelListM);
+     LOCK_THREAD;
+     if (result && channelListM.IsValid())
+        refreshedM = true;
+     if (result && channelListM.IsValid() && !channelListM.IsNotModified() && Merge(true))
+        ChangeState();
+     }
+  else {
+     // parse the reply even if it hasn't been modified
+     if (foregroundP)
+        Validate(false);
+     bool result = cElvisWidget::GetInstance()->GetEPG(*this);
+     for (cElvisChannel *c = stagingM.First(); c; c = stagingM.Next(c))
+         c->lastUpdateM = lastUpdateM;
+     LOCK_THREAD;
+     if (result && IsValid())
+        refreshedM = true;
+     if (result && IsValid() && !IsNotModified() && Merge())
+        ChangeState();
+     }
+  stagingHashM.Clear();
+  stagingM.Clear();
+}
+
+bool cElvisChannels::Load(const char *channelP)
+{
+  cElvisChannel *staging = new cElvisChannel(channelP);
+  cTimeMs timer;
+
+  {
+    LOCK_THREAD;
+    cElvisChannel *channel = Find(*this, channelHashM, channelP);
+    // nothing needs to be parsed, if the reply hasn't changed since the last load
+    staging->Validate(channel && channel->IsLoaded());
+  }
+  bool result = cElvisWidget::GetInstance()->GetEvents(*staging, channelP);
   {
     LOCK_THREAD;
-    Clear();
-    ChangeState();
+    cElvisChannel *channel = Find(*this, channelHashM, channelP);
+    if (result && channel) {
+       if (staging->IsValid() && !staging->IsNotModified()) {
+          // only the entries of this channel are replaced, as the merge deletes its dropped events
+          Unindex(channel);
+          bool changed = channel->Merge(staging);
+          Index(channel);
+          if (changed)
+             ChangeState();
+          }
+       channel->lastUpdateM = time(NULL);
+       }
+    ++loadsM;
+    loadMsM += timer.Elapsed();
   }
-  cElvisWidget::GetInstance()->GetEPG(*this);
+  delete staging;
+  debug1("%s (%s) result=%d elapsed=%llums", __PRETTY_FUNCTION__, channelP, result, (unsigned long long)timer.Elapsed());
+
+  return result;
 }
 
 bool cElvisChannels::Update(bool waitP)
@@ -156,6 +622,41 @@ bool cElvisChannels::Update(bool waitP)
   return false;
 }
 
+bool cElvisChannels::Update(cElvisChannel *channelP, bool waitP)
+{
+  cString name;
+  bool missing;
+
+  if (!lazyM || !channelP)
+     return true;
+  {
+    LOCK_THREAD;
+    name = channelP->Name();
+    missing = !channelP->IsLoaded() && !channelP->cList<cElvisEvent>::Count();
+  }
+  if (missing && waitP)
+     return Load(*name);
+  Prefetch(channelP);
+
+  return !missing;
+}
+
+void cElvisChannels::Prefetch(cElvisChannel *channelP)
+{
+  if (!lazyM || !channelP)
+     return;
+  {
+    LOCK_THREAD;
+    if ((time(NULL) - channelP->lastUpdateM) < eEventUpdateInterval)
+       return;
+    cMutexLock MutexLock(&queueMutexM);
+    if (queueM.Find(channelP->Name()) >= 0)
+       return;
+    queueM.Append(strdup(channelP->Name()));
+  }
+  Start();
+}
+
 bool cElvisChannels::StateChanged(int &stateP)
 {
   LOCK_THREAD;
@@ -166,45 +667,211 @@ bool cElvisChannels::StateChanged(int &stateP)
   return result;
 }
 
-void cElvisChannels::Action()
+cString cElvisChannels::Statistics()
 {
-  Refresh();
+  LOCK_THREAD;
+  int events = 0, loaded = 0;
+  size_t bytes = 0, reserved = 0;
+
+  for (cElvisChannel *c = First(); c; c = Next(c)) {
+      events += c->cList<cElvisEvent>::Count();
+      bytes += c->arenaM.Bytes();
+      reserved += c->arenaM.Reserved();
+      if (c->IsLoaded())
+         ++loaded;
+      }
+  cMutexLock MutexLock(&queueMutexM);
+
+  return cString::sprintf("EPG: mode=%s channels=%d loaded=%d events=%d records=%zu strings=%zu/%zu loads=%lu prefetched=%lu queued=%d load=%llums", lazyM ? "lazy" : "full",
+                          Count(), loaded, events, events * sizeof(cElvisEvent), bytes, reserved, loadsM, prefetchesM, queueM.Size(), loadsM ? (unsigned long long)(loadMsM / loadsM) : 0ULL);
 }
 
-bool cElvisChannels::AddTimer(tEventID eventIdP)
+cString cElvisChannels::Benchmark(int channelsP, int daysP)
 {
-  const cEvent *event = NULL;
-  const cChannel *channel = NULL;
-  debug7("%s (%d)", __PRETTY_FUNCTION__, eventIdP);
-  LOCK_CHANNELS_READ;
-  LOCK_SCHEDULES_WRITE;
-  for (const cSchedule *s = Schedules->First(); s; s = Schedules->Next(s)) {
-      for (const cEvent *e = s->Events()->First(); e; e = s->Events()->Next(e)) {
-          if (e->EventID() == eventIdP) {
-             channel = Channels->GetByChannelID(e->ChannelID(), true);
-             event = e;
-             info("%s (%d) Found event='%s' channel='%s'", __PRETTY_FUNCTION__, e->EventID(), e->Title(), channel->Name());
+  // a private instance, so the live data remains untouched; only the channel ids are shared
+  static const char *titlesS[] = { "Uutiset", "Elokuva", "Urheilu", "Sää", "Dokumentti", "Sarja" };
+  enum { eEventLength = 1800, eLookups = 1000000, eQueries = 1000 };
+  cElvisChannels channels;
+  cStringList names;
+  cVector<cElvisEvent *> events(KILOBYTE(16));
+  time_t start = time(NULL) / SECSINDAY * SECSINDAY;
+  int perChannel = daysP * SECSINDAY / eEventLength;
+  int count = channelsP * perChannel;
+  unsigned int found = 0;
+
+  if ((channelsP <= 0) || (channelsP > 1000) || (daysP <= 0) || (daysP > 31))
+     return "Invalid parameters";
+  for (int c = 0; c < channelsP; ++c)
+      names.Append(strdup(*cString::sprintf("Benchmark %03d", c)));
+  LOCK_THREAD_INSTANCE(&channels);
+  cTimeMs timer;
+  for (int c = 0; c < channelsP; ++c) {
+      cElvisChannel *channel = channels.Stage(names[c]);
+      for (int i = 0; i < perChannel; ++i)
+          channel->AddEvent(c * perChannel + i + 1, titlesS[i % 6], start + i * eEventLength, start + (i + 1) * eEventLength, NULL);
+      }
+  uint64_t stageMs = timer.Elapsed();
+  timer.Set();
+  channels.Merge();
+  uint64_t mergeMs = timer.Elapsed();
+
+  // a refresh with unchanged contents keeps every event
+  for (int c = 0; c < channelsP; ++c) {
+      cElvisChannel *channel = channels.Stage(names[c]);
+      for (int i = 0; i < perChannel; ++i)
+          channel->AddEvent(c * perChannel + i + 1, titlesS[i % 6], start + i * eEventLength, start + (i + 1) * eEventLength, NULL);
+      }
+  timer.Set();
+  channels.Merge();
+  uint64_t remergeMs = timer.Elapsed();
+
+  timer.Set();
+  for (unsigned int i = 0; i < eLookups; ++i) {
+      if (channels.eventHashM.Get((int)((i * 2654435761U) % count) + 1))
+         ++found;
+      }
+  uint64_t idMs = timer.Elapsed();
+
+  timer.Set();
+  for (unsigned int i = 0; i < eLookups; ++i) {
+      if (Find(channels, channels.channelHashM, names[i % channelsP]))
+         ++found;
+      }
+  uint64_t channelMs = timer.Elapsed();
+
+  timer.Set();
+  for (unsigned int i = 0; i < eLookups; ++i) {
+      unsigned int n = (i * 2654435761U) % count;
+      if (channels.FindEvent(names[n / perChannel], titlesS[(n % perChannel) % 6], start + (n % perChannel) * eEventLength + 59))
+         ++found;
+      }
+  uint64_t slotMs = timer.Elapsed();
+
+  timer.Set();
+  for (int i = 0; i < eQueries; ++i) {
+      cVector<cElvisEvent *> now(channelsP), next(channelsP);
+      channels.GetNowNext(start + (time_t)(i * 2654435761U % (daysP * SECSINDAY)), now, next);
+      }
+  uint64_t nowNextMs = timer.Elapsed();
+
+  timer.Set();
+  for (int i = 0; i < eQueries; ++i) {
+      time_t t = start + (time_t)(i * 2654435761U % (daysP * SECSINDAY));
+      events.Clear();
+      channels.GetEvents(t, t + 3 * 3600, events);
+      }
+  uint64_t windowMs = timer.Elapsed();
+
+  return cString::sprintf("Benchmark: channels=%d days=%d events=%d found=%u\n"
+                          "stage=%llums merge=%llums remerge=%llums\n"
+                          "per %d lookups: id=%llums channel=%llums slot=%llums\n"
+                          "per %d queries: nownext=%llums window(3h)=%llums",
+                          channelsP, daysP, count, found,
+                          (unsigned long long)stageMs, (unsigned long long)mergeMs, (unsigned long long)remergeMs,
+                          eLookups, (unsigned long long)idMs, (unsigned long long)channelMs, (unsigned long long)slotMs,
+                          eQueries, (unsigned long long)nowNextMs, (unsigned long long)windowMs);
+}
+
+void cElvisChannels::Action()
+{
+  // periodic updates must not delay the requests made by the user
+  cElvisWidgetPriority priority(cElvisWidgetPriority::epBackground);
+
+  if ((time(NULL) - lastUpdateM) >= eUpdateInterval)
+     Refresh();
+
+  // then the channels queued by the menus
+  cElvisWidgetPriority prefetch(cElvisWidgetPriority::epPrefetch);
+  while (Running()) {
+        cString channel;
+        {
+          cMutexLock MutexLock(&queueMutexM);
+          if (queueM.Size() == 0) {
+             // the thread is still running until it returns, so a later Start() would be ignored, unless
+             // it's marked as ending already: then Start() waits for it to end and starts it anew
+             Cancel(-1);
              break;
              }
-          }
-      if (event && channel)
-         break;
+          channel = queueM[0];
+          free(queueM[0]);
+          queueM.Remove(0);
+          ++prefetchesM;
+        }
+        Load(*channel);
+        }
+}
+
+unsigned int cElvisChannels::SlotKey(const char *channelP, time_t startTimeP)
+{
+  return cElvisStringPool::Hash(channelP) ^ ((unsigned int)(startTimeP / eSlotLength) * 2654435761U);
+}
+
+cElvisEvent *cElvisChannels::FindEvent(const char *channelP, const char *titleP, time_t startTimeP)
+{
+  // called with the thread lock held; the neighbouring slots cover the allowed difference in start time
+  for (int i = -1; i <= 1; ++i) {
+      cList<cHashObject> *list = slotHashM.GetList(SlotKey(channelP, startTimeP + i * eSlotLength));
+      if (list) {
+         for (cHashObject *o = list->First(); o; o = list->Next(o)) {
+             cElvisEvent *e = (cElvisEvent *)o->Object();
+             if ((abs((int)(startTimeP - e->StartTimeValue())) < eSlotLength) && !strcmp(e->Channel(), channelP) && !strcmp(e->Name(), titleP))
+                return e;
+             }
+         }
       }
-  if (event && channel) {
+
+  return NULL;
+}
+
+int cElvisChannels::Resolve(tEventID eventIdP)
+{
+  cString channel, title;
+  time_t startTime = 0;
+
+  // only the schedules of each channel are looked up and nothing is modified, so a read lock suffices
+  {
+    LOCK_CHANNELS_READ;
+    LOCK_SCHEDULES_READ;
+    for (const cSchedule *s = Schedules->First(); s; s = Schedules->Next(s)) {
+        const cEvent *e = s->GetEventById(eventIdP);
+        if (e) {
+           const cChannel *c = Channels->GetByChannelID(e->ChannelID(), true);
+           if (c) {
+              info("%s (%d) Found event='%s' channel='%s'", __PRETTY_FUNCTION__, e->EventID(), e->Title(), c->Name());
+              channel = c->Name();
+              title = e->Title() ? e->Title() : "";
+              startTime = e->StartTime();
+              break;
+              }
+           }
+        }
+  }
+  if (*channel) {
      if ((time(NULL) - lastUpdateM) >= eUpdateInterval)
         Update(true);
+     // in the on demand mode the events of the channel may not have been loaded yet
+     if (lazyM) {
+        cElvisChannel *c = GetChannel(*channel);
+        if (c && ((time(NULL) - c->lastUpdateM) >= eEventUpdateInterval))
+           Load(*channel);
+        }
      LOCK_THREAD;
-     for (cElvisChannel *c = First(); c; c = Next(c)) {
-         if (!strcmp(c->Name(), channel->Name())) {
-            for (cElvisEvent *i = c->cList<cElvisEvent>::First(); i; i = c->cList<cElvisEvent>::Next(i)) {
-                if (!strcmp(event->Title(), i->Name()) && (abs((int)(event->StartTime() - i->StartTimeValue())) < 60)) {
-                   info("%s (%d) Creating id=%d", __PRETTY_FUNCTION__, event->EventID(), i->Id());
-                   return cElvisTimers::GetInstance()->Create(i->Id());
-                   }
-                }
-            break;
-            }
-         }
+     cElvisEvent *event = FindEvent(*channel, *title, startTime);
+     if (event)
+        return event->Id();
+     }
+
+  return 0;
+}
+
+bool cElvisChannels::AddTimer(tEventID eventIdP)
+{
+  debug7("%s (%d)", __PRETTY_FUNCTION__, eventIdP);
+  int id = Resolve(eventIdP);
+
+  if (id > 0) {
+     info("%s (%d) Creating id=%d", __PRETTY_FUNCTION__, eventIdP, id);
+     return cElvisTimers::GetInstance()->Create(id);
      }
 
   return false;
@@ -212,38 +879,12 @@ bool cElvisChannels::AddTimer(tEventID eventIdP)
 
 bool cElvisChannels::DelTimer(tEventID eventIdP)
 {
-  const cEvent *event = NULL;
-  const cChannel *channel = NULL;
   debug7("%s (%d)", __PRETTY_FUNCTION__, eventIdP);
-  LOCK_CHANNELS_READ;
-  LOCK_SCHEDULES_WRITE;
-  for (cSchedule *s = Schedules->First(); s; s = Schedules->Next(s)) {
-      for (const cEvent *e = s->Events()->First(); e; e = s->Events()->Next(e)) {
-          if (e->EventID() == eventIdP) {
-             channel = Channels->GetByChannelID(e->ChannelID(), true);
-             event = e;
-             info("%s (%d) Found event '%s' on '%s'", __PRETTY_FUNCTION__, e->EventID(), e->Title(), channel->Name());
-             break;
-             }
-          }
-      if (event && channel)
-         break;
-      }
-  if (event && channel) {
-     if ((time(NULL) - lastUpdateM) >= eUpdateInterval)
-        Update(true);
-     LOCK_THREAD;
-     for (cElvisChannel *c = First(); c; c = Next(c)) {
-         if (!strcmp(c->Name(), channel->Name())) {
-            for (cElvisEvent *i = c->cList<cElvisEvent>::First(); i; i = c->cList<cElvisEvent>::Next(i)) {
-                if (!strcmp(event->Title(), i->Name()) && (abs((int)(event->StartTime() - i->StartTimeValue())) < 60)) {
-                   info("%s (%d) Deleting %d", __PRETTY_FUNCTION__, event->EventID(), i->Id());
-                   return cElvisTimers::GetInstance()->Delete(i->Id());
-                   }
-                }
-            break;
-            }
-         }
+  int id = Resolve(eventIdP);
+
+  if (id > 0) {
+     info("%s (%d) Deleting %d", __PRETTY_FUNCTION__, eventIdP, id);
+     return cElvisTimers::GetInstance()->Delete(id);
      }
 
   return false;
@@ -255,8 +896,10 @@ cElvisTopEvents *cElvisTopEvents::instanceS = NULL;
 
 cElvisTopEvents *cElvisTopEvents::GetInstance()
 {
-  if (!instanceS)
+  if (!instanceS) {
      instanceS = new cElvisTopEvents();
+     instanceS->Restore();
+     }
 
   return instanceS;
 }
@@ -267,9 +910,18 @@ void cElvisTopEvents::Destroy()
 }
 
 cElvisTopEvents::cElvisTopEvents()
-: cThread("cElvisTimers"),
+: cThread("cElvisTopEvents"),
   stateM(0),
-  lastUpdateM(0)
+  lastUpdateM(0),
+  refreshedM(false),
+  eventHashM(eEventHashSize),
+  refreshesM(0),
+  changesM(0),
+  rebuildsM(0),
+  infoDropsM(0),
+  stagingM(),
+  arenaM(),
+  stagingArenaM()
 {
 }
 
@@ -277,53 +929,127 @@ cElvisTopEvents::~cElvisTopEvents()
 {
   LOCK_THREAD;
   Cancel(3);
+  eventHashM.Clear();
 }
 
 void cElvisTopEvents::AddEvent(int idP, const char *nameP, const char *channelP, const char *startTimeP, const char *endTimeP)
+{
+  // the staging area is private to the refresh in progress, so the live data remains untouched
+  stagingM.Add(new cElvisEvent(stagingArenaM, idP, nameP, cElvisChannelIds::GetInstance()->Id(channelP), strtotime(startTimeP), strtotime(endTimeP)));
+}
+
+void cElvisTopEvents::Restore()
+{
+  cElvisSnapshot *snapshot = cElvisSnapshot::GetInstance();
+  int count = snapshot->Count(cElvisSnapshot::esTopEvents);
+
+  if (count > 0) {
+     cMutexLock MutexLock(&refreshMutexM);
+     time_t now = time(NULL);
+     for (int i = 0; i < count; ++i) {
+         const cElvisSnapshot::cRecord *r = snapshot->Record(cElvisSnapshot::esTopEvents, i);
+         if (r->end <= now)
+            continue;
+         stagingM.Add(new cElvisEvent(stagingArenaM, r->id, snapshot->String(r->strings[1]), cElvisChannelIds::GetInstance()->Id(snapshot->String(r->strings[0])), (time_t)r->start, (time_t)r->end));
+         }
+     {
+       LOCK_THREAD;
+       if (Merge())
+          ChangeState();
+     }
+     stagingM.Clear();
+     stagingArenaM.Clear();
+     debug1("%s Restored %d events", __PRETTY_FUNCTION__, count);
+     }
+}
+
+void cElvisTopEvents::Snapshot(cElvisSnapshot::cWriter &writerP)
 {
   LOCK_THREAD;
-  //cElvisEvent *event = GetEvent(idP);
-  //if (event)
-  //   event->Tag(true);
-  //else {
-     Add(new cElvisEvent(idP, nameP, channelP, startTimeP, endTimeP));
-     ChangeState();
-  //   }
+  for (cElvisEvent *i = First(); i; i = Next(i)) {
+      cElvisSnapshot::cRecord *r = writerP.Append(cElvisSnapshot::esTopEvents);
+      if (!r)
+         return;
+      r->id = i->Id();
+      r->start = i->StartTimeValue();
+      r->end = i->EndTimeValue();
+      r->strings[0] = writerP.String(i->Channel());
+      r->strings[1] = writerP.String(i->Name());
+      }
 }
 
 cElvisEvent *cElvisTopEvents::GetEvent(int idP)
 {
-  for (cElvisEvent *i = First(); i; i = Next(i)) {
-      if (i->Id() == idP)
-         return i;
+  return eventHashM.Get(idP);
+}
+
+bool cElvisTopEvents::Merge()
+{
+  // called with the thread lock held; the ranking counts as content, so the order is compared as well
+  bool changed = (stagingM.Count() != Count());
+
+  for (cElvisEvent *i = First(), *j = stagingM.First(); !changed && i && j; i = Next(i), j = stagingM.Next(j)) {
+      if (i->Id() != j->Id())
+         changed = true;
       }
+  for (cElvisEvent *i = First(); i; i = Next(i))
+      i->Tag(false);
+  for (cElvisEvent *i = stagingM.First(); i; ) {
+      cElvisEvent *next = stagingM.Next(i);
+      cElvisEvent *old = GetEvent(i->Id());
+      // keep the entries known by id, so the menus and the unchanged info remain valid
+      if (old && !old->IsTagged()) {
+         old->Tag(true);
+         if (old->Equals(i))
+            old->Adopt(i);
+         else {
+            if (old->Update(i))
+               ++infoDropsM;
+            changed = true;
+            }
+         Del(old, false);
+         stagingM.Ins(old, i);
+         stagingM.Del(i);
+         }
+      else
+         changed = true;
+      i = next;
+      }
+  // the untagged ones have dropped out of the list
+  eventHashM.Clear();
+  Clear();
+  while (cElvisEvent *i = stagingM.First()) {
+        stagingM.Del(i, false);
+        Add(i);
+        eventHashM.Add(i, i->Id());
+        }
+  // every live event refers to the strings of the new generation now
+  arenaM.Swap(stagingArenaM);
+  ++refreshesM;
+  if (changed)
+     ++changesM;
 
-  return NULL;
+  return changed;
 }
 
 void cElvisTopEvents::Refresh(bool foregroundP)
 {
+  cMutexLock MutexLock(&refreshMutexM);
+
   lastUpdateM = time(NULL);
+  // parse the reply even if it hasn't been modified
+  if (foregroundP)
+     Validate(false);
+  bool result = cElvisWidget::GetInstance()->GetTopEvents(*this);
   {
     LOCK_THREAD;
-    //if (foregroundP) {
-       Clear();
+    if (result && IsValid())
+       refreshedM = true;
+    if (result && IsValid() && !IsNotModified() && Merge())
        ChangeState();
-    //   }
-    //else {
-    //   for (cElvisEvent *i = First(); i; i = Next(i))
-    //       i->Tag(false);
-    //   }
   }
-  cElvisWidget::GetInstance()->GetTopEvents(*this);
-  //{
-    //LOCK_THREAD;
-    //for (cElvisEvent *i = First(); i; i = Next(i)) {
-    //    if (!i->IsTagged())
-    //       Del(i);
-    //    }
-    //ChangeState();
-  //}
+  stagingM.Clear();
+  stagingArenaM.Clear();
 }
 
 bool cElvisTopEvents::Update(bool waitP)
@@ -343,13 +1069,26 @@ bool cElvisTopEvents::StateChanged(int &stateP)
   LOCK_THREAD;
   bool result = (stateP != stateM);
 
+  // every change makes the menu rebuild its items
+  if (result)
+     ++rebuildsM;
   stateP = stateM;
 
   return result;
 }
 
+cString cElvisTopEvents::Statistics()
+{
+  LOCK_THREAD;
+
+  return cString::sprintf("TopEvents: events=%d records=%zu strings=%zu/%zu refreshes=%lu changes=%lu rebuilds=%lu info drops=%lu", Count(), Count() * sizeof(cElvisEvent),
+                          arenaM.Bytes(), arenaM.Reserved(), refreshesM, changesM, rebuildsM, infoDropsM);
+}
+
 void cElvisTopEvents::Action()
 {
+  cElvisWidgetPriority priority(cElvisWidgetPriority::epBackground);
+
   Refresh();
 }
 
@@ -12,52 +12,96 @@
 #include <vdr/tools.h>
 #include <vdr/epg.h>
 
+#include "pool.h"
+#include "snapshot.h"
 #include "widget.h"
 
+// --- cElvisChannelIds -----------------------------------------------
+
+// maps the channel names to small ids, which remain valid until the plugin is stopped
+class cElvisChannelIds {
+private:
+  static cElvisChannelIds *instanceS;
+  cMutex mutexM;
+  cStringList namesM;
+  // constructor
+  cElvisChannelIds();
+  // to prevent copy constructor and assignment
+  cElvisChannelIds(const cElvisChannelIds&);
+  cElvisChannelIds& operator=(const cElvisChannelIds&);
+public:
+  static cElvisChannelIds *GetInstance();
+  static void Destroy();
+  virtual ~cElvisChannelIds();
+  unsigned short Id(const char *nameP);
+  const char *Name(unsigned short idP);
+};
+
+// --- cElvisEvent -----------------------------------------------------
+
 class cElvisEvent : public cListObject {
-  friend class cElvisChannel;
 private:
-  bool taggedM;
-  int idM;
-  cString nameM;
-  cString channelM;
-  cString simpleStartTimeM;
-  cString simpleEndTimeM;
-  cString startTimeM;
-  cString endTimeM;
-  cString descriptionM;
   cElvisWidgetEventInfo *infoM;
-  time_t startTimeValueM;
-  time_t endTimeValueM;
-  int lengthM;
+  const char *nameM;        // stored in the arena of the generation
+  const char *descriptionM; // stored in the arena of the generation
+  time_t startTimeM;
+  time_t endTimeM;
+  int idM;
+  unsigned short channelM;
+  bool taggedM;
   // to prevent default constructor
   cElvisEvent();
   // to prevent copy constructor and assignment
   cElvisEvent(const cElvisEvent&);
   cElvisEvent &operator=(const cElvisEvent &);
 public:
-  cElvisEvent(int idP, const char *nameP, const char *simpleStartTimeP, const char *simpleEndTimeP, const char *startTimeP, const char *endTimeP, const char *descriptionP);
-  cElvisEvent(int idP, const char *nameP, const char *channelP, const char *startTimeP, const char *endTimeP);
+  cElvisEvent(cElvisStringArena &arenaP, int idP, const char *nameP, unsigned short channelP, time_t startTimeP, time_t endTimeP, const char *descriptionP = NULL);
   virtual ~cElvisEvent();
+  // caches the info in the event, so it must be called with the list of the event locked
   cElvisWidgetEventInfo *Info();
+  bool Equals(cElvisEvent *eventP);
+  // takes over the strings of an equal event from a newer generation, the old ones are freed with their arena
+  void Adopt(cElvisEvent *eventP) { nameM = eventP->nameM; descriptionM = eventP->descriptionM; }
+  // takes over the contents of a changed event with the same id and tells whether the info was dropped
+  bool Update(cElvisEvent *eventP);
   void Tag(bool onOffP) { taggedM = onOffP; }
   bool IsTagged() { return taggedM; }
   int Id() { return idM; }
-  const char *Name() { return *nameM; }
-  const char *Channel() { return *channelM; }
-  const char *StartTime() { return *startTimeM; }
-  const char *EndTime() { return *endTimeM; }
-  const char *Description() { return *descriptionM; }
-  time_t StartTimeValue() { return startTimeValueM; }
-  time_t EndTimeValue() { return endTimeValueM; }
-  int LengthValue() { return lengthM; }
+  // the strings are valid only while the list of the event is locked, so they must be copied to be kept
+  const char *Name() { return nameM; }
+  const char *Channel() { return cElvisChannelIds::GetInstance()->Name(channelM); }
+  const char *Description() { return descriptionM; }
+  time_t StartTimeValue() { return startTimeM; }
+  time_t EndTimeValue() { return endTimeM; }
+  int LengthValue() { return (endTimeM > startTimeM) ? int(endTimeM - startTimeM) / 60 : 0; }
+};
+
+// --- cElvisEventLock -------------------------------------------------
+
+// locks both lists of events, so an event of either one can be read without knowing its owner
+class cElvisEventLock {
+private:
+  cThreadLock channelsLockM;
+  cThreadLock topEventsLockM;
+public:
+  cElvisEventLock();
 };
 
 // --- cElvisChannel ---------------------------------------------------
 
-class cElvisChannel : public cListObject, public cList<cElvisEvent> {
+class cElvisChannel : public cListObject, public cList<cElvisEvent>, public cElvisWidgetEventCallbackIf {
+  friend class cElvisChannels;
 private:
+  enum {
+    eArenaChunkSize = KILOBYTE(8)
+  };
   cString nameM;
+  unsigned short idM;
+  time_t lastUpdateM;               // of the events loaded on demand
+  cElvisStringArena arenaM;         // the strings of the events
+  cVector<cElvisEvent *> timeIndexM; // the events in the order of start time
+  int Lookup(time_t timeP);
+  cElvisEvent *Match(cElvisEvent *eventP);
   // to prevent default constructor
   cElvisChannel();
   // to prevent copy and assignment constructors
@@ -66,9 +110,19 @@ private:
 public:
   cElvisChannel(const char *nameP);
   virtual ~cElvisChannel();
-  void AddEvent(int idP, const char *nameP, const char *simpleStartTimeP, const char *simpleEndTimeP, const char *startTimeP, const char *endTimeP, const char *descriptionP);
+  virtual void Clear();
+  virtual void AddEvent(int idP, const char *nameP, const char *simpleStartTimeP, const char *simpleEndTimeP, const char *startTimeP, const char *endTimeP);
+  cElvisEvent *AddEvent(int idP, const char *nameP, time_t startTimeP, time_t endTimeP, const char *descriptionP);
+  // takes over the events of the given channel and tells whether anything changed
+  bool Merge(cElvisChannel *channelP);
   cElvisEvent *GetEvent(int idP);
+  // the time queries use the index, and their results are valid while the thread lock of the channels is held
+  cElvisEvent *GetEventAt(time_t timeP);
+  cElvisEvent *GetEventAfter(time_t timeP);
+  int GetEvents(time_t startTimeP, time_t endTimeP, cVector<cElvisEvent *> &eventsP);
+  int GetEventsFrom(time_t timeP, int countP, cVector<cElvisEvent *> &eventsP);
   const char *Name() { return *nameM; }
+  bool IsLoaded() { return (lastUpdateM > 0); }
 };
 
 // --- cElvisChannels --------------------------------------------------
@@ -77,10 +131,44 @@ class cElvisChannels : public cList<cElvisChannel>, public cThread, public cElvi
 private:
   static cElvisChannels *instanceS;
   enum {
-    eUpdateInterval = 21600 // 6 h
+    eUpdateInterval      = 21600, // 6 h
+    eEventUpdateInterval = 3600,  // 1 h
+    eEventHashSize       = 16384,
+    eSlotLength          = 60     // in seconds
+  };
+  class cChannelList : public cElvisWidgetChannelCallbackIf {
+  private:
+    cElvisChannels *channelsM;
+  public:
+    cChannelList(cElvisChannels *channelsP) : channelsM(channelsP) {}
+    virtual void AddChannel(const char *nameP, const char *logoP) { channelsM->Stage(nameP); }
   };
   int stateM;
   time_t lastUpdateM;
+  bool refreshedM; // in this run, so the snapshot is worth saving
+  int lazyM;
+  cMutex refreshMutexM;
+  cChannelList channelListM;
+  cMutex queueMutexM;
+  cStringList queueM;
+  unsigned long loadsM;
+  unsigned long prefetchesM;
+  uint64_t loadMsM;
+  cHash<cElvisChannel> channelHashM;
+  cHash<cElvisEvent> eventHashM;
+  cHash<cElvisEvent> slotHashM; // by channel and start time
+  cList<cElvisChannel> stagingM;
+  cHash<cElvisChannel> stagingHashM;
+  static unsigned int SlotKey(const char *channelP, time_t startTimeP);
+  static cElvisChannel *Find(cList<cElvisChannel> &listP, cHash<cElvisChannel> &hashP, const char *nameP);
+  cElvisChannel *Stage(const char *channelP);
+  void Index(cElvisChannel *channelP);
+  void Unindex(cElvisChannel *channelP);
+  bool Merge(bool channelsOnlyP = false);
+  void Restore();
+  bool Load(const char *channelP);
+  cElvisEvent *FindEvent(const char *channelP, const char *titleP, time_t startTimeP);
+  int Resolve(tEventID eventIdP);
   void Refresh(bool foregroundP = false);
   // constructor
   cElvisChannels();
@@ -92,11 +180,27 @@ protected:
 public:
   static cElvisChannels *GetInstance();
   static void Destroy();
+  static bool IsRefreshed() { return instanceS && instanceS->refreshedM; }
   virtual ~cElvisChannels();
   virtual void AddEvent(const char *channelP, int idP, const char *nameP, const char *simpleStartTimeP, const char *simpleEndTimeP, const char *startTimeP, const char *endTimeP, const char *descriptionP);
+  virtual void Clear();
+  cElvisChannel *GetChannel(const char *nameP);
+  cElvisEvent *GetEvent(int idP);
+  // the results are valid while the thread lock is held; the now and next ones are aligned with the channels and may contain NULL
+  void GetNowNext(time_t timeP, cVector<cElvisEvent *> &nowP, cVector<cElvisEvent *> &nextP);
+  int GetEvents(time_t startTimeP, time_t endTimeP, cVector<cElvisEvent *> &eventsP);
+  int GetEventsFrom(time_t timeP, int countP, cVector<cElvisEvent *> &eventsP);
   bool Update(bool waitP = false);
+  // loads the events of a channel in the on demand mode; returns false if they are still missing
+  bool Update(cElvisChannel *channelP, bool waitP = false);
+  void Prefetch(cElvisChannel *channelP);
+  bool IsLazy() { return lazyM; }
   void ChangeState() { ++stateM; }
   bool StateChanged(int &stateP);
+  cString Statistics();
+  // times the indexes over a private set of synthetic events
+  static cString Benchmark(int channelsP, int daysP);
+  void Snapshot(cElvisSnapshot::cWriter &writerP);
   bool AddTimer(tEventID eventIdP);
   bool DelTimer(tEventID eventIdP);
 };
@@ -107,10 +211,23 @@ class cElvisTopEvents : public cList<cElvisEvent>, public cThread, public cElvis
 private:
   static cElvisTopEvents *instanceS;
   enum {
-    eUpdateInterval = 900 // 15min
+    eUpdateInterval = 900, // 15min
+    eEventHashSize  = 256
   };
   int stateM;
   time_t lastUpdateM;
+  bool refreshedM; // in this run, so the snapshot is worth saving
+  cMutex refreshMutexM;
+  cHash<cElvisEvent> eventHashM;
+  unsigned long refreshesM;
+  unsigned long changesM;
+  unsigned long rebuildsM;
+  unsigned long infoDropsM;
+  cList<cElvisEvent> stagingM;
+  cElvisStringArena arenaM;
+  cElvisStringArena stagingArenaM;
+  bool Merge();
+  void Restore();
   void Refresh(bool foregroundP = false);
   cElvisEvent *GetEvent(int idP);
   // constructor
@@ -123,11 +240,14 @@ protected:
 public:
   static cElvisTopEvents *GetInstance();
   static void Destroy();
+  static bool IsRefreshed() { return instanceS && instanceS->refreshedM; }
   virtual ~cElvisTopEvents();
   virtual void AddEvent(int idP, const char *nameP, const char *channelP, const char *startTimeP, const char *endTimeP);
   bool Update(bool waitP = false);
   void ChangeState() { ++stateM; }
   bool StateChanged(int &stateP);
+  cString Statistics();
+  void Snapshot(cElvisSnapshot::cWriter &writerP);
 };
 
 #endif // __ELVIS_EVENTS_H
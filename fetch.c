@@ -12,6 +12,7 @@
 
 #include "common.h"
 #include "log.h"
+#include "transport.h"
 #include "fetch.h"
 
 // --- cElvisIndexGenerator --------------------------------------------
@@ -184,7 +185,7 @@ cElvisFetchItem::cElvisFetchItem(const char *urlP, const char *nameP, const char
      }
 
   // setup curl interface
-  handleM = curl_easy_init();
+  handleM = cElvisTransport::GetInstance()->Acquire();
   if (handleM) {
      // verbose output
      curl_easy_setopt(handleM, CURLOPT_VERBOSE, 1L);
@@ -197,16 +198,6 @@ cElvisFetchItem::cElvisFetchItem(const char *urlP, const char *nameP, const char
      curl_easy_setopt(handleM, CURLOPT_HEADERFUNCTION, cElvisFetchItem::HeaderCallback);
      curl_easy_setopt(handleM, CURLOPT_HEADERDATA, this);
 
-     // no progress meter and no signaling
-     curl_easy_setopt(handleM, CURLOPT_NOPROGRESS, 1L);
-     curl_easy_setopt(handleM, CURLOPT_NOSIGNAL, 1L);
-
-     // set user-agent
-     curl_easy_setopt(handleM, CURLOPT_USERAGENT, *cString::sprintf("vdr-%s/%s", PLUGIN_NAME_I18N, VERSION));
-
-     // follow location
-     curl_easy_setopt(handleM, CURLOPT_FOLLOWLOCATION, 1L);
-
      // set url
      curl_easy_setopt(handleM, CURLOPT_URL, *urlM);
 
@@ -226,7 +217,7 @@ cElvisFetchItem::~cElvisFetchItem()
      // cleanup curl stuff
      curl_slist_free_all(headerListM);
      headerListM = NULL;
-     curl_easy_cleanup(handleM);
+     cElvisTransport::GetInstance()->Release(handleM);
      handleM = NULL;
      }
   DELETE_POINTER(fileNameM);
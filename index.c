@@ -0,0 +1,341 @@
+/*
+ * index.c: Elvis plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#include "common.h"
+#include "log.h"
+#include "index.h"
+
+// --- cElvisTimeIndex -------------------------------------------------
+
+cElvisTimeIndex::cElvisTimeIndex(int programIdP)
+: refsM(1),
+  programIdM(programIdP),
+  entriesM(),
+  referencePtsM(-1),
+  hasStartM(false),
+  startM(0)
+{
+  debug1("%s (%d)", __PRETTY_FUNCTION__, programIdP);
+}
+
+int cElvisTimeIndex::Find(unsigned long offsetP)
+{
+  // called with the lock held; returns the first entry beyond the given offset
+  int low = 0, high = entriesM.Size();
+
+  while (low < high) {
+        int middle = (low + high) / 2;
+        if (entriesM[middle].offset <= offsetP)
+           low = middle + 1;
+        else
+           high = middle;
+        }
+
+  return low;
+}
+
+bool cElvisTimeIndex::TimeAt(unsigned long offsetP, int &timeP)
+{
+  // called with the lock held; interpolates between the surrounding entries
+  int n = entriesM.Size();
+  int i = Find(offsetP);
+
+  if (n < 2)
+     return false;
+  if ((i > 0) && (i < n)) {
+     const cEntry &a = entriesM[i - 1];
+     const cEntry &b = entriesM[i];
+     timeP = a.time + (int)((double)(offsetP - a.offset) * (b.time - a.time) / (double)(b.offset - a.offset));
+     return true;
+     }
+
+  // beyond the indexed part, so extrapolate with the average bitrate of it, if it's long enough
+  const cEntry &first = entriesM[0];
+  const cEntry &last = entriesM[n - 1];
+  if ((last.offset <= first.offset) || (last.time - first.time < eMinSpanMs))
+     return false;
+  const cEntry &anchor = (i <= 0) ? first : last;
+  timeP = anchor.time + (int)(((double)offsetP - (double)anchor.offset) * (last.time - first.time) / (double)(last.offset - first.offset));
+
+  return true;
+}
+
+bool cElvisTimeIndex::OffsetAt(int timeP, unsigned long &offsetP)
+{
+  // called with the lock held; the times grow along with the offsets
+  int n = entriesM.Size();
+  int low = 0, high = n;
+  double offset;
+
+  if (n < 2)
+     return false;
+  while (low < high) {
+        int middle = (low + high) / 2;
+        if (entriesM[middle].time <= timeP)
+           low = middle + 1;
+        else
+           high = middle;
+        }
+  if ((low > 0) && (low < n)) {
+     const cEntry &a = entriesM[low - 1];
+     const cEntry &b = entriesM[low];
+     offset = (double)a.offset + (double)(timeP - a.time) * (double)(b.offset - a.offset) / (double)max(b.time - a.time, 1);
+     }
+  else {
+     const cEntry &first = entriesM[0];
+     const cEntry &last = entriesM[n - 1];
+     if ((last.offset <= first.offset) || (last.time - first.time < eMinSpanMs))
+        return false;
+     const cEntry &anchor = (low <= 0) ? first : last;
+     offset = (double)anchor.offset + (double)(timeP - anchor.time) * (double)(last.offset - first.offset) / (double)(last.time - first.time);
+     }
+  offsetP = (offset > 0.0) ? (unsigned long)offset : 0;
+  offsetP -= offsetP % TS_SIZE;
+
+  return true;
+}
+
+int cElvisTimeIndex::Count()
+{
+  cMutexLock MutexLock(&mutexM);
+
+  return entriesM.Size();
+}
+
+void cElvisTimeIndex::Add(unsigned long offsetP, int64_t ptsP, bool startP)
+{
+  cMutexLock MutexLock(&mutexM);
+
+  if (referencePtsM < 0)
+     referencePtsM = ptsP;
+  int time = (int)(PtsDiff(referencePtsM, ptsP) * 1000 / PTSTICKS);
+  if (startP) {
+     startM = time;
+     hasStartM = true;
+     }
+
+  // keep the index sparse, as any frame nearby is good enough for seeking
+  int i = Find(offsetP);
+  if (((i > 0) && (abs(time - entriesM[i - 1].time) < eEntryIntervalMs)) || ((i < entriesM.Size()) && (abs(entriesM[i].time - time) < eEntryIntervalMs)))
+     return;
+  // the times must grow along with the offsets for the searches and the interpolation, so a frame
+  // beyond a discontinuity of the timestamps is left out and that part of the stream is extrapolated
+  if (((i > 0) && ((entriesM[i - 1].offset == offsetP) || (entriesM[i - 1].time > time))) || ((i < entriesM.Size()) && (entriesM[i].time < time))) {
+     debug5("%s (%lu, %d) Skipped a discontinuity", __PRETTY_FUNCTION__, offsetP, time);
+     return;
+     }
+  entriesM.Insert(cEntry(offsetP, time), i);
+}
+
+bool cElvisTimeIndex::GetTime(unsigned long offsetP, int &msP)
+{
+  cMutexLock MutexLock(&mutexM);
+  int time;
+
+  if (!hasStartM || !TimeAt(offsetP, time))
+     return false;
+  msP = max(time - startM, 0);
+
+  return true;
+}
+
+bool cElvisTimeIndex::GetOffset(int msP, unsigned long &offsetP)
+{
+  cMutexLock MutexLock(&mutexM);
+
+  return hasStartM && OffsetAt(startM + max(msP, 0), offsetP);
+}
+
+bool cElvisTimeIndex::GetSkip(unsigned long fromP, int deltaMsP, unsigned long &offsetP)
+{
+  cMutexLock MutexLock(&mutexM);
+  int time;
+
+  return TimeAt(fromP, time) && OffsetAt(time + deltaMsP, offsetP);
+}
+
+// --- cElvisTimeIndexer -----------------------------------------------
+
+cElvisTimeIndexer::cElvisTimeIndexer(cElvisTimeIndex *indexP)
+: indexM(indexP),
+  bufferM(eBufferSize, MIN_TS_PACKETS_FOR_FRAME_DETECTOR * TS_SIZE),
+  patPmtParserM(),
+  frameDetectorM(),
+  offsetM(0),
+  frameOffsetM(-1),
+  startM(true)
+{
+  if (indexM)
+     indexM->AddRef();
+}
+
+cElvisTimeIndexer::~cElvisTimeIndexer()
+{
+  if (indexM)
+     indexM->Release();
+}
+
+void cElvisTimeIndexer::Reset(unsigned long offsetP)
+{
+  bufferM.Clear();
+  offsetM = offsetP;
+  frameOffsetM = -1;
+  startM = (offsetP == 0);
+  // the frame parser must not carry over anything from the previous position
+  if (patPmtParserM.Vpid())
+     frameDetectorM.SetPid(patPmtParserM.Vpid(), patPmtParserM.Vtype());
+}
+
+int64_t cElvisTimeIndexer::GetPts(const uchar *dataP, int lenP)
+{
+  // the first video packet starting a payload carries the time of the frame
+  for (const uchar *p = dataP; lenP >= TS_SIZE; p += TS_SIZE, lenP -= TS_SIZE) {
+      if ((TsPid(p) == patPmtParserM.Vpid()) && TsPayloadStart(p))
+         return TsGetPts(p, TS_SIZE);
+      }
+
+  return -1;
+}
+
+void cElvisTimeIndexer::Process()
+{
+  int length;
+  uchar *data;
+
+  while ((data = bufferM.Get(length)) != NULL) {
+        int processed = 0;
+        if (*data != TS_SYNC_BYTE) {
+           // the stream may continue in the middle of a packet
+           for (processed = 1; (processed < length) && (data[processed] != TS_SYNC_BYTE); ++processed)
+               ;
+           }
+        else if (frameDetectorM.Synced()) {
+           // Step 3 - index the independent frames:
+           if (TsPid(data) == PATPID)
+              frameOffsetM = offsetM; // the PAT/PMT is at the beginning of an I-frame
+           processed = frameDetectorM.Analyze(data, length);
+           if ((processed > 0) && frameDetectorM.NewFrame()) {
+              if (frameDetectorM.IndependentFrame()) {
+                 int64_t pts = GetPts(data, processed);
+                 if (pts >= 0)
+                    indexM->Add((frameOffsetM >= 0) ? frameOffsetM : offsetM, pts, false);
+                 }
+              frameOffsetM = -1;
+              }
+           }
+        else if (patPmtParserM.Vpid()) {
+           // Step 2 - sync the frame detector, but take the start time from the very first frame:
+           if (startM) {
+              int64_t pts = GetPts(data, length);
+              if (pts >= 0) {
+                 indexM->Add(offsetM, pts, true);
+                 startM = false;
+                 }
+              }
+           processed = frameDetectorM.Analyze(data, length);
+           }
+        else {
+           // Step 1 - parse PAT/PMT:
+           uchar *p = data;
+           while (length >= TS_SIZE) {
+                 int pid = TsPid(p);
+                 if (pid == PATPID)
+                    patPmtParserM.ParsePat(p, TS_SIZE);
+                 else if (patPmtParserM.IsPmtPid(pid))
+                    patPmtParserM.ParsePmt(p, TS_SIZE);
+                 length -= TS_SIZE;
+                 p += TS_SIZE;
+                 if (patPmtParserM.Vpid()) {
+                    frameDetectorM.SetPid(patPmtParserM.Vpid(), patPmtParserM.Vtype());
+                    break;
+                    }
+                 }
+           processed = (int)(p - data);
+           }
+        if (processed <= 0)
+           break;
+        bufferM.Del(processed);
+        offsetM += processed;
+        }
+}
+
+void cElvisTimeIndexer::Put(const uchar *dataP, int lenP)
+{
+  if (!indexM)
+     return;
+  while (lenP > 0) {
+        int len = bufferM.Put(dataP, lenP);
+        Process();
+        if (len <= 0) {
+           // nothing could be analyzed, so give up on this part of the stream
+           Reset(offsetM + bufferM.Available() + lenP);
+           break;
+           }
+        dataP += len;
+        lenP -= len;
+        }
+}
+
+// --- cElvisTimeIndexes -----------------------------------------------
+
+cElvisTimeIndexes *cElvisTimeIndexes::instanceS = NULL;
+
+cElvisTimeIndexes *cElvisTimeIndexes::GetInstance()
+{
+  if (!instanceS)
+     instanceS = new cElvisTimeIndexes();
+
+  return instanceS;
+}
+
+void cElvisTimeIndexes::Destroy()
+{
+  DELETE_POINTER(instanceS);
+}
+
+cElvisTimeIndexes::cElvisTimeIndexes()
+: indexesM()
+{
+  debug1("%s", __PRETTY_FUNCTION__);
+}
+
+cElvisTimeIndexes::~cElvisTimeIndexes()
+{
+  cMutexLock MutexLock(&mutexM);
+  debug1("%s", __PRETTY_FUNCTION__);
+  for (int i = 0; i < indexesM.Size(); ++i)
+      indexesM[i]->Release();
+  indexesM.Clear();
+}
+
+cElvisTimeIndex *cElvisTimeIndexes::Get(int programIdP)
+{
+  cMutexLock MutexLock(&mutexM);
+  cElvisTimeIndex *index = NULL;
+
+  for (int i = 0; i < indexesM.Size(); ++i) {
+      if (indexesM[i]->ProgramId() == programIdP) {
+         index = indexesM[i];
+         indexesM.Remove(i);
+         break;
+         }
+      }
+  if (index)
+     debug1("%s (%d) Cached entries=%d", __PRETTY_FUNCTION__, programIdP, index->Count());
+  else {
+     index = new cElvisTimeIndex(programIdP);
+     // the holders of the evicted index keep it alive on their own
+     if (indexesM.Size() >= eMaxIndexes) {
+        indexesM[0]->Release();
+        indexesM.Remove(0);
+        }
+     }
+  indexesM.Append(index);
+  index->AddRef();
+
+  return index;
+}
@@ -0,0 +1,115 @@
+/*
+ * index.h: Elvis plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#ifndef __ELVIS_INDEX_H
+#define __ELVIS_INDEX_H
+
+#include <stdint.h>
+
+#include <vdr/remux.h>
+#include <vdr/ringbuffer.h>
+#include <vdr/thread.h>
+#include <vdr/tools.h>
+
+// --- cElvisTimeIndex -------------------------------------------------
+
+// a sparse map between the byte offsets and the times of the independent frames of one recording;
+// it's shared by all of its holders and deleted by the last Release()
+class cElvisTimeIndex {
+private:
+  enum {
+    eEntryIntervalMs = 1000, // in milliseconds
+    eMinSpanMs       = 10000 // in milliseconds
+  };
+  struct cEntry {
+    unsigned long offset;
+    int time; // in milliseconds since the reference frame
+    // cVector clears its elements with T(0)
+    cEntry(unsigned long offsetP = 0, int timeP = 0) : offset(offsetP), time(timeP) {}
+    bool operator==(const cEntry &entryP) const { return offset == entryP.offset; }
+  };
+  int refsM;
+  int programIdM;
+  cMutex mutexM;
+  cVector<cEntry> entriesM;
+  int64_t referencePtsM;
+  bool hasStartM;
+  int startM;
+  int Find(unsigned long offsetP);
+  bool TimeAt(unsigned long offsetP, int &timeP);
+  bool OffsetAt(int timeP, unsigned long &offsetP);
+  // to prevent copy constructor and assignment
+  cElvisTimeIndex(const cElvisTimeIndex&);
+  cElvisTimeIndex& operator=(const cElvisTimeIndex&);
+  virtual ~cElvisTimeIndex() {}
+public:
+  cElvisTimeIndex(int programIdP);
+  void AddRef() { __sync_add_and_fetch(&refsM, 1); }
+  void Release() { if (__sync_sub_and_fetch(&refsM, 1) == 0) delete this; }
+  int ProgramId() { return programIdM; }
+  int Count();
+  // the first frame of the recording tells where the time starts
+  void Add(unsigned long offsetP, int64_t ptsP, bool startP);
+  // in milliseconds since the start of the recording
+  bool GetTime(unsigned long offsetP, int &msP);
+  bool GetOffset(int msP, unsigned long &offsetP);
+  // doesn't need to know the start of the recording
+  bool GetSkip(unsigned long fromP, int deltaMsP, unsigned long &offsetP);
+};
+
+// --- cElvisTimeIndexer -----------------------------------------------
+
+// feeds the index with the stream as it's received
+class cElvisTimeIndexer {
+private:
+  enum {
+    eBufferSize = KILOBYTE(256)
+  };
+  cElvisTimeIndex *indexM;
+  cRingBufferLinear bufferM;
+  cPatPmtParser patPmtParserM;
+  cFrameDetector frameDetectorM;
+  unsigned long offsetM;
+  long frameOffsetM;
+  bool startM;
+  void Process();
+  int64_t GetPts(const uchar *dataP, int lenP);
+  // to prevent copy constructor and assignment
+  cElvisTimeIndexer(const cElvisTimeIndexer&);
+  cElvisTimeIndexer& operator=(const cElvisTimeIndexer&);
+public:
+  cElvisTimeIndexer(cElvisTimeIndex *indexP);
+  virtual ~cElvisTimeIndexer();
+  // the stream continues at the given byte offset
+  void Reset(unsigned long offsetP);
+  void Put(const uchar *dataP, int lenP);
+};
+
+// --- cElvisTimeIndexes -----------------------------------------------
+
+class cElvisTimeIndexes {
+private:
+  enum {
+    eMaxIndexes = 16
+  };
+  static cElvisTimeIndexes *instanceS;
+  cMutex mutexM;
+  cVector<cElvisTimeIndex *> indexesM; // the least recently used first
+  // constructor
+  cElvisTimeIndexes();
+  // to prevent copy constructor and assignment
+  cElvisTimeIndexes(const cElvisTimeIndexes&);
+  cElvisTimeIndexes& operator=(const cElvisTimeIndexes&);
+public:
+  static cElvisTimeIndexes *GetInstance();
+  static void Destroy();
+  virtual ~cElvisTimeIndexes();
+  // the returned index is referenced on behalf of the caller, who must Release() it
+  cElvisTimeIndex *Get(int programIdP);
+};
+
+#endif // __ELVIS_INDEX_H
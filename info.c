@@ -0,0 +1,229 @@
+/*
+ * info.c: Elvis plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#include "common.h"
+#include "log.h"
+#include "info.h"
+
+// --- cElvisInfoEntry -------------------------------------------------
+
+cElvisInfoEntry::cElvisInfoEntry(unsigned int keyP)
+: keyM(keyP),
+  infoM(NULL),
+  pendingM(true),
+  prefetchedM(false),
+  timestampM(0),
+  sizeM(0)
+{
+}
+
+cElvisInfoEntry::~cElvisInfoEntry()
+{
+  if (infoM)
+     infoM->Release();
+}
+
+// --- cElvisInfoCache -------------------------------------------------
+
+cElvisInfoCache *cElvisInfoCache::instanceS = NULL;
+
+cElvisInfoCache *cElvisInfoCache::GetInstance()
+{
+  if (!instanceS)
+     instanceS = new cElvisInfoCache();
+
+  return instanceS;
+}
+
+void cElvisInfoCache::Destroy()
+{
+  DELETE_POINTER(instanceS);
+}
+
+cElvisInfoCache::cElvisInfoCache()
+: cThread("cElvisInfoCache"),
+  hashM(),
+  lruM(),
+  bytesM(0),
+  hitsM(0),
+  missesM(0),
+  coalescedM(0),
+  queueM(),
+  prefetchesM(0),
+  prefetchHitsM(0),
+  prefetchUnusedM(0)
+{
+}
+
+cElvisInfoCache::~cElvisInfoCache()
+{
+  Cancel(3);
+  cMutexLock MutexLock(&mutexM);
+  hashM.Clear();
+  lruM.Clear();
+}
+
+void cElvisInfoCache::Remove(cElvisInfoEntry *entryP)
+{
+  if (entryP->prefetchedM)
+     ++prefetchUnusedM;
+  bytesM -= entryP->sizeM;
+  hashM.Del(entryP, entryP->keyM);
+  lruM.Del(entryP);
+}
+
+void cElvisInfoCache::Trim()
+{
+  // evict the least recently used entries, but never the ones still being fetched
+  cElvisInfoEntry *e = lruM.First();
+  while (e && (bytesM > eMemoryBudget)) {
+        cElvisInfoEntry *next = lruM.Next(e);
+        if (!e->pendingM)
+           Remove(e);
+        e = next;
+        }
+}
+
+cElvisWidgetInfo *cElvisInfoCache::Get(eInfoType typeP, int idP, bool prefetchP)
+{
+  unsigned int key = ((unsigned int)idP << 1) | typeP;
+  cElvisWidgetInfo *info = NULL;
+
+  if (idP <= 0)
+     return NULL;
+
+  mutexM.Lock();
+  cElvisInfoEntry *e = hashM.Get(key);
+  // a prefetch has nothing to do, if the info is already there or on its way
+  if (prefetchP && e && (e->pendingM || ((time(NULL) - e->timestampM) < eTimeToLive))) {
+     mutexM.Unlock();
+     return NULL;
+     }
+  if (!prefetchP && e && e->prefetchedM) {
+     ++prefetchHitsM;
+     e->prefetchedM = false;
+     }
+  if (e && e->pendingM) {
+     // somebody else is already fetching the same info
+     ++coalescedM;
+     while ((e = hashM.Get(key)) != NULL && e->pendingM)
+           condM.Wait(mutexM);
+     // the fetch failed, so don't retry it right away
+     if (!e) {
+        mutexM.Unlock();
+        return NULL;
+        }
+     }
+  if (e && !e->pendingM && ((time(NULL) - e->timestampM) >= eTimeToLive)) {
+     Remove(e);
+     e = NULL;
+     }
+  if (e) {
+     ++hitsM;
+     // keep the lru list in the order of use
+     lruM.Del(e, false);
+     lruM.Add(e);
+     info = e->infoM;
+     info->AddRef();
+     mutexM.Unlock();
+     return info;
+     }
+
+  if (prefetchP)
+     ++prefetchesM;
+  else
+     ++missesM;
+  e = new cElvisInfoEntry(key);
+  e->prefetchedM = prefetchP;
+  hashM.Add(e, key);
+  lruM.Add(e);
+  mutexM.Unlock();
+
+  switch (typeP) {
+    case itEvent:
+         info = cElvisWidget::GetInstance()->GetEventInfo(idP);
+         break;
+    case itVOD:
+         info = cElvisWidget::GetInstance()->GetVODInfo(idP);
+         break;
+    }
+
+  mutexM.Lock();
+  if (info) {
+     e->infoM = info;
+     e->pendingM = false;
+     e->timestampM = time(NULL);
+     e->sizeM = info->Size();
+     bytesM += e->sizeM;
+     info->AddRef();
+     Trim();
+     }
+  else
+     Remove(e);
+  condM.Broadcast();
+  mutexM.Unlock();
+
+  return info;
+}
+
+cElvisWidgetEventInfo *cElvisInfoCache::GetEventInfo(int idP)
+{
+  return static_cast<cElvisWidgetEventInfo *>(Get(itEvent, idP));
+}
+
+cElvisWidgetVODInfo *cElvisInfoCache::GetVODInfo(int idP)
+{
+  return static_cast<cElvisWidgetVODInfo *>(Get(itVOD, idP));
+}
+
+void cElvisInfoCache::Prefetch(cVector<int> &eventIdsP)
+{
+  {
+    cMutexLock MutexLock(&mutexM);
+    // the previous rows are out of sight already
+    queueM.Clear();
+    for (int i = 0; i < eventIdsP.Size(); ++i) {
+        if (eventIdsP[i] > 0)
+           queueM.Append(eventIdsP[i]);
+        }
+    if (queueM.Size() == 0)
+       return;
+  }
+  Start();
+}
+
+void cElvisInfoCache::Action()
+{
+  // the prefetches must not delay the requests made by the user
+  cElvisWidgetPriority priority(cElvisWidgetPriority::epPrefetch);
+
+  while (Running()) {
+        int id;
+        {
+          cMutexLock MutexLock(&mutexM);
+          if (queueM.Size() == 0) {
+             // a Start() from Prefetch() is ignored while the thread is still running, unless it's marked as ending
+             Cancel(-1);
+             break;
+             }
+          id = queueM[0];
+          queueM.Remove(0);
+        }
+        cElvisWidgetInfo *info = Get(itEvent, id, true);
+        if (info)
+           info->Release();
+        }
+}
+
+cString cElvisInfoCache::Statistics()
+{
+  cMutexLock MutexLock(&mutexM);
+  unsigned long prefetched = prefetchHitsM + prefetchUnusedM;
+
+  return cString::sprintf("Info: entries=%d bytes=%zu hits=%lu misses=%lu coalesced=%lu prefetches=%lu prefetch hits=%lu unused=%lu hit rate=%lu%%", lruM.Count(), bytesM,
+                          hitsM, missesM, coalescedM, prefetchesM, prefetchHitsM, prefetchUnusedM, prefetched ? prefetchHitsM * 100 / prefetched : 0);
+}
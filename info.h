@@ -0,0 +1,84 @@
+/*
+ * info.h: Elvis plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#ifndef __ELVIS_INFO_H
+#define __ELVIS_INFO_H
+
+#include <vdr/thread.h>
+#include <vdr/tools.h>
+
+#include "widget.h"
+
+// --- cElvisInfoEntry -------------------------------------------------
+
+class cElvisInfoEntry : public cListObject {
+  friend class cElvisInfoCache;
+private:
+  unsigned int keyM;
+  cElvisWidgetInfo *infoM;
+  bool pendingM;
+  bool prefetchedM; // not used since it was prefetched
+  time_t timestampM;
+  size_t sizeM;
+  // to prevent default constructor
+  cElvisInfoEntry();
+  // to prevent copy constructor and assignment
+  cElvisInfoEntry(const cElvisInfoEntry&);
+  cElvisInfoEntry &operator=(const cElvisInfoEntry &);
+public:
+  cElvisInfoEntry(unsigned int keyP);
+  virtual ~cElvisInfoEntry();
+};
+
+// --- cElvisInfoCache -------------------------------------------------
+
+class cElvisInfoCache : public cThread {
+private:
+  enum eInfoType {
+    itEvent = 0,
+    itVOD   = 1
+  };
+  enum {
+    eTimeToLive   = 900,           // in seconds
+    eMemoryBudget = MEGABYTE(2)    // in bytes
+  };
+  static cElvisInfoCache *instanceS;
+  cMutex mutexM;
+  cCondVar condM;
+  cHash<cElvisInfoEntry> hashM;
+  cList<cElvisInfoEntry> lruM;
+  size_t bytesM;
+  unsigned long hitsM;
+  unsigned long missesM;
+  unsigned long coalescedM;
+  cVector<int> queueM;
+  unsigned long prefetchesM;
+  unsigned long prefetchHitsM;
+  unsigned long prefetchUnusedM;
+  cElvisWidgetInfo *Get(eInfoType typeP, int idP, bool prefetchP = false);
+  void Remove(cElvisInfoEntry *entryP);
+  void Trim();
+  // constructor
+  cElvisInfoCache();
+  // to prevent copy constructor and assignment
+  cElvisInfoCache(const cElvisInfoCache&);
+  cElvisInfoCache& operator=(const cElvisInfoCache&);
+protected:
+  void Action();
+public:
+  static cElvisInfoCache *GetInstance();
+  static void Destroy();
+  virtual ~cElvisInfoCache();
+  // the returned info is referenced on behalf of the caller, who must Release() it
+  cElvisWidgetEventInfo *GetEventInfo(int idP);
+  cElvisWidgetVODInfo *GetVODInfo(int idP);
+  // replaces the pending prefetches with the given event ids, the most wanted first
+  void Prefetch(cVector<int> &eventIdsP);
+  cString Statistics();
+};
+
+#endif // __ELVIS_INFO_H
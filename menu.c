@@ -12,10 +12,26 @@
 
 #include "common.h"
 #include "fetch.h"
+#include "info.h"
 #include "player.h"
 #include "resume.h"
 #include "menu.h"
 
+// --- PrefetchRows ----------------------------------------------------
+
+// the rows around the cursor that are likely visible and the ones next below them, the nearest ones first
+static void PrefetchRows(int currentP, int visibleP, int countP, cVector<int> &rowsP)
+{
+  const int lookAhead = 10;
+
+  for (int i = 0; i < visibleP + lookAhead; ++i) {
+      if (currentP + i < countP)
+         rowsP.Append(currentP + i);
+      if (i && (i < visibleP) && (currentP - i >= 0))
+         rowsP.Append(currentP - i);
+      }
+}
+
 // --- cElvisRecordingInfoMenu -----------------------------------------
 
 cElvisRecordingInfoMenu::cElvisRecordingInfoMenu(const char *urlP, const char *nameP, const char *descriptionP, const char *startTimeP, unsigned int lengthP, bool encryptedP)
@@ -217,6 +233,7 @@ void cElvisRecordingsMenu::Setup()
 
   SetCurrent(Get(current));
   Display();
+  PrefetchInfo();
 }
 
 eOSState cElvisRecordingsMenu::Delete()
@@ -297,6 +314,19 @@ eOSState cElvisRecordingsMenu::Fetch()
   return osContinue;
 }
 
+void cElvisRecordingsMenu::PrefetchInfo()
+{
+  cVector<int> rows, ids;
+
+  PrefetchRows(Current(), DisplayMenu() ? DisplayMenu()->MaxItems() : 0, Count(), rows);
+  for (int i = 0; i < rows.Size(); ++i) {
+      cElvisRecordingItem *item = reinterpret_cast<cElvisRecordingItem *>(Get(rows[i]));
+      if (item && item->Recording() && !item->IsFolder())
+         ids.Append(item->Recording()->ProgramId());
+      }
+  cElvisInfoCache::GetInstance()->Prefetch(ids);
+}
+
 eOSState cElvisRecordingsMenu::ProcessKey(eKeys keyP)
 {
   bool HadSubMenu = HasSubMenu();
@@ -339,8 +369,10 @@ eOSState cElvisRecordingsMenu::ProcessKey(eKeys keyP)
         return osBack;
      }
 
-  if (!HasSubMenu() && (keyP != kNone))
+  if (!HasSubMenu() && (keyP != kNone)) {
      SetHelpKeys();
+     PrefetchInfo();
+     }
 
   return state;
 }
@@ -349,10 +381,29 @@ eOSState cElvisRecordingsMenu::ProcessKey(eKeys keyP)
 
 cElvisTimerCreateMenu::cElvisTimerCreateMenu(cElvisEvent *eventP)
 : cOsdMenu(*cString::sprintf("%s - %s", tr("Elvis"), tr("Create new timer")), 17),
-  eventM(eventP)
+  eventIdM(0),
+  startTimeM(0),
+  endTimeM(0)
 {
   int i = 0;
 
+  if (eventP) {
+     cElvisEventLock EventLock;
+     eventIdM = eventP->Id();
+     nameM = eventP->Name();
+     channelM = eventP->Channel();
+     startTimeM = eventP->StartTimeValue();
+     endTimeM = eventP->EndTimeValue();
+     }
+  if (eventP && isempty(*channelM)) {
+     // a reference of our own, as a merge may drop the info of the event meanwhile
+     cElvisWidgetEventInfo *info = cElvisInfoCache::GetInstance()->GetEventInfo(eventIdM);
+     if (info) {
+        channelM = info->Channel();
+        info->Release();
+        }
+     }
+
   SetMenuCategory(mcTimerEdit);
   if (cElvisRecordings::GetInstance()->Count() <= 1)
      cElvisRecordings::GetInstance()->Update(true);
@@ -383,14 +434,13 @@ void cElvisTimerCreateMenu::Setup()
 
   Clear();
 
-  if (eventM) {
-     Add(new cOsdItem(cString::sprintf("%s:\t%s", trVDR("Name"), eventM->Name()), osUnknown, false));
-     if (!isempty(eventM->Channel()))
-        Add(new cOsdItem(cString::sprintf("%s:\t%s", trVDR("Channel"), eventM->Channel()), osUnknown, false));
-     else if (eventM->Info() && !isempty(eventM->Info()->Channel()))
-        Add(new cOsdItem(cString::sprintf("%s:\t%s", trVDR("Channel"), eventM->Info()->Channel()), osUnknown, false));
-     Add(new cOsdItem(cString::sprintf("%s:\t%s", trVDR("Start"), eventM->StartTime()), osUnknown, false));
-     Add(new cOsdItem(cString::sprintf("%s:\t%s", trVDR("Stop"), eventM->EndTime()), osUnknown, false));
+  if (*nameM) {
+     Add(new cOsdItem(cString::sprintf("%s:\t%s", trVDR("Name"), *nameM), osUnknown, false));
+     if (!isempty(*channelM))
+        Add(new cOsdItem(cString::sprintf("%s:\t%s", trVDR("Channel"), *channelM), osUnknown, false));
+     Add(new cOsdItem(cString::sprintf("%s:\t%s", trVDR("Start"), *DayDateTime(startTimeM)), osUnknown, false));
+     if (endTimeM)
+        Add(new cOsdItem(cString::sprintf("%s:\t%s", trVDR("Stop"), *DayDateTime(endTimeM)), osUnknown, false));
      Add(new cMenuEditStraItem(tr("Folder"), &folderM, numFoldersM, folderNamesM));
      }
   SetCurrent(Get(current));
@@ -404,8 +454,8 @@ eOSState cElvisTimerCreateMenu::ProcessKey(eKeys keyP)
   if (state == osUnknown) {
      switch (keyP) {
        case kOk:
-            if (eventM) {
-               if (cElvisTimers::GetInstance()->Create(eventM->Id(), folderIdsM[folderM]))
+            if (*nameM) {
+               if (cElvisTimers::GetInstance()->Create(eventIdM, folderIdsM[folderM]))
                   Skins.Message(mtInfo, tr("Timer created"));
                else
                   Skins.Message(mtError, tr("Cannot create timer!"));
@@ -528,6 +578,7 @@ void cElvisTimersMenu::Setup()
 
   SetCurrent(Get(current));
   Display();
+  PrefetchInfo();
 }
 
 eOSState cElvisTimersMenu::Delete()
@@ -563,6 +614,19 @@ eOSState cElvisTimersMenu::Info()
   return osContinue;
 }
 
+void cElvisTimersMenu::PrefetchInfo()
+{
+  cVector<int> rows, ids;
+
+  PrefetchRows(Current(), DisplayMenu() ? DisplayMenu()->MaxItems() : 0, Count(), rows);
+  for (int i = 0; i < rows.Size(); ++i) {
+      cElvisTimerItem *item = reinterpret_cast<cElvisTimerItem *>(Get(rows[i]));
+      if (item && item->Timer())
+         ids.Append(item->Timer()->Id());
+      }
+  cElvisInfoCache::GetInstance()->Prefetch(ids);
+}
+
 eOSState cElvisTimersMenu::ProcessKey(eKeys keyP)
 {
   bool HadSubMenu = HasSubMenu();
@@ -599,8 +663,10 @@ eOSState cElvisTimersMenu::ProcessKey(eKeys keyP)
         return osBack;
      }
 
-  if (!HasSubMenu() && (keyP != kNone))
+  if (!HasSubMenu() && (keyP != kNone)) {
      SetHelpKeys();
+     PrefetchInfo();
+     }
 
   return state;
 }
@@ -837,14 +903,25 @@ cElvisChannelEventInfoMenu::cElvisChannelEventInfoMenu(cElvisEvent *eventP, cons
 {
   SetMenuCategory(mcEvent);
   if (eventM) {
-     if (!isempty(eventM->Description()))
-        textM = cString::sprintf("%s %s - %s (%d %s)\n%s\n\n%s\n\n%s", *DateString(eventM->StartTimeValue()), *TimeString(eventP->StartTimeValue()),
-                                 *TimeString(eventM->EndTimeValue()), eventM->LengthValue(), tr("min"),
-                                 channelP ? channelP : "", eventM->Name(), eventM->Description());
-     else if (eventM->Info())
-        textM = cString::sprintf("%s %s - %s (%d %s)\n%s\n\n%s\n\n%s\n\n%s", *DateString(eventM->Info()->StartTimeValue()), *TimeString(eventP->Info()->StartTimeValue()),
-                                 *TimeString(eventM->Info()->EndTimeValue()), eventM->Info()->LengthValue(), tr("min"),
-                                 channelP ? channelP : "", eventM->Name(), eventM->Info()->ShortText(), eventM->Info()->Description());
+     cString name;
+     int id;
+     {
+       cElvisEventLock EventLock;
+       id = eventM->Id();
+       name = eventM->Name();
+       if (!isempty(eventM->Description()))
+          textM = cString::sprintf("%s %s - %s (%d %s)\n%s\n\n%s\n\n%s", *DateString(eventM->StartTimeValue()), *TimeString(eventP->StartTimeValue()),
+                                   *TimeString(eventM->EndTimeValue()), eventM->LengthValue(), tr("min"),
+                                   channelP ? channelP : "", eventM->Name(), eventM->Description());
+     }
+     // the info is fetched without holding the lists and with a reference of our own, as a merge may drop the info of the event meanwhile
+     cElvisWidgetEventInfo *info = !*textM ? cElvisInfoCache::GetInstance()->GetEventInfo(id) : NULL;
+     if (info) {
+        textM = cString::sprintf("%s %s - %s (%d %s)\n%s\n\n%s\n\n%s\n\n%s", *DateString(info->StartTimeValue()), *TimeString(info->StartTimeValue()),
+                                 *TimeString(info->EndTimeValue()), info->LengthValue(), tr("min"),
+                                 channelP ? channelP : "", *name, info->ShortText(), info->Description());
+        info->Release();
+        }
      }
   SetHelpKeys();
 }
@@ -939,6 +1016,9 @@ cElvisChannelEventsMenu::cElvisChannelEventsMenu(cElvisChannel *channelP)
   channelM(channelP)
 {
   SetMenuCategory(mcSchedule);
+  cElvisChannels::GetInstance()->StateChanged(stateM);
+  // the missing events are loaded in the background and shown once the state changes
+  cElvisChannels::GetInstance()->Update(channelM);
   Setup();
   SetHelpKeys();
 }
@@ -966,6 +1046,7 @@ void cElvisChannelEventsMenu::Setup()
 
   SetCurrent(Get(current));
   Display();
+  PrefetchInfo();
 }
 
 eOSState cElvisChannelEventsMenu::Record(bool quickP)
@@ -1001,6 +1082,19 @@ eOSState cElvisChannelEventsMenu::Info()
   return osContinue;
 }
 
+void cElvisChannelEventsMenu::PrefetchInfo()
+{
+  cVector<int> rows, ids;
+
+  PrefetchRows(Current(), DisplayMenu() ? DisplayMenu()->MaxItems() : 0, Count(), rows);
+  for (int i = 0; i < rows.Size(); ++i) {
+      cElvisChannelEventItem *item = reinterpret_cast<cElvisChannelEventItem *>(Get(rows[i]));
+      if (item && item->Event())
+         ids.Append(item->Event()->Id());
+      }
+  cElvisInfoCache::GetInstance()->Prefetch(ids);
+}
+
 eOSState cElvisChannelEventsMenu::ProcessKey(eKeys keyP)
 {
   bool HadSubMenu = HasSubMenu();
@@ -1020,6 +1114,11 @@ eOSState cElvisChannelEventsMenu::ProcessKey(eKeys keyP)
        case kInfo:
             return Info();
        case kNone:
+            if (cElvisChannels::GetInstance()->StateChanged(stateM)) {
+               Setup();
+               SetHelpKeys();
+               return osContinue;
+               }
             break;
        default:
             break;
@@ -1033,24 +1132,32 @@ eOSState cElvisChannelEventsMenu::ProcessKey(eKeys keyP)
         return osBack;
      }
 
-  if (!HasSubMenu() && (keyP != kNone))
+  if (!HasSubMenu() && (keyP != kNone)) {
      SetHelpKeys();
+     PrefetchInfo();
+     }
 
   return state;
 }
 
 // --- cElvisChannelItem -----------------------------------------------
 
-cElvisChannelItem::cElvisChannelItem(cElvisChannel *channelP)
+cElvisChannelItem::cElvisChannelItem(cElvisChannel *channelP, cElvisEvent *eventP)
 : cOsdItem(channelP ? *cString::sprintf("%s", channelP->Name()) : ""),
-  channelM(channelP)
+  channelM(channelP),
+  eventM(eventP)
 {
+  if (channelM && eventM)
+     SetText(cString::sprintf("%s\t%s\t%s", channelM->Name(), *TimeString(eventM->StartTimeValue()), eventM->Name()));
 }
 
 // --- cElvisEPGMenu ---------------------------------------------------
 
 cElvisEPGMenu::cElvisEPGMenu()
-: cOsdMenu(*cString::sprintf("%s - %s", tr("Elvis"), trVDR("EPG")), 17)
+: cOsdMenu(*cString::sprintf("%s - %s", tr("Elvis"), trVDR("EPG")), 17),
+  currentM(-1),
+  viewModeM(evmChannels),
+  setupTimeM(0)
 {
   SetMenuCategory(mcSchedule);
   cElvisChannels::GetInstance()->StateChanged(stateM);
@@ -1061,11 +1168,12 @@ cElvisEPGMenu::cElvisEPGMenu()
 
 void cElvisEPGMenu::SetHelpKeys()
 {
+  const char *views[evmCount] = { trVDR("Button$Now"), trVDR("Button$Next"), tr("Button$Channels") };
   cElvisChannelItem *item = reinterpret_cast<cElvisChannelItem *>(Get(Current()));
   if (item)
-     SetHelp(trVDR("Button$Open"), NULL, NULL, NULL);
+     SetHelp(trVDR("Button$Open"), views[viewModeM], NULL, item->Event() ? trVDR("Button$Info") : NULL);
   else
-     SetHelp(NULL, NULL, NULL, NULL);
+     SetHelp(NULL, views[viewModeM], NULL, NULL);
 }
 
 void cElvisEPGMenu::Setup()
@@ -1073,17 +1181,52 @@ void cElvisEPGMenu::Setup()
   int current = Current();
 
   Clear();
+  setupTimeM = time(NULL);
 
-  if (true) {
+  if (viewModeM == evmChannels) {
      LOCK_THREAD_INSTANCE(cElvisChannels::GetInstance());
      for (cElvisChannel *item = cElvisChannels::GetInstance()->First(); item; item = cElvisChannels::GetInstance()->Next(item)) {
          if (item->Name())
             Add(new cElvisChannelItem(item));
          }
      }
+  else {
+     cVector<cElvisEvent *> now, next;
+     LOCK_THREAD_INSTANCE(cElvisChannels::GetInstance());
+     // a single pass over the time index of each channel
+     cElvisChannels::GetInstance()->GetNowNext(setupTimeM, now, next);
+     cVector<cElvisEvent *> &events = (viewModeM == evmNow) ? now : next;
+     int i = 0;
+     for (cElvisChannel *item = cElvisChannels::GetInstance()->First(); item; item = cElvisChannels::GetInstance()->Next(item), ++i) {
+         if (item->Name())
+            Add(new cElvisChannelItem(item, events[i]));
+         }
+     }
 
   SetCurrent(Get(current));
   Display();
+  currentM = -1;
+  Prefetch();
+}
+
+void cElvisEPGMenu::Prefetch(int indexP)
+{
+  cElvisChannelItem *item = reinterpret_cast<cElvisChannelItem *>(Get(indexP));
+  if (item)
+     cElvisChannels::GetInstance()->Prefetch(item->Channel());
+}
+
+void cElvisEPGMenu::Prefetch()
+{
+  // in the on demand mode the channels next to the cursor are loaded ahead of time, the nearest ones first
+  if ((Current() == currentM) || !cElvisChannels::GetInstance()->IsLazy())
+     return;
+  currentM = Current();
+  for (int i = 0; i <= ePrefetchRange; ++i) {
+      Prefetch(currentM + i);
+      if (i)
+         Prefetch(currentM - i);
+      }
 }
 
 eOSState cElvisEPGMenu::Select()
@@ -1098,6 +1241,33 @@ eOSState cElvisEPGMenu::Select()
   return osContinue;
 }
 
+eOSState cElvisEPGMenu::Info()
+{
+  if (HasSubMenu() || Count() == 0)
+     return osContinue;
+
+  cElvisChannelItem *item = reinterpret_cast<cElvisChannelItem *>(Get(Current()));
+  if (item && item->Event())
+     return AddSubMenu(new cElvisChannelEventInfoMenu(item->Event(), item->Channel()->Name()));
+
+  return osContinue;
+}
+
+eOSState cElvisEPGMenu::SwitchView()
+{
+  if (HasSubMenu())
+     return osContinue;
+
+  viewModeM = (viewModeM + 1) % evmCount;
+  if (viewModeM == evmChannels)
+     SetCols(17);
+  else
+     SetCols(17, 6);
+  Setup();
+
+  return osContinue;
+}
+
 eOSState cElvisEPGMenu::ProcessKey(eKeys keyP)
 {
   eOSState state = cOsdMenu::ProcessKey(keyP);
@@ -1107,12 +1277,18 @@ eOSState cElvisEPGMenu::ProcessKey(eKeys keyP)
        case kRed:
        case kOk:
             return Select();
+       case kGreen:
+            return SwitchView();
+       case kBlue:
+       case kInfo:
+            return Info();
        case k5:
             cElvisChannels::GetInstance()->Update(true);
             return osContinue;
        case kNone:
             cElvisChannels::GetInstance()->Update();
-            if (cElvisChannels::GetInstance()->StateChanged(stateM)) {
+            // the now and next views follow the clock
+            if (cElvisChannels::GetInstance()->StateChanged(stateM) || ((viewModeM != evmChannels) && ((time(NULL) / 60) != (setupTimeM / 60)))) {
                Setup();
                SetHelpKeys();
                return osContinue;
@@ -1124,8 +1300,10 @@ eOSState cElvisEPGMenu::ProcessKey(eKeys keyP)
      state = osContinue;
      }
 
-  if (!HasSubMenu() && (keyP != kNone))
+  if (!HasSubMenu() && (keyP != kNone)) {
      SetHelpKeys();
+     Prefetch();
+     }
 
   return state;
 }
@@ -1165,6 +1343,7 @@ void cElvisTopEventsMenu::Setup()
 
   SetCurrent(Get(current));
   Display();
+  PrefetchInfo();
 }
 
 eOSState cElvisTopEventsMenu::Record(bool quickP)
@@ -1200,6 +1379,19 @@ eOSState cElvisTopEventsMenu::Info()
   return osContinue;
 }
 
+void cElvisTopEventsMenu::PrefetchInfo()
+{
+  cVector<int> rows, ids;
+
+  PrefetchRows(Current(), DisplayMenu() ? DisplayMenu()->MaxItems() : 0, Count(), rows);
+  for (int i = 0; i < rows.Size(); ++i) {
+      cElvisChannelEventItem *item = reinterpret_cast<cElvisChannelEventItem *>(Get(rows[i]));
+      if (item && item->Event())
+         ids.Append(item->Event()->Id());
+      }
+  cElvisInfoCache::GetInstance()->Prefetch(ids);
+}
+
 eOSState cElvisTopEventsMenu::ProcessKey(eKeys keyP)
 {
   bool HadSubMenu = HasSubMenu();
@@ -1239,8 +1431,10 @@ eOSState cElvisTopEventsMenu::ProcessKey(eKeys keyP)
         return osBack;
      }
 
-  if (!HasSubMenu() && (keyP != kNone))
+  if (!HasSubMenu() && (keyP != kNone)) {
      SetHelpKeys();
+     PrefetchInfo();
+     }
 
   return state;
 }
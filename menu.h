@@ -69,6 +69,7 @@ private:
   int stateM;
   void SetHelpKeys();
   void Setup();
+  void PrefetchInfo();
   eOSState Delete();
   eOSState Info();
   eOSState Play(bool rewindP = false);
@@ -86,7 +87,11 @@ private:
   int *folderIdsM;
   int numFoldersM;
   int folderM;
-  cElvisEvent *eventM;
+  int eventIdM;
+  cString nameM;
+  cString channelM;
+  time_t startTimeM;
+  time_t endTimeM;
   void Setup();
 public:
   cElvisTimerCreateMenu(cElvisEvent *eventP);
@@ -123,6 +128,7 @@ private:
   int stateM;
   void SetHelpKeys();
   void Setup();
+  void PrefetchInfo();
   eOSState Delete();
   eOSState Info();
 public:
@@ -204,8 +210,10 @@ public:
 class cElvisChannelEventsMenu : public cOsdMenu {
 private:
   cElvisChannel *channelM;
+  int stateM;
   void SetHelpKeys();
   void Setup();
+  void PrefetchInfo();
   eOSState Record(bool quickP = true);
   eOSState Info();
 public:
@@ -218,19 +226,37 @@ public:
 class cElvisChannelItem : public cOsdItem {
 private:
   cElvisChannel *channelM;
+  cElvisEvent *eventM;
 public:
-  cElvisChannelItem(cElvisChannel *channelP);
+  cElvisChannelItem(cElvisChannel *channelP, cElvisEvent *eventP = NULL);
   cElvisChannel *Channel() { return channelM; }
+  cElvisEvent *Event() { return eventM; }
 };
 
 // --- cElvisEPGMenu ---------------------------------------------------
 
 class cElvisEPGMenu : public cOsdMenu {
 private:
+  enum {
+    ePrefetchRange = 2 // channels on both sides of the cursor
+  };
+  enum eViewMode {
+    evmChannels = 0,
+    evmNow,
+    evmNext,
+    evmCount
+  };
   int stateM;
+  int currentM;
+  int viewModeM;
+  time_t setupTimeM;
   void SetHelpKeys();
   void Setup();
+  void Prefetch(int indexP);
+  void Prefetch();
   eOSState Select();
+  eOSState Info();
+  eOSState SwitchView();
 public:
   cElvisEPGMenu();
   virtual eOSState ProcessKey(eKeys keyP);
@@ -243,6 +269,7 @@ private:
   int stateM;
   void SetHelpKeys();
   void Setup();
+  void PrefetchInfo();
   eOSState Record(bool quickP = true);
   eOSState Info();
 public:
@@ -10,41 +10,56 @@
 
 #include "common.h"
 #include "log.h"
+#include "index.h"
 #include "menu.h"
 #include "resume.h"
+#include "transport.h"
 #include "player.h"
 
 // --- cElvisReader ----------------------------------------------------
 
-cElvisReader::cElvisReader(const char *urlP)
+cElvisReader::cElvisReader(const char *urlP, cCondWait *readyP, cElvisTimeIndex *indexP)
 : cThread("cElvisReader"),
   urlM(urlP),
+  readyM(readyP),
   rangeStartM(0),
   rangeSizeM(0),
   rangePendingM(0),
   durationM(0),
   pauseToggledM(false),
+  pauseRequestM(false),
+  seekRequestM(0),
   pausedM(false),
+  userPausedM(false),
   eofM(false),
   handleM(NULL),
   multiM(NULL),
   headerListM(NULL),
-  ringBufferM(new cRingBufferLinear(MEGABYTE(2), 7 * TS_SIZE))
+  bufferM(new cElvisBlockBuffer()),
+  indexerM(new cElvisTimeIndexer(indexP)),
+  uptimeM(),
+  seekStartM(0),
+  seekingM(false),
+  wakeupsM(0),
+  seeksM(0),
+  seekLatencyM(0),
+  seekLatencyMaxM(0),
+  cpuMsM(0)
 {
   debug1("%s", __PRETTY_FUNCTION__);
-  if (ringBufferM) {
-     ringBufferM->SetTimeouts(10, 0);
-     ringBufferM->SetIoThrottle();
-     }
   Start();
 }
 
 cElvisReader::~cElvisReader()
 {
   debug1("%s", __PRETTY_FUNCTION__);
+  // the loop sleeps in curl until something happens, so kick it to notice the cancellation
+  Cancel(-1);
+  Wakeup();
   Cancel(3);
   Disconnect();
-  DELETE_POINTER(ringBufferM);
+  DELETE_POINTER(indexerM);
+  DELETE_POINTER(bufferM);
 }
 
 int cElvisReader::DebugCallback(CURL *handleP, curl_infotype typeP, char *dataP, size_t sizeP, void *userPtrP)
@@ -125,68 +140,71 @@ void cElvisReader::SetDuration(unsigned long durationP)
 
 bool cElvisReader::PutData(uchar *dataP, int lenP)
 {
-  LOCK_THREAD;
+  // called by the thread itself, so only the buffer is shared with the player
   debug16("%s (%d)", __PRETTY_FUNCTION__, lenP);
   if (pausedM)
      return false;
-  if (ringBufferM && (lenP >= 0)) {
-     // should be pause the transfer?
-     if (ringBufferM->Free() < (2 * CURL_MAX_WRITE_SIZE)) {
-        debug5("%s (%d) Pausing free=%d available=%d", __PRETTY_FUNCTION__, lenP, ringBufferM->Free(), ringBufferM->Available());
-        pausedM = true;
+  if (seekingM) {
+     uint64_t latency = cTimeMs::Now() - seekStartM;
+     debug1("%s Seek latency %llums", __PRETTY_FUNCTION__, (unsigned long long)latency);
+     seekingM = false;
+     ++seeksM;
+     seekLatencyM += latency;
+     seekLatencyMaxM = max(seekLatencyMaxM, latency);
+     }
+  if (bufferM && (lenP >= 0)) {
+     // should be pause the transfer? curl delivers the whole chunk again after continuing
+     if ((bufferM->Free() < (2 * CURL_MAX_WRITE_SIZE)) || !bufferM->Put(dataP, lenP)) {
+        debug5("%s (%d) Pausing free=%d available=%d", __PRETTY_FUNCTION__, lenP, bufferM->Free(), bufferM->Available());
+        __atomic_store_n(&pausedM, true, __ATOMIC_RELAXED);
         return false;
         }
-     int p = ringBufferM->Put(dataP, lenP);
-     if (p != lenP)
-        ringBufferM->ReportOverflow(lenP - p);
+     if (indexerM)
+        indexerM->Put(dataP, lenP);
+     if (readyM)
+        readyM->Signal();
      }
 
   return true;
 }
 
+void cElvisReader::Continue()
+{
+  // the transfer paused for a full buffer can be continued, once there's room enough again
+  if (__atomic_load_n(&pausedM, __ATOMIC_RELAXED) && !__atomic_load_n(&userPausedM, __ATOMIC_RELAXED) && (bufferM->Free() > bufferM->Available()))
+     Wakeup();
+}
+
 void cElvisReader::DelData(int lenP)
 {
-  LOCK_THREAD;
   debug16("%s (%d)", __PRETTY_FUNCTION__, lenP);
-  if (ringBufferM && (lenP >= 0))
-     ringBufferM->Del(lenP);
+  if (bufferM && (lenP >= 0)) {
+     bufferM->Del(lenP);
+     Continue();
+     }
 }
 
 void cElvisReader::ClearData()
 {
-  LOCK_THREAD;
   debug16("%s", __PRETTY_FUNCTION__);
-  if (ringBufferM)
-     ringBufferM->Clear();
+  if (bufferM)
+     bufferM->Clear();
 }
 
 uchar *cElvisReader::GetData(int *lenP)
 {
-  LOCK_THREAD;
   debug16("%s", __PRETTY_FUNCTION__);
   uchar *p = NULL;
+  // check this first, so the data received right before the end of file isn't lost
+  bool eof = __atomic_load_n(&eofM, __ATOMIC_ACQUIRE);
   *lenP = 0;
-  if (ringBufferM) {
-     int count = 0;
-     p = ringBufferM->Get(count);
-     if (p && count >= TS_SIZE) {
-        if (*p != TS_SYNC_BYTE) {
-           for (int i = 1; i < count; ++i) {
-               if (p[i] == TS_SYNC_BYTE) {
-                  count = i;
-                  break;
-                  }
-               }
-           error("Skipped %d bytes to sync on TS packet\n", count);
-           ringBufferM->Del(count);
-           *lenP = 0;
-           return NULL;
-           }
-        }
-     count -= (count % TS_SIZE);
-     *lenP = count;
+  if (bufferM) {
+     p = bufferM->Get(*lenP);
+     // skipping the cleared blocks may have made room
+     if (!p)
+        Continue();
      }
-  if (eofM)
+  if (eof && !p)
      *lenP = -1;
 
   return p;
@@ -197,6 +215,10 @@ void cElvisReader::JumpRequest(unsigned long startbyteP)
   LOCK_THREAD;
   debug1("%s (%ld)", __PRETTY_FUNCTION__, startbyteP);
   rangePendingM = startbyteP;
+  if (rangePendingM) {
+     seekRequestM = cTimeMs::Now();
+     Wakeup();
+     }
 }
 
 void cElvisReader::Jump(unsigned long startbyteP)
@@ -205,9 +227,13 @@ void cElvisReader::Jump(unsigned long startbyteP)
   debug1("%s (%ld)", __PRETTY_FUNCTION__, startbyteP);
   rangePendingM = 0;
   rangeStartM = startbyteP;
+  seekStartM = seekRequestM;
+  seekingM = true;
   curl_multi_remove_handle(multiM, handleM);
-  if (ringBufferM)
-     ringBufferM->Clear();
+  if (bufferM)
+     bufferM->Clear();
+  if (indexerM)
+     indexerM->Reset(rangeStartM);
   curl_easy_setopt(handleM, CURLOPT_RANGE, *cString::sprintf("%ld-", rangeStartM));
   curl_multi_add_handle(multiM, handleM);
 }
@@ -217,7 +243,15 @@ void cElvisReader::Pause(bool onoffP)
   LOCK_THREAD;
   debug1("%s (%d)", __PRETTY_FUNCTION__, onoffP);
   pauseToggledM = true;
-  pausedM = onoffP;
+  pauseRequestM = onoffP;
+  Wakeup();
+}
+
+void cElvisReader::Wakeup()
+{
+  LOCK_THREAD;
+  if (multiM)
+     curl_multi_wakeup(multiM);
 }
 
 bool cElvisReader::Connect()
@@ -228,14 +262,14 @@ bool cElvisReader::Connect()
 
   // initialize the curl session
   if (!handleM)
-     handleM = curl_easy_init();
+     handleM = cElvisTransport::GetInstance()->Acquire();
   if (!multiM) {
      multiM = curl_multi_init();
      initialConnect = true;
      }
 
   if (handleM && multiM) {
-     pausedM = false;
+     __atomic_store_n(&pausedM, false, __ATOMIC_RELAXED);
      // verbose output
      curl_easy_setopt(handleM, CURLOPT_VERBOSE, 1L);
      curl_easy_setopt(handleM, CURLOPT_DEBUGFUNCTION, cElvisReader::DebugCallback);
@@ -247,24 +281,14 @@ bool cElvisReader::Connect()
      curl_easy_setopt(handleM, CURLOPT_HEADERFUNCTION, cElvisReader::HeaderCallback);
      curl_easy_setopt(handleM, CURLOPT_HEADERDATA, this);
 
-     // no progress meter and no signaling
-     curl_easy_setopt(handleM, CURLOPT_NOPROGRESS, 1L);
-     curl_easy_setopt(handleM, CURLOPT_NOSIGNAL, 1L);
-
      // set timeout
      curl_easy_setopt(handleM, CURLOPT_CONNECTTIMEOUT, 5L);
      curl_easy_setopt(handleM, CURLOPT_LOW_SPEED_LIMIT, 100L);
      curl_easy_setopt(handleM, CURLOPT_LOW_SPEED_TIME, 3L);
 
-     // set user-agent
-     curl_easy_setopt(handleM, CURLOPT_USERAGENT, *cString::sprintf("vdr-%s/%s", PLUGIN_NAME_I18N, VERSION));
-
      // limit download speed (bytes/s)
      curl_easy_setopt(handleM, CURLOPT_MAX_RECV_SPEED_LARGE, eMaxDownloadSpeedMBits * 131072L);
 
-     // follow location
-     curl_easy_setopt(handleM, CURLOPT_FOLLOWLOCATION, 1L);
-
      // set url
      curl_easy_setopt(handleM, CURLOPT_URL, *urlM);
 
@@ -302,7 +326,7 @@ bool cElvisReader::Disconnect()
      curl_multi_remove_handle(multiM, handleM);
      curl_multi_cleanup(multiM);
      multiM = NULL;
-     curl_easy_cleanup(handleM);
+     cElvisTransport::GetInstance()->Release(handleM);
      handleM = NULL;
      }
 
@@ -335,33 +359,42 @@ void cElvisReader::Action()
   debug1("%s Start", __PRETTY_FUNCTION__);
   // set to higher priority
   SetPriority(-1);
-  if (ringBufferM && Connect()) {
+  if (bufferM && Connect()) {
+     struct timespec start, stop;
+
+     clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
      while (Running()) {
            CURLMcode err;
-           int running_handles, maxfd;
-           fd_set fdread, fdwrite, fdexcep;
-           struct timeval timeout;
-
-           if (rangePendingM)
-              Jump(rangePendingM);
-
-           do {
-             err = curl_multi_perform(multiM, &running_handles);
-           } while (err == CURLM_CALL_MULTI_PERFORM);
+           int running_handles;
+           int timeout = eTimeoutMs;
 
            // shall be continue filling up the buffer?
            Lock();
+           if (rangePendingM)
+              Jump(rangePendingM);
            if (pauseToggledM) {
-              curl_easy_pause(handleM, pausedM ? CURLPAUSE_ALL : CURLPAUSE_CONT);
+              __atomic_store_n(&userPausedM, pauseRequestM, __ATOMIC_RELAXED);
+              if (userPausedM && !pausedM) {
+                 __atomic_store_n(&pausedM, true, __ATOMIC_RELAXED);
+                 curl_easy_pause(handleM, CURLPAUSE_ALL);
+                 }
               pauseToggledM = false;
               }
-           if (pausedM && (ringBufferM->Free() > ringBufferM->Available())) {
-              debug5("%s Continuing free=%d available=%d", __PRETTY_FUNCTION__, ringBufferM->Free(), ringBufferM->Available());
-              pausedM = false;
+           // the room made by the player must not undo a pause of the user
+           if (pausedM && !userPausedM && (bufferM->Free() > bufferM->Available())) {
+              debug5("%s Continuing free=%d available=%d", __PRETTY_FUNCTION__, bufferM->Free(), bufferM->Available());
+              __atomic_store_n(&pausedM, false, __ATOMIC_RELAXED);
               curl_easy_pause(handleM, CURLPAUSE_CONT);
               }
+           // a paused transfer has nothing to do until a request or the player wakes it up
+           if (pausedM)
+              timeout = eIdleTimeoutMs;
            Unlock();
 
+           do {
+             err = curl_multi_perform(multiM, &running_handles);
+           } while (err == CURLM_CALL_MULTI_PERFORM);
+
            // check end of file
            if (running_handles == 0) {
               int msgcount;
@@ -372,27 +405,34 @@ void cElvisReader::Action()
                  else {
                     if (msg->data.result != CURLE_OK)
                        info("%s %s (%d)", __PRETTY_FUNCTION__, curl_easy_strerror(msg->data.result), msg->data.result);
-                    eofM = true;
+                    __atomic_store_n(&eofM, true, __ATOMIC_RELEASE);
+                    if (readyM)
+                       readyM->Signal();
                     break;
                     }
                  }
               }
 
-           timeout.tv_sec  = 0;
-           timeout.tv_usec = eTimeoutMs * 1000;
-           FD_ZERO(&fdread);
-           FD_ZERO(&fdwrite);
-           FD_ZERO(&fdexcep);
-           err = curl_multi_fdset(multiM, &fdread, &fdwrite, &fdexcep, &maxfd);
-           if (maxfd >= 0)
-              select(maxfd + 1, &fdread, &fdwrite, &fdexcep, &timeout);
-           else
-              cCondWait::SleepMs(eTimeoutMs);
+           // curl shortens the timeout on its own, whenever its transfer timers are due
+           curl_multi_poll(multiM, NULL, 0, timeout, NULL);
+           ++wakeupsM;
            }
+     clock_gettime(CLOCK_THREAD_CPUTIME_ID, &stop);
+     cpuMsM = (stop.tv_sec - start.tv_sec) * 1000LL + (stop.tv_nsec - start.tv_nsec) / 1000000LL;
+     debug1("%s %s", __PRETTY_FUNCTION__, *Statistics());
      Disconnect();
      }
 }
 
+cString cElvisReader::Statistics()
+{
+  LOCK_THREAD;
+  uint64_t uptime = max(uptimeM.Elapsed(), (uint64_t)1);
+
+  return cString::sprintf("Reader: wakeups=%lu (%llu/h) cpu=%llums (%llums/h) seeks=%lu latency avg=%llums max=%llums skipped=%lu", wakeupsM,
+                          (unsigned long long)(wakeupsM * 3600000ULL / uptime), (unsigned long long)cpuMsM, (unsigned long long)(cpuMsM * 3600000ULL / uptime), seeksM, (unsigned long long)(seeksM ? seekLatencyM / seeksM : 0), (unsigned long long)seekLatencyMaxM, bufferM ? bufferM->Skipped() : 0);
+}
+
 // --- cElvisPlayer ----------------------------------------------------
 
 cElvisPlayer::cElvisPlayer(int programIdP, const char *urlP)
@@ -402,13 +442,12 @@ cElvisPlayer::cElvisPlayer(int programIdP, const char *urlP)
   trickSpeedM(0),
   programIdM(programIdP),
   durationM(0),
-  readerM(new cElvisReader(urlP)),
+  wakeupM(),
+  wakeupsM(0),
+  indexM(cElvisTimeIndexes::GetInstance()->Get(programIdP)),
+  readerM(new cElvisReader(urlP, &wakeupM, indexM)),
   readSizeM(0),
-  fileSizeM(0),
-  ringBufferM(new cRingBufferFrame(MEGABYTE(2))),
-  readFrameM(NULL),
-  playFrameM(NULL),
-  dropFrameM(NULL)
+  fileSizeM(0)
 {
   unsigned long offset = 0;
   unsigned long size = 0;
@@ -427,9 +466,11 @@ cElvisPlayer::~cElvisPlayer()
   debug1("%s", __PRETTY_FUNCTION__);
   Activate(false);
   DELETE_POINTER(readerM);
-  DELETE_POINTER(readFrameM);
-  DELETE_POINTER(ringBufferM);
   cElvisResumeItems::GetInstance()->Store(programIdM, IsEOF() ? 0 : readSizeM, fileSizeM);
+  if (indexM) {
+     indexM->Release();
+     indexM = NULL;
+     }
 }
 
 void cElvisPlayer::Activate(bool onP)
@@ -437,18 +478,50 @@ void cElvisPlayer::Activate(bool onP)
   debug1("%s (%d)", __PRETTY_FUNCTION__, onP);
   if (onP)
      Start();
-  else
+  else {
+     // the thread may be sleeping until the next command
+     Cancel(-1);
+     wakeupM.Signal();
      Cancel(9);
+     }
+}
+
+void cElvisPlayer::Wait(int timeoutMsP)
+{
+  wakeupM.Wait(timeoutMsP);
+  ++wakeupsM;
 }
 
 bool cElvisPlayer::IsEOF()
 {
   LOCK_THREAD;
+  int ms = 0;
+  if (durationM && indexM && indexM->GetTime(readSizeM, ms)) {
+     debug1("%s time=%d duration=%ld", __PRETTY_FUNCTION__, ms / 1000, durationM);
+     return ((unsigned long)ms / 1000 + eEOFMark >= durationM);
+     }
   unsigned long limit = durationM ? (durationM - eEOFMark) * (fileSizeM / durationM) : 0;
   debug1("%s readSize=%ld limit=%ld", __PRETTY_FUNCTION__, readSizeM, limit);
   return (readSizeM >= limit);
 }
 
+unsigned long cElvisPlayer::Current()
+{
+  int ms = 0;
+  // the index knows the times of the frames, whereas the constant bitrate is just a guess
+  if (indexM && indexM->GetTime(readSizeM, ms))
+     return (unsigned long)ms / 1000;
+  return (readerM && readerM->GetRangeSize() && durationM) ? (readSizeM / (readerM->GetRangeSize() / durationM)) : 0;
+}
+
+unsigned int cElvisPlayer::Progress()
+{
+  int ms = 0;
+  if (durationM && indexM && indexM->GetTime(readSizeM, ms))
+     return (unsigned int)min((unsigned long)ms / 10 / durationM, 100UL);
+  return (readerM && readerM->GetRangeSize()) ? (unsigned int)((double)readSizeM / (double)readerM->GetRangeSize() * 100.0) : 0;
+}
+
 void cElvisPlayer::TrickSpeed(int incrementP)
 {
   int nts = trickSpeedM + incrementP;
@@ -494,6 +567,7 @@ void cElvisPlayer::Play()
      playDirM = pdForward;
      if (readerM)
         readerM->Pause(false);
+     wakeupM.Signal();
      }
 }
 
@@ -520,10 +594,6 @@ void cElvisPlayer::Clear()
   debug1("%s", __PRETTY_FUNCTION__);
   if (readerM)
      readerM->ClearData();
-  playFrameM = NULL;
-  dropFrameM = NULL;
-  DELETE_POINTER(readFrameM);
-  ringBufferM->Clear();
   DeviceClear();
 }
 
@@ -572,6 +642,7 @@ void cElvisPlayer::Forward()
          error("%s Unknown playmode=%d", __PRETTY_FUNCTION__, playModeM);
          break;
     }
+  wakeupM.Signal();
 }
 
 void cElvisPlayer::Backward()
@@ -620,21 +691,31 @@ void cElvisPlayer::Backward()
          error("%s Unknown playmode=%d", __PRETTY_FUNCTION__, playModeM);
          break;
     }
+  wakeupM.Signal();
 }
 
 void cElvisPlayer::SkipTime(long secondsP, bool relativeP, bool playP)
 {
   LOCK_THREAD;
-  long skip = durationM ? secondsP * (fileSizeM / durationM) : 0;
-  debug1("%s (%ld, %d, %d): skip=%ld filesize=%ld", __PRETTY_FUNCTION__, secondsP, relativeP, playP, skip, fileSizeM);
-  if (!relativeP)
-     readSizeM = 0;
-  if ((skip < 0) && (readSizeM < (unsigned long)labs(skip)))
-     readSizeM = 0;
-  else if ((readSizeM + skip) > fileSizeM)
-     return;
-  else
-     readSizeM += skip;
+  unsigned long offset = 0;
+  if (indexM && (relativeP ? indexM->GetSkip(readSizeM, (int)secondsP * 1000, offset) : indexM->GetOffset((int)secondsP * 1000, offset))) {
+     debug1("%s (%ld, %d, %d): offset=%ld filesize=%ld", __PRETTY_FUNCTION__, secondsP, relativeP, playP, offset, fileSizeM);
+     if (fileSizeM && (offset > fileSizeM))
+        return;
+     readSizeM = offset;
+     }
+  else {
+     long skip = durationM ? secondsP * (fileSizeM / durationM) : 0;
+     debug1("%s (%ld, %d, %d): skip=%ld filesize=%ld", __PRETTY_FUNCTION__, secondsP, relativeP, playP, skip, fileSizeM);
+     if (!relativeP)
+        readSizeM = 0;
+     if ((skip < 0) && (readSizeM < (unsigned long)labs(skip)))
+        readSizeM = 0;
+     else if ((readSizeM + skip) > fileSizeM)
+        return;
+     else
+        readSizeM += skip;
+     }
   Clear();
   if (readerM)
      readerM->JumpRequest(readSizeM);
@@ -697,109 +778,89 @@ int cElvisPlayer::GetBackwardJumpPeriod()
 void cElvisPlayer::Action()
 {
   debug1("%s Start", __PRETTY_FUNCTION__);
-  if (ringBufferM) {
-     uchar *p = NULL;
-     int pc = 0;
-     bool sleep = false, firstPacket = true;
-     cTimeMs timeout;
+  if (readerM) {
+     bool poll = false, stalled = false, firstPacket = true;
+     int wait = 0;
+     cTimeMs timeout, uptime;
+     struct timespec start, stop;
 
+     clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
      while (Running()) {
-           if (sleep) {
+           // sleep until the reader or a command wakes us up, or the output takes more data; a jump
+           // clears the output and a pause freezes it, so a full output needs no shorter timeout
+           if (poll) {
               cPoller Poller;
-              DevicePoll(Poller, 10);
-              sleep = false;
+              bool ready = DevicePoll(Poller, eIdleTimeoutMs);
+              ++wakeupsM;
+              // to prevent busylooping with xineliboutput, which is ready without taking anything
+              if (ready && stalled)
+                 Wait(eBusyTimeoutMs);
+              stalled = ready;
+              poll = false;
+              }
+           else if (wait) {
+              Wait(wait);
+              wait = 0;
               }
            if (playModeM == pmPause) {
-              sleep = true;
+              // nothing to do until a command wakes us up
+              Wait(0);
               continue;
               }
            { // start of block
              LOCK_THREAD;
 
-             if (!readFrameM) {
-                if (playDirM == pdBackward) {
-                   if (timeout.TimedOut()) {
-                      timeout.Set(eTrickplayTimeoutMs);
-                      SkipTime(GetBackwardJumpPeriod(), true, false);
-                      }
-                   }
-                else if (Setup.MultiSpeedMode && (trickSpeedM > 2) && (playDirM == pdForward) && (playModeM == pmFast)) {
-                   if (timeout.TimedOut()) {
-                      timeout.Set(eTrickplayTimeoutMs);
-                      SkipTime(GetForwardJumpPeriod(), true, false);
-                      }
-                   }
-                if (readerM) {
-                   int len = 0;
-                   uchar *data = readerM->GetData(&len);
-                   if (fileSizeM == 0)
-                      fileSizeM = readerM->GetRangeSize();
-                   if (durationM == 0)
-                      durationM = readerM->GetDuration();
-                   if (len < 0) {
-                      debug1("%s EOF", __PRETTY_FUNCTION__);
-                      break;
-                      }
-                   else if (data && (len > 0)) {
-                      readSizeM += len;
-                      readFrameM = new cFrame(data, len, ftUnknown);
-                      readerM->DelData(len);
-                      }
+             if (playDirM == pdBackward) {
+                if (timeout.TimedOut()) {
+                   timeout.Set(eTrickplayTimeoutMs);
+                   SkipTime(GetBackwardJumpPeriod(), true, false);
                    }
                 }
-
-             if (readFrameM) {
-                if (ringBufferM->Put(readFrameM))
-                   readFrameM = NULL;
-                else
-                   sleep = true;
-                }
-
-             if (dropFrameM) {
-                ringBufferM->Drop(dropFrameM);
-                dropFrameM = NULL;
+             else if (Setup.MultiSpeedMode && (trickSpeedM > 2) && (playDirM == pdForward) && (playModeM == pmFast)) {
+                if (timeout.TimedOut()) {
+                   timeout.Set(eTrickplayTimeoutMs);
+                   SkipTime(GetForwardJumpPeriod(), true, false);
+                   }
                 }
 
-             if (!playFrameM) {
-                playFrameM = ringBufferM->Get();
-                p = NULL;
-                pc = 0;
+             // the packets are played straight out of the reader's buffer
+             int len = 0;
+             uchar *p = readerM->GetData(&len);
+             if (fileSizeM == 0)
+                fileSizeM = readerM->GetRangeSize();
+             if (durationM == 0)
+                durationM = readerM->GetDuration();
+             if (len < 0) {
+                debug1("%s EOF", __PRETTY_FUNCTION__);
+                break;
                 }
-
-             // to prevent busylooping with xineliboutput
-             if (!readFrameM && !playFrameM)
-                cCondWait::SleepMs(2);
-
-             if (playFrameM) {
-                if (!p) {
-                   p = playFrameM->Data();
-                   pc = playFrameM->Count();
-                   if (p && firstPacket) {
-                      PlayTs(NULL, 0);
-                      firstPacket = false;
-                      }
-                   }
-                if (p) {
-                   int w = PlayTs(p, pc);
-                   if (w > 0) {
-                      p += w;
-                      pc -= w;
-                      }
-                   else if (w < 0 && FATALERRNO)
-                      LOG_ERROR;
-                   else
-                      sleep = true;
+             else if (p && (len > 0)) {
+                if (firstPacket) {
+                   PlayTs(NULL, 0);
+                   firstPacket = false;
                    }
-                if (pc <= 0) {
-                   dropFrameM = playFrameM;
-                   playFrameM = NULL;
-                   p = NULL;
+                int w = PlayTs(p, len);
+                if (w > 0) {
+                   readSizeM += w;
+                   stalled = false;
                    }
+                else if (w < 0 && FATALERRNO)
+                   LOG_ERROR;
+                else
+                   poll = true;
+                readerM->DelData(max(w, 0));
+                }
+             else {
+                // nothing to play until the reader has received more, but the trick play jumps keep their pace
+                wait = ((playDirM == pdBackward) || (playModeM == pmFast)) ? eTrickplayTimeoutMs : eIdleTimeoutMs;
                 }
-             else
-                sleep = true;
            } // end of block
            }
+     clock_gettime(CLOCK_THREAD_CPUTIME_ID, &stop);
+     uint64_t cpu = (stop.tv_sec - start.tv_sec) * 1000LL + (stop.tv_nsec - start.tv_nsec) / 1000000LL;
+     uint64_t elapsed = max(uptime.Elapsed(), (uint64_t)1);
+     debug1("%s Stop wakeups=%lu (%llu/h) cpu=%llums (%llums/h)", __PRETTY_FUNCTION__, wakeupsM, (unsigned long long)(wakeupsM * 3600000ULL / elapsed),
+            (unsigned long long)cpu, (unsigned long long)(cpu * 3600000ULL / elapsed));
      }
 }
 
@@ -12,39 +12,60 @@
 #include <curl/easy.h>
 
 #include <vdr/player.h>
-#include <vdr/ringbuffer.h>
+
+#include "buffer.h"
+#include "index.h"
 
 // --- cElvisReader ----------------------------------------------------
 
 class cElvisReader : public cThread {
 private:
   enum {
-    eTimeoutMs             = 10, // in milliseconds
-    eMaxDownloadSpeedMBits = 18  // in megabits per second
+    eTimeoutMs             = 1000,  // in milliseconds
+    eIdleTimeoutMs         = 60000, // in milliseconds
+    eMaxDownloadSpeedMBits = 18     // in megabits per second
   };
   static int DebugCallback(CURL *handleP, curl_infotype typeP, char *dataP, size_t sizeP, void *userPtrP);
   static size_t WriteCallback(void *ptrP, size_t sizeP, size_t nmembP, void *dataP);
   static size_t HeaderCallback(void *ptrP, size_t sizeP, size_t nmembP, void *dataP);
   const cString urlM;
+  cCondWait *readyM;
   unsigned long rangeStartM;
   unsigned long rangeSizeM;
   unsigned long rangePendingM;
   unsigned long durationM;
+  // the commands of the player, taken over by the next loop round
   bool pauseToggledM;
-  bool pausedM;
+  bool pauseRequestM;
+  uint64_t seekRequestM;
+  // owned by the thread, but peeked at by the player
+  bool pausedM;     // the transfer is paused either by the user or for a full buffer
+  bool userPausedM; // only the user continues it
   bool eofM;
   CURL *handleM;
   CURLM *multiM;
   struct curl_slist *headerListM;
-  cRingBufferLinear *ringBufferM;
+  cElvisBlockBuffer *bufferM;
+  cElvisTimeIndexer *indexerM;
+  cTimeMs uptimeM;
+  uint64_t seekStartM;
+  bool seekingM;
+  unsigned long wakeupsM;
+  unsigned long seeksM;
+  uint64_t seekLatencyM;
+  uint64_t seekLatencyMaxM;
+  uint64_t cpuMsM;
   bool Connect();
   bool Disconnect();
   void Retry();
   void Jump(unsigned long startbyteP);
+  void Wakeup();
+  void Continue();
 protected:
   virtual void Action();
 public:
-  cElvisReader(const char *urlP);
+  // the given condition is signalled whenever there's new data or the end of file
+  cElvisReader(const char *urlP, cCondWait *readyP, cElvisTimeIndex *indexP);
   virtual ~cElvisReader();
   void SetRange(unsigned long startP, unsigned long stopP, unsigned long sizeP);
   void SetDuration(unsigned long durationP);
@@ -57,6 +78,7 @@ public:
   unsigned long GetRangeStart() { return rangeStartM; }
   unsigned long GetRangeSize() { return rangeSizeM; }
   unsigned long GetDuration() { return durationM; }
+  cString Statistics();
 };
 
 // --- cElvisPlayer ----------------------------------------------------
@@ -64,9 +86,11 @@ public:
 class cElvisPlayer : public cPlayer, cThread {
 private:
   enum {
-    eTrickplayJumpBase  = 2,   // in seconds
-    eTrickplayTimeoutMs = 750, // in milliseconds
-    eEOFMark            = 15   // in seconds
+    eTrickplayJumpBase  = 2,    // in seconds
+    eTrickplayTimeoutMs = 750,  // in milliseconds
+    eIdleTimeoutMs      = 1000, // in milliseconds
+    eBusyTimeoutMs      = 2,    // in milliseconds
+    eEOFMark            = 15    // in seconds
   };
   enum ePlayModes {
     pmPlay,
@@ -83,14 +107,14 @@ private:
   int trickSpeedM;
   int programIdM;
   unsigned long durationM;
+  cCondWait wakeupM;
+  unsigned long wakeupsM;
+  cElvisTimeIndex *indexM;
   cElvisReader *readerM;
   unsigned long readSizeM;
   unsigned long fileSizeM;
-  cRingBufferFrame *ringBufferM;
-  cFrame *readFrameM;
-  cFrame *playFrameM;
-  cFrame *dropFrameM;
   bool IsEOF();
+  void Wait(int timeoutMsP);
   void TrickSpeed(int incrementP);
   int GetForwardJumpPeriod();
   int GetBackwardJumpPeriod();
@@ -108,8 +132,8 @@ public:
   void SkipTime(long secondsP, bool relativeP = true, bool playP = true);
   bool Finished() { return !Active(); }
   unsigned long Total() { return durationM; }
-  unsigned long Current() { return (readerM && readerM->GetRangeSize() && durationM) ? (readSizeM / (readerM->GetRangeSize() / durationM)) : 0; }
-  unsigned int Progress() { return (readerM && readerM->GetRangeSize()) ? (unsigned int)((double)readSizeM / (double)readerM->GetRangeSize() * 100.0) : 0; }
+  unsigned long Current();
+  unsigned int Progress();
   void ClearJump() { if (readerM) readerM->JumpRequest(0); }
   bool GetReplayMode(bool &playP, bool &forwardP, int &speedP);
 };
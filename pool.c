@@ -0,0 +1,264 @@
+/*
+ * pool.c: Elvis plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#include <stddef.h>
+
+#include "common.h"
+#include "log.h"
+#include "pool.h"
+
+// --- cElvisStringPool ------------------------------------------------
+
+cElvisStringPool *cElvisStringPool::instanceS = NULL;
+
+cElvisStringPool *cElvisStringPool::GetInstance()
+{
+  if (!instanceS)
+     instanceS = new cElvisStringPool();
+
+  return instanceS;
+}
+
+void cElvisStringPool::Destroy()
+{
+  DELETE_POINTER(instanceS);
+}
+
+unsigned int cElvisStringPool::Hash(const char *strP)
+{
+  // FNV-1a
+  unsigned int hash = 2166136261U;
+  for (const unsigned char *p = (const unsigned char *)strP; *p; ++p)
+      hash = (hash ^ *p) * 16777619U;
+
+  return hash;
+}
+
+cElvisStringPool::cEntry *cElvisStringPool::Entry(const char *strP)
+{
+  return (cEntry *)(strP - offsetof(cEntry, str));
+}
+
+cElvisStringPool::cElvisStringPool()
+: bucketsM(NULL),
+  sizeM(0),
+  countM(0),
+  hitsM(0),
+  bytesM(0)
+{
+  debug1("%s", __PRETTY_FUNCTION__);
+  Grow();
+}
+
+cElvisStringPool::~cElvisStringPool()
+{
+  debug1("%s", __PRETTY_FUNCTION__);
+  cMutexLock MutexLock(&mutexM);
+  for (unsigned int i = 0; i < sizeM; ++i) {
+      while (bucketsM[i]) {
+            cEntry *e = bucketsM[i];
+            bucketsM[i] = e->next;
+            free(e);
+            }
+      }
+  free(bucketsM);
+}
+
+void cElvisStringPool::Grow()
+{
+  unsigned int size = sizeM ? (sizeM * 2) : eInitialBuckets;
+  cEntry **buckets = (cEntry **)calloc(size, sizeof(cEntry *));
+
+  if (!buckets) {
+     error("%s Out of memory (%u)", __PRETTY_FUNCTION__, size);
+     return;
+     }
+  for (unsigned int i = 0; i < sizeM; ++i) {
+      while (bucketsM[i]) {
+            cEntry *e = bucketsM[i];
+            bucketsM[i] = e->next;
+            e->next = buckets[e->hash & (size - 1)];
+            buckets[e->hash & (size - 1)] = e;
+            }
+      }
+  free(bucketsM);
+  bucketsM = buckets;
+  sizeM = size;
+}
+
+const char *cElvisStringPool::Acquire(const char *strP)
+{
+  if (!strP || !bucketsM)
+     return NULL;
+
+  cMutexLock MutexLock(&mutexM);
+  unsigned int hash = Hash(strP);
+  for (cEntry *e = bucketsM[hash & (sizeM - 1)]; e; e = e->next) {
+      if ((e->hash == hash) && !strcmp(e->str, strP)) {
+         ++e->refs;
+         ++hitsM;
+         return e->str;
+         }
+      }
+  size_t len = strlen(strP);
+  cEntry *e = (cEntry *)malloc(offsetof(cEntry, str) + len + 1);
+  if (!e) {
+     error("%s Out of memory (%zu)", __PRETTY_FUNCTION__, len);
+     return NULL;
+     }
+  memcpy(e->str, strP, len + 1);
+  e->hash = hash;
+  e->refs = 1;
+  e->next = bucketsM[hash & (sizeM - 1)];
+  bucketsM[hash & (sizeM - 1)] = e;
+  bytesM += len + 1;
+  if (++countM > sizeM)
+     Grow();
+
+  return e->str;
+}
+
+void cElvisStringPool::AddRef(const char *strP)
+{
+  if (strP) {
+     cMutexLock MutexLock(&mutexM);
+     ++Entry(strP)->refs;
+     }
+}
+
+void cElvisStringPool::Release(const char *strP)
+{
+  if (strP) {
+     cMutexLock MutexLock(&mutexM);
+     cEntry *entry = Entry(strP);
+     if (--entry->refs > 0)
+        return;
+     for (cEntry **e = &bucketsM[entry->hash & (sizeM - 1)]; *e; e = &(*e)->next) {
+         if (*e == entry) {
+            *e = entry->next;
+            break;
+            }
+         }
+     bytesM -= strlen(entry->str) + 1;
+     --countM;
+     free(entry);
+     }
+}
+
+cString cElvisStringPool::Statistics()
+{
+  cMutexLock MutexLock(&mutexM);
+
+  return cString::sprintf("Strings: count=%u bytes=%lu shared=%lu", countM, bytesM, hitsM);
+}
+
+// --- cElvisString ----------------------------------------------------
+
+cElvisString::cElvisString(const char *strP)
+: strM(cElvisStringPool::GetInstance()->Acquire(strP))
+{
+}
+
+cElvisString::cElvisString(const cElvisString &strP)
+: strM(strP.strM)
+{
+  cElvisStringPool::GetInstance()->AddRef(strM);
+}
+
+cElvisString::~cElvisString()
+{
+  cElvisStringPool::GetInstance()->Release(strM);
+}
+
+cElvisString &cElvisString::operator=(const cElvisString &strP)
+{
+  if (strM != strP.strM) {
+     cElvisStringPool::GetInstance()->AddRef(strP.strM);
+     cElvisStringPool::GetInstance()->Release(strM);
+     strM = strP.strM;
+     }
+
+  return *this;
+}
+
+cElvisString &cElvisString::operator=(const char *strP)
+{
+  const char *str = cElvisStringPool::GetInstance()->Acquire(strP);
+
+  cElvisStringPool::GetInstance()->Release(strM);
+  strM = str;
+
+  return *this;
+}
+
+// --- cElvisStringArena -----------------------------------------------
+
+cElvisStringArena::cElvisStringArena(size_t chunkSizeP)
+: chunksM(NULL),
+  chunkSizeM(chunkSizeP),
+  bytesM(0),
+  reservedM(0)
+{
+}
+
+cElvisStringArena::~cElvisStringArena()
+{
+  Clear();
+}
+
+const char *cElvisStringArena::Store(const char *strP)
+{
+  if (!strP)
+     return NULL;
+
+  size_t len = strlen(strP) + 1;
+  if (!chunksM || ((chunksM->size - chunksM->used) < len)) {
+     // an oversized string gets a chunk of its own
+     size_t size = max(len, chunkSizeM);
+     cChunk *chunk = (cChunk *)malloc(offsetof(cChunk, data) + size);
+     if (!chunk) {
+        error("%s Out of memory (%zu)", __PRETTY_FUNCTION__, size);
+        return NULL;
+        }
+     chunk->next = chunksM;
+     chunk->size = size;
+     chunk->used = 0;
+     chunksM = chunk;
+     reservedM += offsetof(cChunk, data) + size;
+     }
+  char *str = chunksM->data + chunksM->used;
+  memcpy(str, strP, len);
+  chunksM->used += len;
+  bytesM += len;
+
+  return str;
+}
+
+void cElvisStringArena::Swap(cElvisStringArena &arenaP)
+{
+  cChunk *chunks = chunksM;
+  size_t bytes = bytesM;
+  size_t reserved = reservedM;
+
+  chunksM = arenaP.chunksM;
+  bytesM = arenaP.bytesM;
+  reservedM = arenaP.reservedM;
+  arenaP.chunksM = chunks;
+  arenaP.bytesM = bytes;
+  arenaP.reservedM = reserved;
+}
+
+void cElvisStringArena::Clear()
+{
+  while (chunksM) {
+        cChunk *chunk = chunksM;
+        chunksM = chunk->next;
+        free(chunk);
+        }
+  bytesM = 0;
+  reservedM = 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * pool.h: Elvis plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#ifndef __ELVIS_POOL_H
+#define __ELVIS_POOL_H
+
+#include <vdr/thread.h>
+#include <vdr/tools.h>
+
+// --- cElvisStringPool ------------------------------------------------
+
+class cElvisStringPool {
+private:
+  enum {
+    eInitialBuckets = 1024
+  };
+  struct cEntry {
+    cEntry *next;
+    unsigned int hash;
+    int refs;
+    char str[1];
+  };
+  static cElvisStringPool *instanceS;
+  static cEntry *Entry(const char *strP);
+  cMutex mutexM;
+  cEntry **bucketsM;
+  unsigned int sizeM;
+  unsigned int countM;
+  unsigned long hitsM;
+  unsigned long bytesM;
+  void Grow();
+  // constructor
+  cElvisStringPool();
+  // to prevent copy constructor and assignment
+  cElvisStringPool(const cElvisStringPool&);
+  cElvisStringPool& operator=(const cElvisStringPool&);
+public:
+  static cElvisStringPool *GetInstance();
+  static void Destroy();
+  static unsigned int Hash(const char *strP);
+  virtual ~cElvisStringPool();
+  const char *Acquire(const char *strP);
+  void AddRef(const char *strP);
+  void Release(const char *strP);
+  cString Statistics();
+};
+
+// --- cElvisString ----------------------------------------------------
+
+// an interned, reference counted string shared by every holder of the same value
+class cElvisString {
+private:
+  const char *strM;
+public:
+  cElvisString(const char *strP = NULL);
+  cElvisString(const cElvisString &strP);
+  ~cElvisString();
+  cElvisString &operator=(const cElvisString &strP);
+  cElvisString &operator=(const char *strP);
+  const char *operator*() const { return strM; }
+};
+
+// --- cElvisStringArena -----------------------------------------------
+
+// a bump allocator for the strings of one generation of data, which are freed all at once
+class cElvisStringArena {
+private:
+  enum {
+    eChunkSize = KILOBYTE(64)
+  };
+  struct cChunk {
+    cChunk *next;
+    size_t size;
+    size_t used;
+    char data[1];
+  };
+  cChunk *chunksM;
+  size_t chunkSizeM;
+  size_t bytesM;
+  size_t reservedM;
+  // to prevent copy constructor and assignment
+  cElvisStringArena(const cElvisStringArena&);
+  cElvisStringArena& operator=(const cElvisStringArena&);
+public:
+  cElvisStringArena(size_t chunkSizeP = eChunkSize);
+  ~cElvisStringArena();
+  const char *Store(const char *strP);
+  void Swap(cElvisStringArena &arenaP);
+  void Clear();
+  size_t Bytes() const { return bytesM; }
+  size_t Reserved() const { return reservedM; }
+};
+
+#endif // __ELVIS_POOL_H
@@ -7,6 +7,7 @@
 
 #include "common.h"
 #include "config.h"
+#include "info.h"
 #include "recordings.h"
 
 // --- cElvisRecording -------------------------------------------------
@@ -53,14 +54,17 @@ cElvisRecording::~cElvisRecording()
 cElvisWidgetEventInfo *cElvisRecording::Info()
 {
   if (!infoM)
-     infoM = cElvisWidget::GetInstance()->GetEventInfo(programIdM);
+     infoM = cElvisInfoCache::GetInstance()->GetEventInfo(programIdM);
 
  return infoM;
 }
 
 void cElvisRecording::DeleteInfo()
 {
-  DELETE_POINTER(infoM);
+  if (infoM) {
+     infoM->Release();
+     infoM = NULL;
+     }
 }
 
 // --- cElvisRecordingFolder -------------------------------------------
@@ -145,16 +149,15 @@ void cElvisRecordingFolder::Refresh(bool foregroundP)
   lastUpdateM = time(NULL);
   {
     LOCK_THREAD;
-    if (foregroundP) {
-       Clear();
-       ChangeState();
-       }
-    else {
-       for (cElvisRecording *i = cList<cElvisRecording>::First(); i; i = cList<cElvisRecording>::Next(i))
-           i->Tag(false);
-       }
+    // the current items remain visible until the reply replaces them
+    if (foregroundP)
+       Validate(false);
+    for (cElvisRecording *i = cList<cElvisRecording>::First(); i; i = cList<cElvisRecording>::Next(i))
+        i->Tag(false);
   }
-  cElvisWidget::GetInstance()->GetRecordings(*this, folderIdM);
+  bool result = cElvisWidget::GetInstance()->GetRecordings(*this, folderIdM);
+  if (!result || !IsValid() || IsNotModified())
+     return;
   {
     LOCK_THREAD;
     for (cElvisRecording *i = cList<cElvisRecording>::First(); i; i = cList<cElvisRecording>::Next(i)) {
@@ -190,8 +193,31 @@ bool cElvisRecordingFolder::StateChanged(int &stateP)
   return result;
 }
 
+void cElvisRecordingFolder::Snapshot(cElvisSnapshot::cWriter &writerP)
+{
+  LOCK_THREAD;
+  for (cElvisRecording *i = cList<cElvisRecording>::First(); i; i = cList<cElvisRecording>::Next(i)) {
+      cElvisSnapshot::cRecord *r = writerP.Append(cElvisSnapshot::esRecordings);
+      if (!r)
+         return;
+      r->id = i->Id();
+      r->values[0] = folderIdM;
+      r->values[1] = i->IsFolder();
+      r->values[2] = i->ProgramId();
+      r->values[3] = i->FolderId();
+      r->values[4] = i->Count();
+      r->values[5] = i->LengthInMinutes();
+      r->strings[0] = writerP.String(i->Name());
+      r->strings[1] = writerP.String(i->Channel());
+      r->strings[2] = writerP.String(i->StartTime());
+      r->strings[3] = writerP.String(i->Size());
+      }
+}
+
 void cElvisRecordingFolder::Action()
 {
+  cElvisWidgetPriority priority(cElvisWidgetPriority::epBackground);
+
   Refresh();
 }
 
@@ -202,8 +228,10 @@ cElvisRecordings *cElvisRecordings::instanceS = NULL;
 
 cElvisRecordings *cElvisRecordings::GetInstance()
 {
-  if (!instanceS)
+  if (!instanceS) {
      instanceS = new cElvisRecordings();
+     instanceS->Restore();
+     }
 
   return instanceS;
 }
@@ -216,7 +244,8 @@ void cElvisRecordings::Destroy()
 cElvisRecordings::cElvisRecordings()
 : cThread("cElvisRecordings"),
   stateM(0),
-  lastUpdateM(0)
+  lastUpdateM(0),
+  refreshedM(false)
 {
   AddFolder(-1, tr("(default)"));
 }
@@ -239,8 +268,10 @@ void cElvisRecordings::AddFolder(int folderIdP, const char *folderNameP, int cou
          }
       }
 
-  if (folder)
+  if (folder) {
+     folder->Tag(true);
      folder->UpdateFolder(protectedP, countP);
+     }
   else {
      folder = new cElvisRecordingFolder(folderIdP, folderNameP);
      if (folder) {
@@ -335,17 +366,19 @@ void cElvisRecordings::Refresh(bool foregroundP)
   lastUpdateM = time(NULL);
   {
     LOCK_THREAD;
-    if (foregroundP) {
-       Clear();
-       AddFolder(-1, tr("(default)"));
-       ChangeState();
-       }
-    else {
-       for (cElvisRecordingFolder *i = cList<cElvisRecordingFolder>::First(); i; i = cList<cElvisRecordingFolder>::Next(i))
-           i->Tag(false);
-       }
+    // the current folders remain visible until the reply replaces them
+    if (foregroundP)
+       Validate(false);
+    for (cElvisRecordingFolder *i = cList<cElvisRecordingFolder>::First(); i; i = cList<cElvisRecordingFolder>::Next(i))
+        i->Tag(false);
+    AddFolder(-1, tr("(default)"))->Tag(true);
   }
-  cElvisWidget::GetInstance()->GetFolders(*this);
+  bool result = cElvisWidget::GetInstance()->GetFolders(*this);
+  if (!result || !IsValid())
+     return;
+  refreshedM = true;
+  if (IsNotModified())
+     return;
   {
     LOCK_THREAD;
     for (cElvisRecordingFolder *i = cList<cElvisRecordingFolder>::First(); i; i = cList<cElvisRecordingFolder>::Next(i)) {
@@ -358,7 +391,45 @@ void cElvisRecordings::Refresh(bool foregroundP)
   }
 }
 
+void cElvisRecordings::Restore()
+{
+  cElvisSnapshot *snapshot = cElvisSnapshot::GetInstance();
+
+  // the folders first, so the recordings find their parents
+  for (int i = 0; i < snapshot->Count(cElvisSnapshot::esFolders); ++i) {
+      const cElvisSnapshot::cRecord *r = snapshot->Record(cElvisSnapshot::esFolders, i);
+      AddFolder(r->id, snapshot->String(r->strings[0]), r->values[0], r->values[1]);
+      }
+  for (int i = 0; i < snapshot->Count(cElvisSnapshot::esRecordings); ++i) {
+      const cElvisSnapshot::cRecord *r = snapshot->Record(cElvisSnapshot::esRecordings, i);
+      cElvisRecordingFolder *folder = GetFolder(r->values[0]);
+      if (!folder)
+         continue;
+      if (r->values[1])
+         folder->AddFolder(r->id, r->values[4], snapshot->String(r->strings[0]), snapshot->String(r->strings[3]));
+      else
+         folder->AddRecording(r->id, r->values[2], r->values[3], r->values[4], r->values[5], snapshot->String(r->strings[0]), snapshot->String(r->strings[1]), snapshot->String(r->strings[2]));
+      }
+}
+
+void cElvisRecordings::Snapshot(cElvisSnapshot::cWriter &writerP)
+{
+  LOCK_THREAD;
+  for (cElvisRecordingFolder *i = First(); i; i = Next(i)) {
+      cElvisSnapshot::cRecord *r = writerP.Append(cElvisSnapshot::esFolders);
+      if (!r)
+         return;
+      r->id = i->Id();
+      r->values[0] = i->RecordingCount();
+      r->values[1] = i->IsProtected();
+      r->strings[0] = writerP.String(i->Name());
+      i->Snapshot(writerP);
+      }
+}
+
 void cElvisRecordings::Action()
 {
+  cElvisWidgetPriority priority(cElvisWidgetPriority::epBackground);
+
   Refresh();
 }
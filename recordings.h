@@ -11,6 +11,8 @@
 #include <vdr/thread.h>
 #include <vdr/tools.h>
 
+#include "pool.h"
+#include "snapshot.h"
 #include "widget.h"
 
 // --- cElvisRecording -------------------------------------------------
@@ -26,8 +28,8 @@ private:
   int countM;
   int lengthM;
   cString nameM;
-  cString channelM;
-  cString startTimeM;
+  cElvisString channelM;
+  cElvisString startTimeM;
   cString sizeM;
   cElvisWidgetEventInfo *infoM;
   time_t startTimeValueM;
@@ -52,6 +54,7 @@ public:
   const char *Name() { return *nameM; }
   const char *Channel() { return *channelM; }
   const char *StartTime() { return *startTimeM; }
+  const char *Size() { return *sizeM; }
   time_t StartTimeValue() { return startTimeValueM; }
   bool IsFolder() { return (programIdM < 0); }
   bool IsProtected() { return protectedM; }
@@ -96,6 +99,8 @@ public:
   const char *Name() { return *folderNameM; }
   void SetName(const char *nameP) { folderNameM = nameP; }
   bool IsProtected() { return protectedM; }
+  int RecordingCount() { return countM; }
+  void Snapshot(cElvisSnapshot::cWriter &writerP);
 };
 
 // --- cElvisRecordings ------------------------------------------------
@@ -108,7 +113,9 @@ private:
   static cElvisRecordings *instanceS;
   int stateM;
   time_t lastUpdateM;
+  bool refreshedM; // in this run, so the snapshot is worth saving
   void Refresh(bool foregroundP = false);
+  void Restore();
   // constructor
   cElvisRecordings();
   // to prevent copy constructor and assignment
@@ -119,6 +126,7 @@ protected:
 public:
   static cElvisRecordings *GetInstance();
   static void Destroy();
+  static bool IsRefreshed() { return instanceS && instanceS->refreshedM; }
   virtual ~cElvisRecordings();
   virtual void AddFolder(int folderIdP, const char *folderNameP, int countP, bool protectedP);
   cElvisRecordingFolder *AddFolder(int folderIdP, const char *folderNameP);
@@ -130,6 +138,7 @@ public:
   bool Update(bool waitP = false);
   void ChangeState(void) { ++stateM; }
   bool StateChanged(int &stateP);
+  void Snapshot(cElvisSnapshot::cWriter &writerP);
 };
 
 #endif // __ELVIS_RECORDINGS_H
@@ -108,6 +108,7 @@ void cElvisSearchTimers::Refresh(bool foregroundP)
     LOCK_THREAD;
     if (foregroundP) {
        Clear();
+       Validate(false);
        ChangeState();
        }
     else {
@@ -116,6 +117,8 @@ void cElvisSearchTimers::Refresh(bool foregroundP)
        }
   }
   cElvisWidget::GetInstance()->GetSearchTimers(*this);
+  if (IsNotModified())
+     return;
   {
     LOCK_THREAD;
     for (cElvisSearchTimer *i = First(); i; i = Next(i)) {
@@ -150,5 +153,7 @@ bool cElvisSearchTimers::StateChanged(int &stateP)
 
 void cElvisSearchTimers::Action()
 {
+  cElvisWidgetPriority priority(cElvisWidgetPriority::epBackground);
+
   Refresh();
 }
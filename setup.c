@@ -15,7 +15,9 @@ cPluginElvisSetup::cPluginElvisSetup()
 : hideMenuM(ElvisConfig.GetHideMenu()),
   replaceScheduleM(ElvisConfig.GetReplaceSchedule()),
   replaceTimersM(ElvisConfig.GetReplaceTimers()),
-  replaceRecordingsM(ElvisConfig.GetReplaceRecordings())
+  replaceRecordingsM(ElvisConfig.GetReplaceRecordings()),
+  requestRateM(ElvisConfig.GetRequestRate()),
+  lazyEPGM(ElvisConfig.GetLazyEPG())
 {
   strn0cpy(usernameM, ElvisConfig.GetUsername(), sizeof(usernameM));
   strn0cpy(passwordM, ElvisConfig.GetPassword(), sizeof(passwordM));
@@ -46,6 +48,12 @@ void cPluginElvisSetup::Setup()
   Add(new cMenuEditHiddenStrItem(tr("Password"), passwordM, sizeof(passwordM)));
   helpM.Append(tr("Define your Elisa Viihde password."));
 
+  Add(new cMenuEditIntItem(tr("Request rate limit [1/s]"), &requestRateM, 0, 100, tr("unlimited")));
+  helpM.Append(tr("Define how many requests per second are sent to the server. Interactive requests are always served before the background ones."));
+
+  Add(new cMenuEditBoolItem(tr("Load EPG"), &lazyEPGM, tr("all channels"), tr("on demand")));
+  helpM.Append(tr("Define whether the whole EPG is downloaded at once or each channel only when it's browsed."));
+
 #if defined(MAINMENUHOOKSVERSNUM)
   Add(new cMenuEditBoolItem(tr("Replace 'Schedule' in main menu"), &replaceScheduleM));
   helpM.Append(tr("Define whether this plugin replaces the original 'Schedule' entry in the main menu. MainMenuHook patch is required."));
@@ -94,6 +102,8 @@ void cPluginElvisSetup::Store()
   ElvisConfig.SetReplaceSchedule(replaceScheduleM);
   ElvisConfig.SetReplaceTimers(replaceTimersM);
   ElvisConfig.SetReplaceRecordings(replaceRecordingsM);
+  ElvisConfig.SetRequestRate(requestRateM);
+  ElvisConfig.SetLazyEPG(lazyEPGM);
   ElvisConfig.Save();
   cElvisWidget::GetInstance()->Invalidate();
 }
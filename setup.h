@@ -19,6 +19,8 @@ private:
   int replaceScheduleM;
   int replaceTimersM;
   int replaceRecordingsM;
+  int requestRateM;
+  int lazyEPGM;
   char usernameM[CREDENTIALS_MAX];
   char passwordM[CREDENTIALS_MAX];
   cVector<const char*> helpM;
@@ -0,0 +1,303 @@
+/*
+ * snapshot.c: Elvis plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "log.h"
+#include "events.h"
+#include "recordings.h"
+#include "timers.h"
+#include "snapshot.h"
+
+// --- cElvisSnapshot::cWriter -----------------------------------------
+
+cElvisSnapshot::cWriter::cWriter()
+{
+  memset(dataM, 0, sizeof(dataM));
+  memset(sizeM, 0, sizeof(sizeM));
+  memset(lengthM, 0, sizeof(lengthM));
+  // the offset zero of the string table stands for none
+  Put(esCount, "", 1);
+}
+
+cElvisSnapshot::cWriter::~cWriter()
+{
+  for (int i = 0; i <= esCount; ++i)
+      free(dataM[i]);
+}
+
+bool cElvisSnapshot::cWriter::Put(int indexP, const void *dataP, size_t lenP)
+{
+  if (lengthM[indexP] + lenP > sizeM[indexP]) {
+     size_t size = sizeM[indexP] ? sizeM[indexP] : KILOBYTE(64);
+     while (size < lengthM[indexP] + lenP)
+           size *= 2;
+     char *p = (char *)realloc(dataM[indexP], size);
+     if (!p) {
+        error("%s Out of memory (%zu)", __PRETTY_FUNCTION__, size);
+        return false;
+        }
+     dataM[indexP] = p;
+     sizeM[indexP] = size;
+     }
+  memcpy(dataM[indexP] + lengthM[indexP], dataP, lenP);
+  lengthM[indexP] += lenP;
+
+  return true;
+}
+
+cElvisSnapshot::cRecord *cElvisSnapshot::cWriter::Append(eSection sectionP)
+{
+  cRecord record;
+
+  memset(&record, 0, sizeof(record));
+  if (Put(sectionP, &record, sizeof(record)))
+     return (cRecord *)(dataM[sectionP] + lengthM[sectionP] - sizeof(record));
+
+  return NULL;
+}
+
+uint32_t cElvisSnapshot::cWriter::String(const char *strP)
+{
+  size_t offset = lengthM[esCount];
+
+  if (!strP || !Put(esCount, strP, strlen(strP) + 1))
+     return 0;
+
+  return (uint32_t)offset;
+}
+
+bool cElvisSnapshot::cWriter::Write(const char *fileNameP)
+{
+  cString tmpName = cString::sprintf("%s.tmp", fileNameP);
+  cHeader header;
+  size_t offset = sizeof(header);
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, "ELVS", sizeof(header.magic));
+  header.version = eVersion;
+  header.recordSize = sizeof(cRecord);
+  header.created = time(NULL);
+  for (int i = 0; i < esCount; ++i) {
+      header.sections[i].offset = (uint32_t)offset;
+      header.sections[i].count = (uint32_t)(lengthM[i] / sizeof(cRecord));
+      offset += lengthM[i];
+      }
+  header.stringsOffset = (uint32_t)offset;
+  header.stringsSize = (uint32_t)lengthM[esCount];
+
+  // write a temporary file first, so a crash never leaves a truncated snapshot behind
+  FILE *f = fopen(*tmpName, "w");
+  if (!f) {
+     error("%s (%s) Cannot open: %m", __PRETTY_FUNCTION__, *tmpName);
+     return false;
+     }
+  bool result = (fwrite(&header, sizeof(header), 1, f) == 1);
+  for (int i = 0; result && (i <= esCount); ++i) {
+      if (lengthM[i] && (fwrite(dataM[i], lengthM[i], 1, f) != 1))
+         result = false;
+      }
+  if (fclose(f) != 0)
+     result = false;
+  if (result && (rename(*tmpName, fileNameP) == 0))
+     return true;
+
+  error("%s (%s) Cannot write: %m", __PRETTY_FUNCTION__, fileNameP);
+  unlink(*tmpName);
+
+  return false;
+}
+
+// --- cElvisSnapshot --------------------------------------------------
+
+const char *cElvisSnapshot::snapshotBaseNameS = "snapshot.bin";
+
+cElvisSnapshot *cElvisSnapshot::instanceS = NULL;
+
+cElvisSnapshot *cElvisSnapshot::GetInstance()
+{
+  if (!instanceS)
+     instanceS = new cElvisSnapshot();
+
+  return instanceS;
+}
+
+void cElvisSnapshot::Destroy()
+{
+  DELETE_POINTER(instanceS);
+}
+
+cElvisSnapshot::cElvisSnapshot()
+: fileNameM(""),
+  mapM(NULL),
+  mapSizeM(0),
+  headerM(NULL)
+{
+}
+
+cElvisSnapshot::~cElvisSnapshot()
+{
+  cMutexLock MutexLock(&mutexM);
+  Unmap();
+}
+
+void cElvisSnapshot::Unmap()
+{
+  if (mapM)
+     munmap((void *)mapM, mapSizeM);
+  mapM = NULL;
+  mapSizeM = 0;
+  headerM = NULL;
+}
+
+bool cElvisSnapshot::Load(const char *directoryP)
+{
+  cMutexLock MutexLock(&mutexM);
+  struct stat st;
+
+  Unmap();
+  fileNameM = directoryP ? *cString::sprintf("%s/%s", directoryP, snapshotBaseNameS) : "";
+  if (isempty(*fileNameM) || access(*fileNameM, R_OK))
+     return false;
+
+  int fd = open(*fileNameM, O_RDONLY);
+  if (fd < 0) {
+     error("%s (%s) Cannot open: %m", __PRETTY_FUNCTION__, *fileNameM);
+     return false;
+     }
+  if ((fstat(fd, &st) == 0) && (st.st_size >= (off_t)sizeof(cHeader))) {
+     void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+     if (map != MAP_FAILED) {
+        mapM = (const uchar *)map;
+        mapSizeM = st.st_size;
+        }
+     }
+  close(fd);
+  if (!mapM)
+     return false;
+
+  // validate everything up front, so the accessors can trust the offsets
+  const cHeader *header = (const cHeader *)mapM;
+  bool valid = !memcmp(header->magic, "ELVS", sizeof(header->magic)) && (header->version == eVersion) && (header->recordSize == sizeof(cRecord)) &&
+               (header->stringsSize > 0) && ((size_t)header->stringsOffset + header->stringsSize <= mapSizeM) &&
+               (mapM[header->stringsOffset + header->stringsSize - 1] == 0);
+  for (int i = 0; valid && (i < esCount); ++i) {
+      if (((header->sections[i].offset % sizeof(int64_t)) != 0) ||
+          ((size_t)header->sections[i].offset + (size_t)header->sections[i].count * sizeof(cRecord) > mapSizeM))
+         valid = false;
+      }
+  if (!valid) {
+     error("%s (%s) Invalid snapshot", __PRETTY_FUNCTION__, *fileNameM);
+     Unmap();
+     return false;
+     }
+  headerM = header;
+  debug1("%s (%s) Mapped %zu bytes created at %s", __PRETTY_FUNCTION__, *fileNameM, mapSizeM, *TimeToString(header->created));
+
+  return true;
+}
+
+bool cElvisSnapshot::Save()
+{
+  cMutexLock MutexLock(&mutexM);
+  cWriter writer;
+
+  if (isempty(*fileNameM))
+     return false;
+
+  // the lists not refreshed in this run, because they weren't used or the server couldn't be reached, are carried
+  // forward from the previous snapshot, which remains mapped even after the new one replaces it
+  bool changed = false;
+  int copied = 0;
+  if (cElvisChannels::IsRefreshed()) {
+     cElvisChannels::GetInstance()->Snapshot(writer);
+     changed = true;
+     }
+  else
+     copied += CopySection(writer, esEPG);
+  if (cElvisTopEvents::IsRefreshed()) {
+     cElvisTopEvents::GetInstance()->Snapshot(writer);
+     changed = true;
+     }
+  else
+     copied += CopySection(writer, esTopEvents);
+  if (cElvisTimers::IsRefreshed()) {
+     cElvisTimers::GetInstance()->Snapshot(writer);
+     changed = true;
+     }
+  else
+     copied += CopySection(writer, esTimers);
+  if (cElvisRecordings::IsRefreshed()) {
+     cElvisRecordings::GetInstance()->Snapshot(writer);
+     changed = true;
+     }
+  else {
+     copied += CopySection(writer, esFolders);
+     copied += CopySection(writer, esRecordings);
+     }
+  if (!changed && !copied) {
+     debug1("%s (%s) Nothing to save", __PRETTY_FUNCTION__, *fileNameM);
+     return false;
+     }
+
+  bool result = writer.Write(*fileNameM);
+  debug1("%s (%s) Saved: %d", __PRETTY_FUNCTION__, *fileNameM, result);
+
+  return result;
+}
+
+int cElvisSnapshot::CopySection(cWriter &writerP, eSection sectionP)
+{
+  // called with the lock held
+  time_t now = time(NULL);
+  int copied = 0;
+
+  for (int i = 0; i < Count(sectionP); ++i) {
+      const cRecord *r = Record(sectionP, i);
+      // the ended events would be dropped by the next restore anyway
+      if (((sectionP == esEPG) || (sectionP == esTopEvents)) && (r->end <= now))
+         continue;
+      cRecord *w = writerP.Append(sectionP);
+      if (!w)
+         break;
+      *w = *r;
+      // the string table is rebuilt, so the offsets change
+      for (unsigned int j = 0; j < sizeof(w->strings) / sizeof(w->strings[0]); ++j)
+          w->strings[j] = writerP.String(String(r->strings[j]));
+      ++copied;
+      }
+  if (copied)
+     debug1("%s (%d) Carried %d records forward", __PRETTY_FUNCTION__, sectionP, copied);
+
+  return copied;
+}
+
+int cElvisSnapshot::Count(eSection sectionP)
+{
+  return headerM ? (int)headerM->sections[sectionP].count : 0;
+}
+
+const cElvisSnapshot::cRecord *cElvisSnapshot::Record(eSection sectionP, int indexP)
+{
+  if (headerM && (indexP >= 0) && (indexP < Count(sectionP)))
+     return (const cRecord *)(mapM + headerM->sections[sectionP].offset) + indexP;
+
+  return NULL;
+}
+
+const char *cElvisSnapshot::String(uint32_t offsetP)
+{
+  if (headerM && (offsetP > 0) && (offsetP < headerM->stringsSize))
+     return (const char *)(mapM + headerM->stringsOffset + offsetP);
+
+  return NULL;
+}
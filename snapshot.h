@@ -0,0 +1,100 @@
+/*
+ * snapshot.h: Elvis plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#ifndef __ELVIS_SNAPSHOT_H
+#define __ELVIS_SNAPSHOT_H
+
+#include <stdint.h>
+
+#include <vdr/thread.h>
+#include <vdr/tools.h>
+
+// --- cElvisSnapshot --------------------------------------------------
+
+// a versioned binary image of the downloaded lists, which is mapped into memory as is:
+// a header, the fixed size records of each section and a table of nul terminated strings
+class cElvisSnapshot {
+public:
+  enum eSection {
+    esEPG = 0,         // id, start, end; strings: channel, name, description
+    esTopEvents,       // id, start, end; strings: channel, name
+    esTimers,          // id, values: length; strings: name, channel, start time, wildcard
+    esFolders,         // id, values: count, protected; strings: name
+    esRecordings,      // id, values: parent folder, is folder, program id, folder id, count, length; strings: name, channel, start time, size
+    esCount
+  };
+  struct cRecord {
+    int64_t start;
+    int64_t end;
+    int32_t id;
+    int32_t values[6];
+    uint32_t strings[4]; // offsets to the string table, zero for none
+    uint32_t reserved;
+  };
+  class cWriter {
+  private:
+    char *dataM[esCount + 1];
+    size_t sizeM[esCount + 1];
+    size_t lengthM[esCount + 1];
+    bool Put(int indexP, const void *dataP, size_t lenP);
+    // to prevent copy constructor and assignment
+    cWriter(const cWriter&);
+    cWriter& operator=(const cWriter&);
+  public:
+    cWriter();
+    ~cWriter();
+    // the returned record is zeroed and valid until the next one is appended
+    cRecord *Append(eSection sectionP);
+    uint32_t String(const char *strP);
+    bool Write(const char *fileNameP);
+  };
+private:
+  enum {
+    eVersion = 1
+  };
+  struct cHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t stringsOffset;
+    uint32_t stringsSize;
+    uint32_t reserved;
+    int64_t created;
+    struct {
+      uint32_t offset;
+      uint32_t count;
+    } sections[esCount];
+  };
+  static const char *snapshotBaseNameS;
+  static cElvisSnapshot *instanceS;
+  cMutex mutexM;
+  cString fileNameM;
+  const uchar *mapM;
+  size_t mapSizeM;
+  const cHeader *headerM;
+  void Unmap();
+  // copies a section of the previous snapshot into the new one and returns the number of records
+  int CopySection(cWriter &writerP, eSection sectionP);
+  // constructor
+  cElvisSnapshot();
+  // to prevent copy constructor and assignment
+  cElvisSnapshot(const cElvisSnapshot&);
+  cElvisSnapshot& operator=(const cElvisSnapshot&);
+public:
+  static cElvisSnapshot *GetInstance();
+  static void Destroy();
+  virtual ~cElvisSnapshot();
+  // maps the snapshot of the previous run; the lists restore their sections when they are first used
+  bool Load(const char *directoryP);
+  // collects the current lists into a new snapshot
+  bool Save();
+  int Count(eSection sectionP);
+  const cRecord *Record(eSection sectionP, int indexP);
+  const char *String(uint32_t offsetP);
+};
+
+#endif // __ELVIS_SNAPSHOT_H
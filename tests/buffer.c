@@ -0,0 +1,215 @@
+/*
+ * buffer.c: Elvis plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "test.h"
+#include "../buffer.h"
+
+// the capacity of the ring
+#define CAPACITY (32 * 348 * TS_SIZE)
+
+// the packets carry their sequence number right after the header
+static void MakePacket(uchar *p, unsigned int seqP)
+{
+  memset(p, 0xFF, TS_SIZE);
+  p[0] = TS_SYNC_BYTE;
+  memcpy(p + 4, &seqP, sizeof(seqP));
+}
+
+static unsigned int Sequence(const uchar *p)
+{
+  unsigned int seq;
+
+  memcpy(&seq, p + 4, sizeof(seq));
+
+  return seq;
+}
+
+static void TestBasic()
+{
+  cElvisBlockBuffer buffer;
+  uchar data[10 * TS_SIZE];
+  int len;
+
+  CHECK(buffer.Free() == CAPACITY);
+  CHECK(buffer.Available() == 0);
+  CHECK(buffer.Get(len) == NULL);
+
+  for (int i = 0; i < 10; ++i)
+      MakePacket(data + i * TS_SIZE, i);
+  CHECK(buffer.Put(data, sizeof(data)));
+  CHECK(buffer.Available() == (int)sizeof(data));
+  CHECK(buffer.Free() + buffer.Available() == CAPACITY);
+
+  // the newest block is handed out while it's still being written
+  uchar *p = buffer.Get(len);
+  CHECK(p && (len == (int)sizeof(data)));
+  if (p) {
+     CHECK(Sequence(p) == 0);
+     CHECK(Sequence(p + 9 * TS_SIZE) == 9);
+     }
+  buffer.Del(4 * TS_SIZE);
+  p = buffer.Get(len);
+  CHECK(p && (len == 6 * TS_SIZE) && (Sequence(p) == 4));
+  buffer.Del(len);
+  CHECK(buffer.Get(len) == NULL);
+  CHECK(buffer.Skipped() == 0);
+}
+
+static void TestFull()
+{
+  cElvisBlockBuffer buffer;
+  uchar data[100 * TS_SIZE];
+  unsigned int seq = 0;
+  int len;
+
+  for (;;) {
+      for (int i = 0; i < 100; ++i)
+          MakePacket(data + i * TS_SIZE, seq + i);
+      if (!buffer.Put(data, sizeof(data)))
+         break;
+      seq += 100;
+      }
+  // nothing of the rejected chunk may have been stored
+  CHECK(buffer.Free() < (int)sizeof(data));
+  CHECK(buffer.Available() == (int)(seq * TS_SIZE));
+
+  // everything comes out in order, one block at a time
+  unsigned int expected = 0;
+  uchar *p;
+  while ((p = buffer.Get(len)) != NULL) {
+        CHECK((len % TS_SIZE) == 0);
+        for (int i = 0; i < len; i += TS_SIZE)
+            CHECK(Sequence(p + i) == expected++);
+        buffer.Del(len);
+        }
+  CHECK(expected == seq);
+}
+
+static void TestSync()
+{
+  cElvisBlockBuffer buffer;
+  uchar data[5 + 4 * TS_SIZE];
+  int len;
+
+  // the stream may start in the middle of a packet
+  memset(data, 0x11, 5);
+  for (int i = 0; i < 4; ++i)
+      MakePacket(data + 5 + i * TS_SIZE, i);
+  CHECK(buffer.Put(data, sizeof(data)));
+  CHECK(buffer.Skipped() == 5);
+  uchar *p = buffer.Get(len);
+  CHECK(p && (len == 4 * TS_SIZE) && (Sequence(p) == 0));
+}
+
+static void TestClear()
+{
+  cElvisBlockBuffer buffer;
+  uchar data[3 * TS_SIZE];
+  int len;
+
+  for (int i = 0; i < 3; ++i)
+      MakePacket(data + i * TS_SIZE, i);
+  CHECK(buffer.Put(data, sizeof(data)));
+  buffer.Clear();
+  CHECK(buffer.Get(len) == NULL);
+
+  // the data after a jump starts over in a block of its own, skipping to the next packet
+  uchar jump[7 + 2 * TS_SIZE];
+  memset(jump, 0x22, 7);
+  MakePacket(jump + 7, 100);
+  MakePacket(jump + 7 + TS_SIZE, 101);
+  CHECK(buffer.Put(jump, sizeof(jump)));
+  uchar *p = buffer.Get(len);
+  CHECK(p && (len == 2 * TS_SIZE) && (Sequence(p) == 100));
+  CHECK(buffer.Skipped() == 7);
+}
+
+// --- streaming -------------------------------------------------------
+
+#define STREAM_PACKETS 2000000 // about 376 MB
+
+static cElvisBlockBuffer *streamBufferS = NULL;
+static unsigned long producerRetriesS = 0;
+
+static void *Producer(void *)
+{
+  // the transfer delivers chunks that don't follow the packet boundaries
+  static const int sizes[] = { 16384, 1000, 7 * TS_SIZE + 3, 4096, 188 * 50 - 1 };
+  static uchar stream[TS_SIZE * 200];
+  unsigned int seq = 0;
+  int pos = 0, fill = 0, n = 0;
+
+  while (seq < STREAM_PACKETS || fill > pos) {
+        while ((fill - pos < 16384) && (seq < STREAM_PACKETS)) {
+              if (fill + TS_SIZE > (int)sizeof(stream)) {
+                 memmove(stream, stream + pos, fill - pos);
+                 fill -= pos;
+                 pos = 0;
+                 }
+              MakePacket(stream + fill, seq++);
+              fill += TS_SIZE;
+              }
+        int len = min(sizes[n++ % 5], fill - pos);
+        while (!streamBufferS->Put(stream + pos, len)) {
+              ++producerRetriesS;
+              sched_yield();
+              }
+        pos += len;
+        }
+
+  return NULL;
+}
+
+static void TestStream()
+{
+  cElvisBlockBuffer buffer;
+  pthread_t thread;
+  unsigned int expected = 0;
+  uint64_t start = TestNow();
+
+  streamBufferS = &buffer;
+  CHECK(pthread_create(&thread, NULL, Producer, NULL) == 0);
+  while (expected < STREAM_PACKETS) {
+        int len;
+        uchar *p = buffer.Get(len);
+        if (!p) {
+           sched_yield();
+           continue;
+           }
+        // the consumer plays whatever whole packets it gets, not necessarily all of them
+        len = min(len, 10 * TS_SIZE);
+        for (int i = 0; i < len; i += TS_SIZE) {
+            if (Sequence(p + i) != expected) {
+               CHECK(Sequence(p + i) == expected);
+               expected = STREAM_PACKETS;
+               break;
+               }
+            ++expected;
+            }
+        buffer.Del(len);
+        }
+  pthread_join(thread, NULL);
+  CHECK(buffer.Skipped() == 0);
+
+  uint64_t us = max(TestNow() - start, (uint64_t)1);
+  printf("buffer: streamed %d packets in %llu ms (%llu MB/s), producer retries=%lu\n", STREAM_PACKETS, (unsigned long long)(us / 1000),
+         (unsigned long long)((uint64_t)STREAM_PACKETS * TS_SIZE / us), producerRetriesS);
+}
+
+int main()
+{
+  TestBasic();
+  TestFull();
+  TestSync();
+  TestClear();
+  TestStream();
+
+  return TestResult("buffer");
+}
@@ -0,0 +1,190 @@
+/*
+ * index.c: Elvis plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#include "test.h"
+#include "../index.h"
+
+// a frame every two seconds at a constant bitrate
+#define FRAME_BYTES (1000 * TS_SIZE)
+#define FRAME_TICKS (2 * PTSTICKS)
+#define FRAME_MS    2000
+
+static void TestEmpty()
+{
+  cElvisTimeIndex *index = new cElvisTimeIndex(1);
+  unsigned long offset;
+  int ms;
+
+  CHECK(!index->GetTime(0, ms));
+  CHECK(!index->GetOffset(0, offset));
+  CHECK(!index->GetSkip(0, 1000, offset));
+
+  // a single frame tells nothing about the bitrate
+  index->Add(0, 1000, true);
+  CHECK(index->Count() == 1);
+  CHECK(!index->GetTime(FRAME_BYTES, ms));
+  index->Release();
+}
+
+static void TestInterpolation()
+{
+  cElvisTimeIndex *index = new cElvisTimeIndex(2);
+  int64_t pts = 1234567;
+  unsigned long offset;
+  int ms;
+
+  index->Add(0, pts, true);
+  for (int i = 1; i <= 10; ++i)
+      index->Add(i * FRAME_BYTES, pts + i * FRAME_TICKS, false);
+  CHECK(index->Count() == 11);
+
+  // at and between the entries
+  CHECK(index->GetTime(3 * FRAME_BYTES, ms) && (ms == 3 * FRAME_MS));
+  CHECK(index->GetTime(3 * FRAME_BYTES + FRAME_BYTES / 2, ms) && (ms == 3 * FRAME_MS + FRAME_MS / 2));
+  CHECK(index->GetOffset(5 * FRAME_MS, offset) && (offset == 5 * FRAME_BYTES));
+  CHECK(index->GetOffset(5 * FRAME_MS + FRAME_MS / 4, offset) && (offset == 5 * FRAME_BYTES + FRAME_BYTES / 4));
+  CHECK((offset % TS_SIZE) == 0);
+  CHECK(index->GetSkip(2 * FRAME_BYTES, 3 * FRAME_MS, offset) && (offset == 5 * FRAME_BYTES));
+  CHECK(index->GetSkip(8 * FRAME_BYTES, -6 * FRAME_MS, offset) && (offset == 2 * FRAME_BYTES));
+  CHECK(index->GetOffset(-1000, offset) && (offset == 0));
+
+  // beyond the indexed part at the average bitrate, as the span is long enough
+  CHECK(index->GetTime(15 * FRAME_BYTES, ms) && (ms == 15 * FRAME_MS));
+  CHECK(index->GetOffset(20 * FRAME_MS, offset) && (offset == 20 * FRAME_BYTES));
+  CHECK(index->GetSkip(9 * FRAME_BYTES, 10 * FRAME_MS, offset) && (offset == 19 * FRAME_BYTES));
+  index->Release();
+}
+
+static void TestShortSpan()
+{
+  cElvisTimeIndex *index = new cElvisTimeIndex(3);
+  unsigned long offset;
+  int ms;
+
+  // too short for extrapolating, but fine for interpolating
+  index->Add(0, 0, true);
+  for (int i = 1; i <= 3; ++i)
+      index->Add(i * FRAME_BYTES, i * FRAME_TICKS, false);
+  CHECK(index->GetTime(FRAME_BYTES / 2, ms) && (ms == FRAME_MS / 2));
+  CHECK(!index->GetTime(4 * FRAME_BYTES, ms));
+  CHECK(!index->GetOffset(4 * FRAME_MS, offset));
+  index->Release();
+}
+
+static void TestSparse()
+{
+  cElvisTimeIndex *index = new cElvisTimeIndex(4);
+
+  // the frames closer than a second to an indexed one are left out
+  index->Add(0, 0, true);
+  for (int i = 1; i <= 50; ++i)
+      index->Add(i * FRAME_BYTES / 10, i * FRAME_TICKS / 10, false);
+  CHECK(index->Count() == 11);
+  index->Release();
+}
+
+static void TestOutOfOrder()
+{
+  cElvisTimeIndex *index = new cElvisTimeIndex(5);
+  int ms;
+
+  // a jump ahead indexes the later part first and the earlier one after jumping back
+  index->Add(0, 0, true);
+  for (int i = 20; i <= 30; ++i)
+      index->Add(i * FRAME_BYTES, i * FRAME_TICKS, false);
+  for (int i = 1; i < 20; ++i)
+      index->Add(i * FRAME_BYTES, i * FRAME_TICKS, false);
+  CHECK(index->Count() == 31);
+  CHECK(index->GetTime(19 * FRAME_BYTES + FRAME_BYTES / 2, ms) && (ms == 19 * FRAME_MS + FRAME_MS / 2));
+  index->Release();
+}
+
+static void TestDiscontinuity()
+{
+  cElvisTimeIndex *index = new cElvisTimeIndex(6);
+  unsigned long offset;
+  int ms;
+
+  index->Add(0, 0, true);
+  for (int i = 1; i <= 10; ++i)
+      index->Add(i * FRAME_BYTES, i * FRAME_TICKS, false);
+  // the timestamps start over in the middle of the stream
+  for (int i = 11; i <= 20; ++i)
+      index->Add(i * FRAME_BYTES, (i - 11) * FRAME_TICKS + PTSTICKS / 2, false);
+  CHECK(index->Count() == 11);
+  // an entry out of order with its neighbours on either side
+  index->Add(5 * FRAME_BYTES + FRAME_BYTES / 2, 8 * FRAME_TICKS, false);
+  index->Add(5 * FRAME_BYTES + FRAME_BYTES / 2, 2 * FRAME_TICKS, false);
+  // the same offset again with a different time
+  index->Add(5 * FRAME_BYTES, 5 * FRAME_TICKS + 3 * PTSTICKS, false);
+  CHECK(index->Count() == 11);
+
+  // the searches still agree with each other
+  for (int i = 0; i <= 20 * FRAME_MS; i += 500) {
+      CHECK(index->GetOffset(i, offset));
+      CHECK(index->GetTime(offset, ms) && (abs(ms - i) <= 1));
+      }
+  index->Release();
+}
+
+static void TestWrap()
+{
+  cElvisTimeIndex *index = new cElvisTimeIndex(7);
+  int64_t pts = MAX33BIT - 3 * FRAME_TICKS;
+  int ms;
+
+  // the timestamps wrap around after about 26.5 hours
+  index->Add(0, pts, true);
+  for (int i = 1; i <= 10; ++i)
+      index->Add(i * FRAME_BYTES, (pts + i * FRAME_TICKS) & MAX33BIT, false);
+  CHECK(index->Count() == 11);
+  CHECK(index->GetTime(7 * FRAME_BYTES, ms) && (ms == 7 * FRAME_MS));
+  index->Release();
+}
+
+// --- timing ----------------------------------------------------------
+
+#define BENCH_ENTRIES 3600 // two hours
+#define BENCH_LOOKUPS 1000000
+
+static void BenchLookups()
+{
+  cElvisTimeIndex *index = new cElvisTimeIndex(8);
+  unsigned long offset, sum = 0;
+
+  uint64_t start = TestNow();
+  index->Add(0, 0, true);
+  for (int i = 1; i < BENCH_ENTRIES; ++i)
+      index->Add(i * FRAME_BYTES, i * FRAME_TICKS, false);
+  uint64_t addUs = TestNow() - start;
+  CHECK(index->Count() == BENCH_ENTRIES);
+
+  start = TestNow();
+  for (unsigned int i = 0; i < BENCH_LOOKUPS; ++i) {
+      if (index->GetSkip((unsigned long)(i * 2654435761U % BENCH_ENTRIES) * FRAME_BYTES, 60000, offset))
+         sum += offset;
+      }
+  uint64_t skipUs = TestNow() - start;
+  CHECK(sum > 0);
+
+  printf("index: %d entries added in %llu us, %d skips in %llu ms\n", BENCH_ENTRIES, (unsigned long long)addUs, BENCH_LOOKUPS, (unsigned long long)(skipUs / 1000));
+  index->Release();
+}
+
+int main()
+{
+  TestEmpty();
+  TestInterpolation();
+  TestShortSpan();
+  TestSparse();
+  TestOutOfOrder();
+  TestDiscontinuity();
+  TestWrap();
+  BenchLookups();
+
+  return TestResult("index");
+}
@@ -0,0 +1,125 @@
+/*
+ * pool.c: Elvis plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#include "test.h"
+#include "../pool.h"
+
+static void TestArena()
+{
+  cElvisStringArena arena(64);
+  const char *s[100];
+  char buf[32];
+
+  CHECK(arena.Store(NULL) == NULL);
+  CHECK(arena.Bytes() == 0);
+  CHECK(arena.Reserved() == 0);
+
+  // the strings stay put while the following ones fill up further chunks
+  for (int i = 0; i < 100; ++i) {
+      snprintf(buf, sizeof(buf), "event %d", i);
+      s[i] = arena.Store(buf);
+      }
+  for (int i = 0; i < 100; ++i) {
+      snprintf(buf, sizeof(buf), "event %d", i);
+      CHECK(s[i] && !strcmp(s[i], buf));
+      }
+  size_t bytes = arena.Bytes();
+  CHECK(bytes == 10 * 8 + 90 * 9);
+  CHECK(arena.Reserved() >= bytes);
+
+  // an oversized string gets a chunk of its own
+  char big[1000];
+  memset(big, 'x', sizeof(big) - 1);
+  big[sizeof(big) - 1] = 0;
+  const char *b = arena.Store(big);
+  CHECK(b && (strlen(b) == sizeof(big) - 1));
+  CHECK(arena.Bytes() == bytes + sizeof(big));
+  CHECK(!strcmp(s[99], "event 99"));
+
+  // swapping hands over the strings without copying them
+  cElvisStringArena other;
+  const char *o = other.Store("other");
+  arena.Swap(other);
+  CHECK(!strcmp(o, "other") && (arena.Bytes() == 6));
+  CHECK(!strcmp(b, big) && (other.Bytes() == bytes + sizeof(big)));
+
+  arena.Clear();
+  CHECK((arena.Bytes() == 0) && (arena.Reserved() == 0));
+  CHECK(!strcmp(s[0], "event 0"));
+}
+
+static void TestPool()
+{
+  cElvisStringPool *pool = cElvisStringPool::GetInstance();
+  char buf[32];
+
+  strcpy(buf, "Uutiset");
+  const char *a = pool->Acquire(buf);
+  strcpy(buf, "Uutiset");
+  const char *b = pool->Acquire(buf);
+  CHECK(a && (a == b) && (a != buf));
+  CHECK(pool->Acquire(NULL) == NULL);
+  pool->Release(b);
+  CHECK(!strcmp(a, "Uutiset"));
+
+  {
+  cElvisString s1("Elokuva");
+  cElvisString s2(s1);
+  cElvisString s3;
+  s3 = "Elokuva";
+  CHECK((*s1 == *s2) && (*s2 == *s3));
+  s3 = s1;
+  CHECK(*s3 == *s1);
+  s3 = "Sarja";
+  CHECK(*s3 != *s1 && !strcmp(*s3, "Sarja"));
+  }
+
+  pool->Release(a);
+  cElvisStringPool::Destroy();
+}
+
+// --- timing ----------------------------------------------------------
+
+#define BENCH_STRINGS 1000000
+
+static void BenchArena()
+{
+  static char names[64][40];
+  cElvisStringArena arena;
+  const char **strs = (const char **)malloc(BENCH_STRINGS * sizeof(char *));
+
+  for (int i = 0; i < 64; ++i)
+      snprintf(names[i], sizeof(names[i]), "Ohjelma numero %d: jakso %d", i, i * 7);
+
+  uint64_t start = TestNow();
+  for (int i = 0; i < BENCH_STRINGS; ++i)
+      strs[i] = arena.Store(names[i % 64]);
+  uint64_t arenaUs = TestNow() - start;
+  arena.Clear();
+  uint64_t clearUs = TestNow() - start - arenaUs;
+
+  start = TestNow();
+  for (int i = 0; i < BENCH_STRINGS; ++i)
+      strs[i] = strdup(names[i % 64]);
+  uint64_t mallocUs = TestNow() - start;
+  for (int i = 0; i < BENCH_STRINGS; ++i)
+      free((void *)strs[i]);
+  uint64_t freeUs = TestNow() - start - mallocUs;
+
+  printf("pool: %d strings: arena store=%llu ms clear=%llu ms, strdup=%llu ms free=%llu ms\n", BENCH_STRINGS,
+         (unsigned long long)(arenaUs / 1000), (unsigned long long)(clearUs / 1000), (unsigned long long)(mallocUs / 1000), (unsigned long long)(freeUs / 1000));
+  free(strs);
+}
+
+int main()
+{
+  TestArena();
+  TestPool();
+  BenchArena();
+
+  return TestResult("pool");
+}
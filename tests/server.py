@@ -0,0 +1,293 @@
+#!/usr/bin/env python3
+#
+# server.py: Elvis plugin for the Video Disk Recorder
+#
+# A local stand-in for the etvrecorder API serving synthetic fixtures, so the
+# plugin can be run and benchmarked without an account:
+#
+#   python3 tests/server.py --port 8080 --recordings 10000 --channels 200 --days 7
+#   vdr -P'elvis --server=http://127.0.0.1:8080'
+#
+# Any credentials are accepted. The JSON replies carry an ETag and are answered
+# with 304 when revalidated, and the streams honour byte ranges. With --dump a
+# single reply is written to stdout instead, e.g. for the parser benchmark:
+#
+#   python3 tests/server.py --dump 'ajaxprograminfo.sl?ajax=true' > epg.json
+#
+# See the README file for copyright information and how to reach the author.
+#
+
+import argparse
+import hashlib
+import json
+import struct
+import sys
+import threading
+import time
+import urllib.parse
+
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+TITLES = ["Uutiset", "Elokuva", "Urheilu", "Sää", "Dokumentti", "Sarja", "Lasten ohjelma", "Ajankohtaista"]
+CATEGORIES = ["new", "movies", "series", "kids", "documentaries"]
+TS_PACKET = 188
+TS_PACKETS_PER_PTS = 64
+TS_PTS_STEP = 3600  # 40ms at 90kHz
+
+
+def escape(obj):
+    # the service sends its texts url encoded
+    if isinstance(obj, dict):
+        return {k: escape(v) for k, v in obj.items()}
+    if isinstance(obj, list):
+        return [escape(v) for v in obj]
+    if isinstance(obj, str):
+        return urllib.parse.quote(obj, safe=" .:/-")
+    return obj
+
+
+def when(t, simple=False):
+    tm = time.localtime(t)
+    if simple:
+        return time.strftime("%H:%M", tm)
+    return time.strftime("%d.%m.%Y %H:%M:%S", tm)
+
+
+class Fixtures:
+    # every reply is generated once, so the timings measure the plugin rather than this server
+
+    def __init__(self, args):
+        self.args = args
+        self.lock = threading.Lock()
+        self.replies = {}
+        self.start = int(time.time()) // 86400 * 86400
+        self.channels = ["Kanava %03d" % c for c in range(args.channels)]
+        self.events_per_channel = args.days * 86400 // args.event_length
+        self.folders = [{"id": str(f + 1), "name": "Kansio %d" % (f + 1), "count": "0", "has_pin": "false", "subfolders": []} for f in range(args.folders)]
+        self.recordings = {-1: []}
+        for f in self.folders:
+            self.recordings[int(f["id"])] = []
+        folder_ids = list(self.recordings.keys())
+        for r in range(args.recordings):
+            folder = folder_ids[r % len(folder_ids)]
+            start = self.start - (r + 1) * args.event_length
+            self.recordings[folder].append({
+                "id": str(r + 1), "program_id": str(1000000 + r), "folder_id": str(folder), "viewcount": str(r % 3),
+                "length": str(args.event_length // 60), "name": "%s %d" % (TITLES[r % len(TITLES)], r + 1),
+                "channel": self.channels[r % len(self.channels)] if self.channels else "Kanava", "start_time": when(start)})
+        for f in self.folders:
+            f["count"] = str(len(self.recordings[int(f["id"])]))
+
+    def event(self, c, i):
+        start = self.start + i * self.args.event_length
+        end = start + self.args.event_length
+        return {"id": str(c * self.events_per_channel + i + 1), "name": TITLES[(c + i) % len(TITLES)],
+                "simple_start_time": when(start, True), "simple_end_time": when(end, True),
+                "start_time": when(start), "end_time": when(end), "short_text": "Jakso %d" % (i + 1)}
+
+    def vod(self, v):
+        return {"id": str(v + 1), "length": "95", "agelimit": str((v % 4) * 4), "year": str(1990 + v % 30), "price": str(v % 5),
+                "title": "Elokuva %d" % (v + 1), "currency": "EUR", "cover": "", "trailer": ""}
+
+    def build(self, path, query):
+        a = self.args
+        if path == "ready.sl" and not ({"delete_folder", "rename_folder", "create_subfolder"} & set(query)):
+            if "folderlist" in query:
+                return {"folders": self.folders}
+            folder = int(query.get("folderid", "-1"))
+            if folder not in self.recordings:
+                return {"ready_data": [{"folders": [], "recordings": []}]}
+            folders = [{"id": f["id"], "recordings_count": f["count"], "name": f["name"], "size": "0 GB"} for f in self.folders] if folder < 0 else []
+            return {"ready_data": [{"folders": folders, "recordings": self.recordings[folder]}]}
+        if path == "recordings.sl":
+            return {"recordings": [{"program_id": str(2000000 + t), "length": "60", "name": TITLES[t % len(TITLES)],
+                                    "channel": self.channels[t % len(self.channels)] if self.channels else "Kanava",
+                                    "start_time": when(self.start + 86400 + t * a.event_length), "wild_card": ""} for t in range(a.timers)]}
+        if path == "wildcards.sl":
+            return {"wildcardrecordings": [{"recording_id": str(t + 1), "folder": "", "added": when(self.start),
+                                            "wild_card_channel": self.channels[t % len(self.channels)] if self.channels else "Kanava",
+                                            "wild_card": TITLES[t % len(TITLES)]} for t in range(a.timers // 10)]}
+        if path == "ajaxprograminfo.sl":
+            if "channellist" in query:
+                return {"channels": [{"name": c, "logo": ""} for c in self.channels]}
+            if "channel" in query:
+                c = self.channels.index(query["channel"]) if query["channel"] in self.channels else -1
+                return {"channelname": query["channel"], "programs": [self.event(c, i) for i in range(self.events_per_channel)] if c >= 0 else []}
+            return {"channels": [{name: [self.event(c, i) for i in range(self.events_per_channel)]} for c, name in enumerate(self.channels)]}
+        if path == "channels.sl":
+            return {"programs": [dict(program_id=e["id"], name=e["name"], channel=self.channels[t % len(self.channels)], start_time=e["start_time"], end_time=e["end_time"])
+                                 for t, e in ((t, self.event(t % len(self.channels), t)) for t in range(min(a.top_events, self.events_per_channel)))] if self.channels else []}
+        if path == "program.sl" and "programid" in query and "record" not in query:
+            p = int(query["programid"])
+            start = self.start + (p % self.events_per_channel) * a.event_length
+            return {"id": str(p), "length": str(a.event_length // 60), "programviewid": str(p), "recordingid": str(p),
+                    "has_started": "true", "has_ended": "true", "recorded": "true", "ready": "true", "is_wildcard": "false",
+                    "scrambled_channel": "false", "name": TITLES[p % len(TITLES)], "channel": self.channels[p % len(self.channels)] if self.channels else "Kanava",
+                    "short_text": "Jakso %d" % p, "description": "Kuvaus " * 40, "flength": "%d min" % (a.event_length // 60), "tn": "",
+                    "start_time": when(start), "end_time": when(start + a.event_length), "url": "http://%s/stream/%d.ts" % (a.host, p)}
+        if path == "vod.sl" and "vod" in query:
+            v = int(query["vod"]) - 1
+            info = self.vod(v)
+            info.update({"original_title": "Movie %d" % (v + 1), "short_desc": "Lyhyt kuvaus", "info": "Kuvaus " * 60, "info2": "",
+                         "trailer_url": "", "categories": [{"cat": CATEGORIES[v % len(CATEGORIES)]}]})
+            return info
+        if path == "vod.sl" and ("data" in query):
+            count = min(int(query.get("count", a.vods)), a.vods)
+            return {"vods": [self.vod(v) for v in range(count)]}
+        return None
+
+    def reply(self, path, query):
+        key = path + "?" + "&".join("%s=%s" % kv for kv in sorted(query.items()))
+        with self.lock:
+            if key not in self.replies:
+                obj = self.build(path, query)
+                if obj is None:
+                    return None
+                if self.args.escape:
+                    obj = escape(obj)
+                data = json.dumps(obj, ensure_ascii=False).encode("utf-8")
+                self.replies[key] = (data, '"%s"' % hashlib.md5(data).hexdigest())
+            return self.replies[key]
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    fixtures = None
+    sessions = set()
+
+    def log_message(self, format, *args):
+        if self.fixtures.args.verbose:
+            BaseHTTPRequestHandler.log_message(self, format, *args)
+
+    def send(self, code, data, ctype="text/plain; charset=utf-8", headers=()):
+        self.send_response(code)
+        self.send_header("Content-Type", ctype)
+        self.send_header("Content-Length", str(len(data)))
+        for h in headers:
+            self.send_header(*h)
+        self.end_headers()
+        if self.command != "HEAD":
+            self.wfile.write(data)
+
+    def session(self):
+        for c in self.headers.get_all("Cookie", []):
+            for part in c.split(";"):
+                name, _, value = part.strip().partition("=")
+                if name == "JSESSIONID" and value in self.sessions:
+                    return True
+        return False
+
+    def stream(self, path):
+        # mpeg-ts packets with a pts on every 64th one, so the time index has something to follow
+        size = self.fixtures.args.stream_size * 1024 * 1024 // TS_PACKET * TS_PACKET
+        start, stop = 0, size - 1
+        rng = self.headers.get("Range", "")
+        if rng.startswith("bytes="):
+            first, _, last = rng[6:].partition("-")
+            start = int(first) if first else 0
+            stop = min(int(last), size - 1) if last else size - 1
+            if start >= size:
+                self.send(416, b"", headers=[("Content-Range", "bytes */%d" % size)])
+                return
+        self.send_response(206 if rng else 200)
+        self.send_header("Content-Type", "video/mp2t")
+        self.send_header("Content-Length", str(stop - start + 1))
+        self.send_header("Accept-Ranges", "bytes")
+        if rng:
+            self.send_header("Content-Range", "bytes %d-%d/%d" % (start, stop, size))
+        self.end_headers()
+        if self.command == "HEAD":
+            return
+        first = start // TS_PACKET
+        skip = start - first * TS_PACKET
+        left = stop - start + 1
+        try:
+            while left > 0:
+                chunk = b"".join(self.packet(n) for n in range(first, first + 256))[skip:skip + left]
+                self.wfile.write(chunk)
+                left -= len(chunk)
+                first += 256
+                skip = 0
+        except (BrokenPipeError, ConnectionResetError):
+            pass
+
+    @staticmethod
+    def packet(n):
+        if n % TS_PACKETS_PER_PTS:
+            return b"\x47\x01\x00" + bytes([0x10 | (n & 0x0f)]) + b"\xff" * (TS_PACKET - 4)
+        pts = (n // TS_PACKETS_PER_PTS) * TS_PTS_STEP
+        header = b"\x47\x41\x00" + bytes([0x10 | (n & 0x0f)])
+        pes = b"\x00\x00\x01\xe0\x00\x00\x80\x80\x05" + struct.pack(">BHH", 0x21 | ((pts >> 29) & 0x0e), (((pts >> 14) & 0xfffe) | 1), (((pts << 1) & 0xfffe) | 1))
+        return header + pes + b"\xff" * (TS_PACKET - len(header) - len(pes))
+
+    def do_HEAD(self):
+        self.do_GET()
+
+    def do_GET(self):
+        if self.fixtures.args.latency:
+            time.sleep(self.fixtures.args.latency / 1000.0)
+        url = urllib.parse.urlsplit(self.path)
+        path = url.path.rsplit("/", 1)[-1]
+        query = dict(urllib.parse.parse_qsl(url.query, keep_blank_values=True))
+        if url.path.startswith("/stream/"):
+            self.stream(path)
+        elif path == "login.sl":
+            session = hashlib.md5(("%s%f" % (query.get("username", ""), time.time())).encode()).hexdigest()
+            self.sessions.add(session)
+            self.send(200, b"TRUE", headers=[("Set-Cookie", "JSESSIONID=%s; Path=/" % session)])
+        elif path == "logout.sl":
+            self.send(200, b"TRUE")
+        elif not self.session():
+            # the real service answers with its login page
+            self.send(200, b"<html><body>Kirjaudu sisaan</body></html>", "text/html")
+        else:
+            reply = self.fixtures.reply(path, query)
+            if reply is None:
+                # the actions just acknowledge
+                self.send(200, b"OK" if path == "vod.sl" else b"TRUE")
+            elif self.headers.get("If-None-Match") == reply[1]:
+                self.send(304, b"", headers=[("ETag", reply[1])])
+            else:
+                self.send(200, reply[0], "application/json; charset=utf-8", headers=[("ETag", reply[1])])
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Local stand-in for the etvrecorder API")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--bind", default="127.0.0.1")
+    parser.add_argument("--recordings", type=int, default=10000)
+    parser.add_argument("--folders", type=int, default=20)
+    parser.add_argument("--channels", type=int, default=200)
+    parser.add_argument("--days", type=int, default=7)
+    parser.add_argument("--event-length", type=int, default=1800, help="in seconds")
+    parser.add_argument("--timers", type=int, default=100)
+    parser.add_argument("--top-events", type=int, default=50)
+    parser.add_argument("--vods", type=int, default=500)
+    parser.add_argument("--stream-size", type=int, default=64, help="in megabytes")
+    parser.add_argument("--latency", type=int, default=0, help="added to every request, in milliseconds")
+    parser.add_argument("--escape", action="store_true", help="url encode the texts of the replies")
+    parser.add_argument("--verbose", action="store_true")
+    parser.add_argument("--dump", metavar="URL", help="write the reply of the given path and query to stdout and exit")
+    args = parser.parse_args()
+    args.host = "%s:%d" % (args.bind, args.port)
+
+    Handler.fixtures = Fixtures(args)
+    if args.dump:
+        url = urllib.parse.urlsplit(args.dump)
+        reply = Handler.fixtures.reply(url.path.rsplit("/", 1)[-1], dict(urllib.parse.parse_qsl(url.query, keep_blank_values=True)))
+        if reply is None:
+            print("No fixture for %s" % args.dump, file=sys.stderr)
+            return 1
+        sys.stdout.buffer.write(reply[0])
+        return 0
+    server = ThreadingHTTPServer((args.bind, args.port), Handler)
+    server.daemon_threads = True
+    print("Serving %d recordings, %d channels x %d days on http://%s/" % (args.recordings, args.channels, args.days, args.host), file=sys.stderr)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    sys.exit(main())
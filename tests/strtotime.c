@@ -0,0 +1,147 @@
+/*
+ * strtotime.c: Elvis plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#include <stdlib.h>
+
+#include "test.h"
+#include "../common.h"
+
+#define FIRST_YEAR 2010
+#define LAST_YEAR  2030
+
+static time_t MakeTime(int yearP, int monthP, int dayP, int hourP, int minuteP)
+{
+  struct tm tm;
+
+  memset(&tm, 0, sizeof(tm));
+  tm.tm_year = yearP - 1900;
+  tm.tm_mon = monthP - 1;
+  tm.tm_mday = dayP;
+  tm.tm_hour = hourP;
+  tm.tm_min = minuteP;
+  tm.tm_isdst = -1;
+
+  return mktime(&tm);
+}
+
+static int LastSunday(int yearP, int monthP)
+{
+  struct tm tm;
+  time_t t = MakeTime(yearP, monthP, 31, 12, 0);
+
+  localtime_r(&t, &tm);
+
+  return 31 - tm.tm_wday;
+}
+
+static void TestFormats()
+{
+  time_t t = MakeTime(2010, 9, 22, 21, 0);
+
+  CHECK(strtotime("ke 22.09.2010 21:00") == t);
+  CHECK(strtotime("22.09.2010 21:00") == t);
+  CHECK(strtotime("22.09.2010 21:00:00") == t);
+  CHECK(strtotime("22.09.2010 21:00:30") == t + 30);
+  CHECK(strtotime("1.2.2011 8:05") == MakeTime(2011, 2, 1, 8, 5));
+  CHECK(strtotime("29.02.2012 23:59") == MakeTime(2012, 2, 29, 23, 59));
+  CHECK(strtotime(NULL) == 0);
+  CHECK(strtotime("") == 0);
+  fprintf(stderr, "strtotime: the following conversion errors are expected\n");
+  CHECK(strtotime("32.01.2010 12:00") == 0);
+  CHECK(strtotime("01.13.2010 12:00") == 0);
+  CHECK(strtotime("01.01.2010 24:00") == 0);
+  CHECK(strtotime("01.01.2010") == 0);
+}
+
+static void TestTransitions()
+{
+  // every minute of the days around the changes, compared with the C library
+  int minutes = 0;
+
+  for (int year = FIRST_YEAR; year <= LAST_YEAR; ++year) {
+      for (int month = 3; month <= 10; month += 7) {
+          int day = LastSunday(year, month);
+          time_t from = MakeTime(year, month, day - 1, 0, 0);
+          time_t to = MakeTime(year, month, day + 1, 23, 59);
+          for (time_t t = from; t <= to; t += 60, ++minutes) {
+              struct tm tm;
+              char buf[32];
+              localtime_r(&t, &tm);
+              strftime(buf, sizeof(buf), "%d.%m.%Y %H:%M", &tm);
+              time_t result = strtotime(buf);
+              // the repeated hour in october is read as the first one of the two
+              if ((month == 10) && !tm.tm_isdst && (tm.tm_mday == day) && (tm.tm_hour == 3))
+                 CHECK(result == t - 3600);
+              else if (result != t) {
+                 fprintf(stderr, "strtotime: %s gave %ld instead of %ld\n", buf, (long)result, (long)t);
+                 CHECK(result == t);
+                 }
+              }
+          // the skipped hour in march doesn't exist, so it's taken as the winter time
+          if (month == 3) {
+             char buf[32];
+             snprintf(buf, sizeof(buf), "%02d.03.%d 03:30", day, year);
+             CHECK(strtotime(buf) == MakeTime(year, 3, day, 2, 30) + 3600);
+             }
+          }
+      }
+  printf("strtotime: compared %d minutes around the changes of %d-%d\n", minutes, FIRST_YEAR, LAST_YEAR);
+}
+
+// --- timing ----------------------------------------------------------
+
+#define BENCH_CONVERSIONS 1000000
+
+static time_t OldStrToTime(const char *s)
+{
+  // the former sscanf/mktime based conversion
+  struct tm tm;
+
+  memset(&tm, 0, sizeof(tm));
+  if (sscanf(s, "%d.%d.%d %d:%d", &tm.tm_mday, &tm.tm_mon, &tm.tm_year, &tm.tm_hour, &tm.tm_min) != 5)
+     return 0;
+  tm.tm_mon -= 1;
+  tm.tm_year -= 1900;
+  tm.tm_isdst = -1;
+
+  return mktime(&tm);
+}
+
+static void BenchConversions()
+{
+  char strs[64][32];
+  time_t sum1 = 0, sum2 = 0;
+
+  for (int i = 0; i < 64; ++i)
+      snprintf(strs[i], sizeof(strs[i]), "%02d.%02d.%d %02d:%02d", 1 + i % 28, 1 + i % 12, 2010 + i % 20, i % 24, (i * 7) % 60);
+
+  uint64_t start = TestNow();
+  for (int i = 0; i < BENCH_CONVERSIONS; ++i)
+      sum1 += strtotime(strs[i % 64]);
+  uint64_t newUs = TestNow() - start;
+
+  start = TestNow();
+  for (int i = 0; i < BENCH_CONVERSIONS; ++i)
+      sum2 += OldStrToTime(strs[i % 64]);
+  uint64_t oldUs = TestNow() - start;
+
+  CHECK(sum1 == sum2);
+  printf("strtotime: %d conversions: table=%llu ms sscanf/mktime=%llu ms\n", BENCH_CONVERSIONS, (unsigned long long)(newUs / 1000), (unsigned long long)(oldUs / 1000));
+}
+
+int main()
+{
+  // the conversion always follows the rules of Helsinki, whatever the local time zone
+  setenv("TZ", "Europe/Helsinki", 1);
+  tzset();
+
+  TestFormats();
+  TestTransitions();
+  BenchConversions();
+
+  return TestResult("strtotime");
+}
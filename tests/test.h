@@ -0,0 +1,60 @@
+/*
+ * test.h: Elvis plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#ifndef __ELVIS_TEST_H
+#define __ELVIS_TEST_H
+
+// the checks run outside of VDR, so they replace the logging of the plugin with plain output
+#define __ELVIS_LOG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#define error(x...)   void( (fprintf(stderr, "ELVIS-ERROR: " x), fputc('\n', stderr)) )
+#define info(x...)    void( (fprintf(stderr, "ELVIS: " x), fputc('\n', stderr)) )
+#define debug1(x...)  void()
+#define debug2(x...)  void()
+#define debug3(x...)  void()
+#define debug4(x...)  void()
+#define debug5(x...)  void()
+#define debug6(x...)  void()
+#define debug7(x...)  void()
+#define debug8(x...)  void()
+#define debug9(x...)  void()
+#define debug10(x...) void()
+#define debug11(x...) void()
+#define debug12(x...) void()
+#define debug13(x...) void()
+#define debug14(x...) void()
+#define debug15(x...) void()
+#define debug16(x...) void()
+
+extern int TestFailures;
+
+#define CHECK(x) \
+  do { \
+     if (!(x)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x); \
+        ++TestFailures; \
+        } \
+     } while (0)
+
+// in microseconds
+static inline uint64_t TestNow()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+// prints the summary and gives the exit code of the check
+int TestResult(const char *nameP);
+
+#endif // __ELVIS_TEST_H
@@ -0,0 +1,163 @@
+/*
+ * vdr.c: Elvis plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+// the few parts of VDR the checked units need, as the plugin is normally linked against the running VDR
+
+#include <stdarg.h>
+
+#include <vdr/remux.h>
+#include <vdr/thread.h>
+#include <vdr/tools.h>
+
+int TestFailures = 0;
+
+// --- logging ---------------------------------------------------------
+
+int SysLogLevel = 3;
+
+void syslog_with_tid(int priority, const char *format, ...)
+{
+  va_list ap;
+
+  va_start(ap, format);
+  vfprintf(stderr, format, ap);
+  va_end(ap);
+  fputc('\n', stderr);
+}
+
+int TestResult(const char *nameP)
+{
+  if (TestFailures) {
+     fprintf(stderr, "%s: %d check(s) failed\n", nameP, TestFailures);
+     return 1;
+     }
+  printf("%s: ok\n", nameP);
+
+  return 0;
+}
+
+// --- cString ---------------------------------------------------------
+
+cString::cString(const char *S, bool TakePointer)
+{
+  s = TakePointer ? (char *)S : S ? strdup(S) : NULL;
+}
+
+cString::cString(const cString &String)
+{
+  s = String.s ? strdup(String.s) : NULL;
+}
+
+cString::~cString()
+{
+  free(s);
+}
+
+cString &cString::operator=(const cString &String)
+{
+  if (this == &String)
+     return *this;
+  free(s);
+  s = String.s ? strdup(String.s) : NULL;
+  return *this;
+}
+
+cString &cString::operator=(const char *String)
+{
+  if (s == String)
+     return *this;
+  free(s);
+  s = String ? strdup(String) : NULL;
+  return *this;
+}
+
+cString &cString::Truncate(int Index)
+{
+  int l = strlen(s);
+  if (Index < 0)
+     Index = l + Index;
+  if (Index >= 0 && Index < l)
+     s[Index] = 0;
+  return *this;
+}
+
+cString cString::sprintf(const char *fmt, ...)
+{
+  va_list ap;
+  va_start(ap, fmt);
+  char *buffer;
+  if (!fmt || vasprintf(&buffer, fmt, ap) < 0)
+     buffer = strdup("???");
+  va_end(ap);
+  return cString(buffer, true);
+}
+
+// --- cMutex ----------------------------------------------------------
+
+cMutex::cMutex(void)
+{
+  locked = 0;
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ERRORCHECK_NP);
+  pthread_mutex_init(&mutex, &attr);
+}
+
+cMutex::~cMutex()
+{
+  pthread_mutex_destroy(&mutex);
+}
+
+void cMutex::Lock(void)
+{
+  pthread_mutex_lock(&mutex);
+  locked++;
+}
+
+void cMutex::Unlock(void)
+{
+  if (!--locked)
+     pthread_mutex_unlock(&mutex);
+}
+
+// --- cMutexLock ------------------------------------------------------
+
+cMutexLock::cMutexLock(cMutex *Mutex)
+{
+  mutex = NULL;
+  locked = false;
+  Lock(Mutex);
+}
+
+cMutexLock::~cMutexLock()
+{
+  if (mutex && locked)
+     mutex->Unlock();
+}
+
+bool cMutexLock::Lock(cMutex *Mutex)
+{
+  if (Mutex && !mutex) {
+     mutex = Mutex;
+     Mutex->Lock();
+     locked = true;
+     return true;
+     }
+  return false;
+}
+
+// --- PTS -------------------------------------------------------------
+
+int64_t PtsDiff(int64_t Pts1, int64_t Pts2)
+{
+  int64_t d = Pts2 - Pts1;
+  if (d > MAX33BIT / 2)
+     return d - (MAX33BIT + 1);
+  if (d < -MAX33BIT / 2)
+     return d + (MAX33BIT + 1);
+  return d;
+}
@@ -0,0 +1,395 @@
+/*
+ * widget.c: Elvis plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+// times the reply handling on the fixtures of the stand-in server, see 'make bench-widget':
+//
+//   python3 tests/server.py --escape --dump 'ajaxprograminfo.sl?ajax=true' > epg.json
+//   python3 tests/server.py --escape --folders 0 --dump 'ready.sl?ajax=true&clear=true' > recordings.json
+//   tests/widget epg.json recordings.json
+//
+// the former code paths are kept here as they were, so both are run on the very same reply
+
+#include <errno.h>
+#include <string.h>
+
+#include "test.h"
+#include "../widget.h"
+
+#define ROUNDS 3
+
+// --- allocations -----------------------------------------------------
+
+// every allocation of the program, including the ones of libc, curl and jansson, passes through here
+
+extern "C" void *__libc_malloc(size_t sizeP);
+extern "C" void *__libc_calloc(size_t countP, size_t sizeP);
+extern "C" void *__libc_realloc(void *ptrP, size_t sizeP);
+
+static unsigned long allocationsS = 0;
+
+extern "C" void *malloc(size_t sizeP)
+{
+  ++allocationsS;
+  return __libc_malloc(sizeP);
+}
+
+extern "C" void *calloc(size_t countP, size_t sizeP)
+{
+  ++allocationsS;
+  return __libc_calloc(countP, sizeP);
+}
+
+extern "C" void *realloc(void *ptrP, size_t sizeP)
+{
+  ++allocationsS;
+  return __libc_realloc(ptrP, sizeP);
+}
+
+static char *ReadFile(const char *fileNameP, size_t &lengthP)
+{
+  FILE *f = fopen(fileNameP, "r");
+
+  lengthP = 0;
+  if (!f) {
+     fprintf(stderr, "%s: %s\n", fileNameP, strerror(errno));
+     return NULL;
+     }
+  size_t size = 0;
+  char *data = NULL;
+  for (;;) {
+      if (lengthP + 1 >= size) {
+         size = size ? 2 * size : MEGABYTE(1);
+         char *p = (char *)realloc(data, size);
+         if (!p) {
+            fprintf(stderr, "%s: out of memory\n", fileNameP);
+            free(data);
+            fclose(f);
+            return NULL;
+            }
+         data = p;
+         }
+      size_t len = fread(data + lengthP, 1, size - lengthP - 1, f);
+      if (!len)
+         break;
+      lengthP += len;
+      }
+  fclose(f);
+  data[lengthP] = 0;
+
+  return data;
+}
+
+// --- parsing ---------------------------------------------------------
+
+// curl hands the reply over in chunks of at most this size
+#define CHUNK CURL_MAX_WRITE_SIZE
+
+// the former cElvisWidget::PutData(), which appended every chunk to a cString, and the parse of the whole string
+static json_t *ParseAppended(const char *dataP, size_t lengthP)
+{
+  cString dataM("");
+  char chunk[CHUNK + 1];
+
+  for (size_t pos = 0; pos < lengthP; pos += CHUNK) {
+      size_t len = min(lengthP - pos, (size_t)CHUNK);
+      memcpy(chunk, dataP + pos, len);
+      chunk[len] = 0;
+      cString data(chunk);
+      data.Truncate(len);
+      dataM = cString::sprintf("%s%s", *dataM, *data);
+      }
+  json_error_t err;
+
+  return json_loads(*dataM, 0, &err);
+}
+
+static size_t ReadCallback(void *bufferP, size_t lenP, void *dataP)
+{
+  return reinterpret_cast<cElvisWidgetBuffer *>(dataP)->Get((char *)bufferP, lenP);
+}
+
+// the chunks are collected by cElvisWidgetBuffer and read by the parser; in the plugin both run at the same time
+static json_t *ParseStreamed(const char *dataP, size_t lengthP)
+{
+  cElvisWidgetBuffer buffer;
+
+  for (size_t pos = 0; pos < lengthP; pos += CHUNK) {
+      if (!buffer.Put(dataP + pos, min(lengthP - pos, (size_t)CHUNK)))
+         return NULL;
+      }
+  json_error_t err;
+
+  return json_load_callback(ReadCallback, &buffer, 0, &err);
+}
+
+static void BenchParse(const char *fileNameP, const char *dataP, size_t lengthP)
+{
+  uint64_t appendedUs = 0, streamedUs = 0;
+
+  for (int i = 0; i < ROUNDS; ++i) {
+      uint64_t start = TestNow();
+      json_t *appended = ParseAppended(dataP, lengthP);
+      uint64_t us = TestNow() - start;
+      if (!i || (us < appendedUs))
+         appendedUs = us;
+
+      start = TestNow();
+      json_t *streamed = ParseStreamed(dataP, lengthP);
+      us = TestNow() - start;
+      if (!i || (us < streamedUs))
+         streamedUs = us;
+
+      CHECK(appended && streamed);
+      CHECK(json_equal(appended, streamed));
+      json_decref(appended);
+      json_decref(streamed);
+      }
+
+  printf("widget: %s (%zu bytes) parsed in %llu ms appended, %llu ms streamed\n", fileNameP, lengthP,
+         (unsigned long long)(appendedUs / 1000), (unsigned long long)(streamedUs / 1000));
+}
+
+// --- decoding --------------------------------------------------------
+
+// the same as in widget.c
+static const cElvisWidgetField<cElvisWidgetRecordingRecord> recordingFieldsS[] = {
+  { "id",         &cElvisWidgetRecordingRecord::id, NULL, NULL },
+  { "program_id", &cElvisWidgetRecordingRecord::program_id, NULL, NULL },
+  { "folder_id",  &cElvisWidgetRecordingRecord::folder_id, NULL, NULL },
+  { "viewcount",  &cElvisWidgetRecordingRecord::viewcount, NULL, NULL },
+  { "length",     &cElvisWidgetRecordingRecord::length, NULL, NULL },
+  { "name",       NULL, NULL, &cElvisWidgetRecordingRecord::name },
+  { "channel",    NULL, NULL, &cElvisWidgetRecordingRecord::channel },
+  { "start_time", NULL, NULL, &cElvisWidgetRecordingRecord::start_time },
+};
+
+static const cElvisWidgetField<cElvisWidgetEventRecord> eventFieldsS[] = {
+  { "id",                &cElvisWidgetEventRecord::id, NULL, NULL },
+  { "name",              NULL, NULL, &cElvisWidgetEventRecord::name },
+  { "simple_start_time", NULL, NULL, &cElvisWidgetEventRecord::simple_start_time },
+  { "simple_end_time",   NULL, NULL, &cElvisWidgetEventRecord::simple_end_time },
+  { "start_time",        NULL, NULL, &cElvisWidgetEventRecord::start_time },
+  { "end_time",          NULL, NULL, &cElvisWidgetEventRecord::end_time },
+  { "short_text",        NULL, NULL, &cElvisWidgetEventRecord::short_text },
+};
+
+// the callbacks of the plugin are replaced by a digest of everything decoded
+static void Digest(uint64_t &digestP, int valueP)
+{
+  digestP = (digestP ^ (unsigned int)valueP) * 1099511628211ULL;
+}
+
+static void Digest(uint64_t &digestP, const char *strP)
+{
+  for (const char *p = strP; *p; ++p)
+      Digest(digestP, *p);
+  Digest(digestP, 0);
+}
+
+// the former cElvisWidget::Unescape()
+static cString Unescape(const char *s)
+{
+  cString res;
+  char *p = curl_easy_unescape(NULL, s, 0, NULL);
+  if (p) {
+     res = p;
+     curl_free(p);
+     }
+
+  return res;
+}
+
+// the former field by field lookup of cElvisWidget::GetEPG()
+static void DecodeEventLookup(json_t *objP, uint64_t &digestP)
+{
+  int id = 0;
+  cString name = "", simple_start_time = "", simple_end_time = "", start_time = "", end_time = "", short_text = "";
+  json_t *obj = json_object_get(objP, "id");
+  if (json_is_string(obj))
+     id = (int)strtol(json_string_value(obj), NULL, 10);
+  obj = json_object_get(objP, "name");
+  if (json_is_string(obj))
+     name = Unescape(json_string_value(obj));
+  obj = json_object_get(objP, "simple_start_time");
+  if (json_is_string(obj))
+     simple_start_time = Unescape(json_string_value(obj));
+  obj = json_object_get(objP, "simple_end_time");
+  if (json_is_string(obj))
+     simple_end_time = Unescape(json_string_value(obj));
+  obj = json_object_get(objP, "start_time");
+  if (json_is_string(obj))
+     start_time = Unescape(json_string_value(obj));
+  obj = json_object_get(objP, "end_time");
+  if (json_is_string(obj))
+     end_time = Unescape(json_string_value(obj));
+  obj = json_object_get(objP, "short_text");
+  if (json_is_string(obj))
+     short_text = Unescape(json_string_value(obj));
+  Digest(digestP, id);
+  Digest(digestP, *name);
+  Digest(digestP, *simple_start_time);
+  Digest(digestP, *simple_end_time);
+  Digest(digestP, *start_time);
+  Digest(digestP, *end_time);
+  Digest(digestP, *short_text);
+}
+
+// the former field by field lookup of cElvisWidget::GetRecordings()
+static void DecodeRecordingLookup(json_t *objP, uint64_t &digestP)
+{
+  cString name = "", channel = "", start_time = "", timestamp = "";
+  int id = 0, program_id = 0, folder_id = 0, count = 0, length = 0;
+  json_t *obj = json_object_get(objP, "id");
+  if (json_is_string(obj))
+     id = (int)strtol(json_string_value(obj), NULL, 10);
+  obj = json_object_get(objP, "program_id");
+  if (json_is_string(obj))
+     program_id = (int)strtol(json_string_value(obj), NULL, 10);
+  obj = json_object_get(objP, "folder_id");
+  if (json_is_string(obj))
+     folder_id = (int)strtol(json_string_value(obj), NULL, 10);
+  obj = json_object_get(objP, "name");
+  if (json_is_string(obj))
+     name = Unescape(json_string_value(obj));
+  obj = json_object_get(objP, "channel");
+  if (json_is_string(obj))
+     channel = Unescape(json_string_value(obj));
+  obj = json_object_get(objP, "start_time");
+  if (json_is_string(obj))
+     start_time = Unescape(json_string_value(obj));
+  obj = json_object_get(objP, "timestamp");
+  if (json_is_string(obj))
+     timestamp = Unescape(json_string_value(obj));
+  obj = json_object_get(objP, "viewcount");
+  if (json_is_string(obj))
+     count = (int)strtol(json_string_value(obj), NULL, 10);
+  obj = json_object_get(objP, "length");
+  if (json_is_string(obj))
+     length = (int)strtol(json_string_value(obj), NULL, 10);
+  Digest(digestP, id);
+  Digest(digestP, program_id);
+  Digest(digestP, folder_id);
+  Digest(digestP, count);
+  Digest(digestP, length);
+  Digest(digestP, *name);
+  Digest(digestP, *channel);
+  Digest(digestP, *start_time);
+}
+
+static void DecodeEvent(cElvisWidgetDecoder &decoderP, json_t *objP, uint64_t &digestP)
+{
+  cElvisWidgetEventRecord r;
+
+  if (decoderP.Decode(objP, eventFieldsS, r)) {
+     Digest(digestP, r.id);
+     Digest(digestP, r.name);
+     Digest(digestP, r.simple_start_time);
+     Digest(digestP, r.simple_end_time);
+     Digest(digestP, r.start_time);
+     Digest(digestP, r.end_time);
+     Digest(digestP, r.short_text);
+     }
+}
+
+static void DecodeRecording(cElvisWidgetDecoder &decoderP, json_t *objP, uint64_t &digestP)
+{
+  cElvisWidgetRecordingRecord r;
+
+  if (decoderP.Decode(objP, recordingFieldsS, r)) {
+     Digest(digestP, r.id);
+     Digest(digestP, r.program_id);
+     Digest(digestP, r.folder_id);
+     Digest(digestP, r.viewcount);
+     Digest(digestP, r.length);
+     Digest(digestP, r.name);
+     Digest(digestP, r.channel);
+     Digest(digestP, r.start_time);
+     }
+}
+
+// decodes the events of an EPG reply and the recordings of a folder reply, as the decoder is created once per reply
+static int Decode(json_t *replyP, bool lookupP, uint64_t &digestP)
+{
+  cElvisWidgetDecoder decoder;
+  int count = 0;
+
+  json_t *channels = json_object_get(replyP, "channels");
+  for (size_t i = 0; i < json_array_size(channels); ++i) {
+      json_t *obj = json_array_get(channels, i);
+      for (void *iter = json_object_iter(obj); iter; iter = json_object_iter_next(obj, iter)) {
+          json_t *events = json_object_iter_value(iter);
+          for (size_t j = 0; j < json_array_size(events); ++j, ++count) {
+              if (lookupP)
+                 DecodeEventLookup(json_array_get(events, j), digestP);
+              else
+                 DecodeEvent(decoder, json_array_get(events, j), digestP);
+              }
+          }
+      }
+  json_t *folders = json_object_get(replyP, "ready_data");
+  for (size_t i = 0; i < json_array_size(folders); ++i) {
+      json_t *recordings = json_object_get(json_array_get(folders, i), "recordings");
+      for (size_t j = 0; j < json_array_size(recordings); ++j, ++count) {
+          if (lookupP)
+             DecodeRecordingLookup(json_array_get(recordings, j), digestP);
+          else
+             DecodeRecording(decoder, json_array_get(recordings, j), digestP);
+          }
+      }
+
+  return count;
+}
+
+static void BenchDecode(const char *fileNameP, const char *dataP, size_t lengthP)
+{
+  json_error_t err;
+  json_t *reply = json_loadb(dataP, lengthP, 0, &err);
+
+  CHECK(reply);
+  if (!reply)
+     return;
+
+  uint64_t lookupDigest = 0, decoderDigest = 0;
+  unsigned long allocations = allocationsS;
+  uint64_t start = TestNow();
+  int count = Decode(reply, true, lookupDigest);
+  uint64_t lookupUs = TestNow() - start;
+  unsigned long lookupAllocations = allocationsS - allocations;
+
+  allocations = allocationsS;
+  start = TestNow();
+  CHECK(Decode(reply, false, decoderDigest) == count);
+  uint64_t decoderUs = TestNow() - start;
+  unsigned long decoderAllocations = allocationsS - allocations;
+
+  CHECK(count > 0);
+  CHECK(lookupDigest == decoderDigest);
+  json_decref(reply);
+
+  count = max(count, 1);
+  printf("widget: %s %d records decoded in %llu ms with %.2f allocations/record looked up, %llu ms with %.2f allocations/record by the decoder\n",
+         fileNameP, count, (unsigned long long)(lookupUs / 1000), (double)lookupAllocations / count, (unsigned long long)(decoderUs / 1000), (double)decoderAllocations / count);
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc < 2) {
+     fprintf(stderr, "usage: %s reply.json...\n", argv[0]);
+     return 2;
+     }
+  for (int i = 1; i < argc; ++i) {
+      size_t length;
+      char *data = ReadFile(argv[i], length);
+      if (!data)
+         return 1;
+      BenchParse(argv[i], data, length);
+      BenchDecode(argv[i], data, length);
+      free(data);
+      }
+
+  return TestResult("widget");
+}
@@ -7,6 +7,7 @@
 
 #include "common.h"
 #include "config.h"
+#include "info.h"
 #include "timers.h"
 
 // --- cElvisTimer -----------------------------------------------------
@@ -26,13 +27,16 @@ cElvisTimer::cElvisTimer(int idP, int lengthP, const char *nameP, const char *ch
 
 cElvisTimer::~cElvisTimer()
 {
-  DELETE_POINTER(infoM);
+  if (infoM) {
+     infoM->Release();
+     infoM = NULL;
+     }
 }
 
 cElvisWidgetEventInfo *cElvisTimer::Info()
 {
   if (!infoM)
-     infoM = cElvisWidget::GetInstance()->GetEventInfo(idM);
+     infoM = cElvisInfoCache::GetInstance()->GetEventInfo(idM);
 
   return infoM;
 }
@@ -43,8 +47,10 @@ cElvisTimers *cElvisTimers::instanceS = NULL;
 
 cElvisTimers *cElvisTimers::GetInstance()
 {
-  if (!instanceS)
+  if (!instanceS) {
      instanceS = new cElvisTimers();
+     instanceS->Restore();
+     }
 
   return instanceS;
 }
@@ -57,7 +63,8 @@ void cElvisTimers::Destroy()
 cElvisTimers::cElvisTimers()
 : cThread("cElvisTimers"),
   stateM(0),
-  lastUpdateM(0)
+  lastUpdateM(0),
+  refreshedM(false)
 {
 }
 
@@ -79,6 +86,32 @@ void cElvisTimers::AddTimer(int idP, int lengthP, const char *nameP, const char
      }
 }
 
+void cElvisTimers::Restore()
+{
+  cElvisSnapshot *snapshot = cElvisSnapshot::GetInstance();
+
+  for (int i = 0; i < snapshot->Count(cElvisSnapshot::esTimers); ++i) {
+      const cElvisSnapshot::cRecord *r = snapshot->Record(cElvisSnapshot::esTimers, i);
+      AddTimer(r->id, r->values[0], snapshot->String(r->strings[0]), snapshot->String(r->strings[1]), snapshot->String(r->strings[2]), snapshot->String(r->strings[3]));
+      }
+}
+
+void cElvisTimers::Snapshot(cElvisSnapshot::cWriter &writerP)
+{
+  LOCK_THREAD;
+  for (cElvisTimer *i = First(); i; i = Next(i)) {
+      cElvisSnapshot::cRecord *r = writerP.Append(cElvisSnapshot::esTimers);
+      if (!r)
+         return;
+      r->id = i->Id();
+      r->values[0] = i->Length();
+      r->strings[0] = writerP.String(i->Name());
+      r->strings[1] = writerP.String(i->Channel());
+      r->strings[2] = writerP.String(i->StartTime());
+      r->strings[3] = writerP.String(i->WildCard());
+      }
+}
+
 bool cElvisTimers::Create(int idP, int folderIdP)
 {
   LOCK_THREAD;
@@ -129,16 +162,18 @@ void cElvisTimers::Refresh(bool foregroundP)
   lastUpdateM = time(NULL);
   {
     LOCK_THREAD;
-    if (foregroundP) {
-       Clear();
-       ChangeState();
-       }
-    else {
-       for (cElvisTimer *i = First(); i; i = Next(i))
-           i->Tag(false);
-       }
+    // the current timers remain visible until the reply replaces them
+    if (foregroundP)
+       Validate(false);
+    for (cElvisTimer *i = First(); i; i = Next(i))
+        i->Tag(false);
   }
-  cElvisWidget::GetInstance()->GetTimers(*this);
+  bool result = cElvisWidget::GetInstance()->GetTimers(*this);
+  if (!result || !IsValid())
+     return;
+  refreshedM = true;
+  if (IsNotModified())
+     return;
   {
     LOCK_THREAD;
     for (cElvisTimer *i = First(); i; i = Next(i)) {
@@ -173,5 +208,7 @@ bool cElvisTimers::StateChanged(int &stateP)
 
 void cElvisTimers::Action()
 {
+  cElvisWidgetPriority priority(cElvisWidgetPriority::epBackground);
+
   Refresh();
 }
@@ -11,6 +11,8 @@
 #include <vdr/thread.h>
 #include <vdr/tools.h>
 
+#include "pool.h"
+#include "snapshot.h"
 #include "widget.h"
 
 // --- cElvisTimer -----------------------------------------------------
@@ -22,8 +24,8 @@ private:
   int idM;
   int lengthM;
   cString nameM;
-  cString channelM;
-  cString startTimeM;
+  cElvisString channelM;
+  cElvisString startTimeM;
   cString wildcardM;
   cElvisWidgetEventInfo *infoM;
   time_t startTimeValueM;
@@ -57,8 +59,10 @@ private:
   };
   int stateM;
   time_t lastUpdateM;
+  bool refreshedM; // in this run, so the snapshot is worth saving
   void Refresh(bool foregroundP = false);
   cElvisTimer *GetTimer(int idP);
+  void Restore();
   // constructor
   cElvisTimers();
   // to prevent copy constructor and assignment
@@ -69,11 +73,13 @@ protected:
 public:
   static cElvisTimers *GetInstance();
   static void Destroy();
+  static bool IsRefreshed() { return instanceS && instanceS->refreshedM; }
   virtual ~cElvisTimers();
   virtual void AddTimer(int idP, int lengthP, const char *nameP, const char *channelP, const char *startTimeP, const char *wildcardP);
   bool Update(bool waitP = false);
   void ChangeState() { ++stateM; }
   bool StateChanged(int &stateP);
+  void Snapshot(cElvisSnapshot::cWriter &writerP);
   bool Create(int idP, int folderIdP = -1);
   bool Delete(int idP);
   bool Delete(cElvisTimer *timerP);
@@ -0,0 +1,134 @@
+/*
+ * transport.c: Elvis plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#include "common.h"
+#include "log.h"
+#include "transport.h"
+
+// --- cElvisTransport -------------------------------------------------
+
+cElvisTransport *cElvisTransport::instanceS = NULL;
+
+cElvisTransport *cElvisTransport::GetInstance()
+{
+  if (!instanceS)
+     instanceS = new cElvisTransport();
+
+  return instanceS;
+}
+
+void cElvisTransport::Destroy()
+{
+  DELETE_POINTER(instanceS);
+}
+
+cElvisTransport::cElvisTransport()
+: shareM(curl_share_init()),
+  idleM(),
+  createdM(0),
+  reusedM(0)
+{
+  debug1("%s", __PRETTY_FUNCTION__);
+  if (shareM) {
+     curl_share_setopt(shareM, CURLSHOPT_LOCKFUNC, cElvisTransport::LockCallback);
+     curl_share_setopt(shareM, CURLSHOPT_UNLOCKFUNC, cElvisTransport::UnlockCallback);
+     curl_share_setopt(shareM, CURLSHOPT_USERDATA, this);
+     // share name resolving, open connections and session cookies between all handles
+     curl_share_setopt(shareM, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+     curl_share_setopt(shareM, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+     curl_share_setopt(shareM, CURLSHOPT_SHARE, CURL_LOCK_DATA_COOKIE);
+     curl_share_setopt(shareM, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+     }
+  else
+     error("%s Cannot initialize share", __PRETTY_FUNCTION__);
+}
+
+cElvisTransport::~cElvisTransport()
+{
+  debug1("%s", __PRETTY_FUNCTION__);
+  cMutexLock MutexLock(&mutexM);
+  for (int i = 0; i < idleM.Size(); ++i)
+      curl_easy_cleanup(idleM[i]);
+  idleM.Clear();
+  if (shareM) {
+     CURLSHcode err = curl_share_cleanup(shareM);
+     if (err != CURLSHE_OK)
+        error("%s Cleanup (%s)", __PRETTY_FUNCTION__, curl_share_strerror(err));
+     shareM = NULL;
+     }
+}
+
+void cElvisTransport::LockCallback(CURL *handleP, curl_lock_data dataP, curl_lock_access accessP, void *userPtrP)
+{
+  cElvisTransport *obj = reinterpret_cast<cElvisTransport *>(userPtrP);
+
+  if (obj && (dataP >= 0) && (dataP < CURL_LOCK_DATA_LAST))
+     obj->shareMutexM[dataP].Lock();
+}
+
+void cElvisTransport::UnlockCallback(CURL *handleP, curl_lock_data dataP, void *userPtrP)
+{
+  cElvisTransport *obj = reinterpret_cast<cElvisTransport *>(userPtrP);
+
+  if (obj && (dataP >= 0) && (dataP < CURL_LOCK_DATA_LAST))
+     obj->shareMutexM[dataP].Unlock();
+}
+
+CURL *cElvisTransport::Acquire()
+{
+  cMutexLock MutexLock(&mutexM);
+  CURL *handle = NULL;
+
+  if (idleM.Size() > 0) {
+     handle = idleM[idleM.Size() - 1];
+     idleM.Remove(idleM.Size() - 1);
+     ++reusedM;
+     }
+  else if ((handle = curl_easy_init()) != NULL)
+     ++createdM;
+
+  if (handle) {
+     // attach to the shared caches
+     if (shareM)
+        curl_easy_setopt(handle, CURLOPT_SHARE, shareM);
+
+     // no progress meter and no signaling
+     curl_easy_setopt(handle, CURLOPT_NOPROGRESS, 1L);
+     curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+
+     // keep idle connections alive for the next borrower
+     curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+
+     // set user-agent
+     curl_easy_setopt(handle, CURLOPT_USERAGENT, *cString::sprintf("vdr-%s/%s", PLUGIN_NAME_I18N, VERSION));
+
+     // follow location
+     curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+     }
+  debug8("%s created=%lu reused=%lu idle=%d", __PRETTY_FUNCTION__, createdM, reusedM, idleM.Size());
+
+  return handle;
+}
+
+void cElvisTransport::Release(CURL *handleP)
+{
+  if (handleP) {
+     cMutexLock MutexLock(&mutexM);
+     // the connection itself stays in the shared cache
+     curl_easy_reset(handleP);
+     if (idleM.Size() < eMaxIdleHandles)
+        idleM.Append(handleP);
+     else
+        curl_easy_cleanup(handleP);
+     }
+}
+
+cString cElvisTransport::Statistics()
+{
+  cMutexLock MutexLock(&mutexM);
+  return cString::sprintf("Transport: created=%lu reused=%lu idle=%d", createdM, reusedM, idleM.Size());
+}
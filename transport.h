@@ -0,0 +1,47 @@
+/*
+ * transport.h: Elvis plugin for the Video Disk Recorder
+ *
+ * See the README file for copyright information and how to reach the author.
+ *
+ */
+
+#ifndef __ELVIS_TRANSPORT_H
+#define __ELVIS_TRANSPORT_H
+
+#include <curl/curl.h>
+#include <curl/easy.h>
+
+#include <vdr/thread.h>
+#include <vdr/tools.h>
+
+// --- cElvisTransport -------------------------------------------------
+
+class cElvisTransport {
+private:
+  enum {
+    eMaxIdleHandles = 8
+  };
+  static cElvisTransport *instanceS;
+  static void LockCallback(CURL *handleP, curl_lock_data dataP, curl_lock_access accessP, void *userPtrP);
+  static void UnlockCallback(CURL *handleP, curl_lock_data dataP, void *userPtrP);
+  CURLSH *shareM;
+  cMutex shareMutexM[CURL_LOCK_DATA_LAST];
+  cMutex mutexM;
+  cVector<CURL *> idleM;
+  unsigned long createdM;
+  unsigned long reusedM;
+  // constructor
+  cElvisTransport();
+  // to prevent copy constructor and assignment
+  cElvisTransport(const cElvisTransport&);
+  cElvisTransport& operator=(const cElvisTransport&);
+public:
+  static cElvisTransport *GetInstance();
+  static void Destroy();
+  virtual ~cElvisTransport();
+  CURL *Acquire();
+  void Release(CURL *handleP);
+  cString Statistics();
+};
+
+#endif // __ELVIS_TRANSPORT_H
@@ -7,6 +7,7 @@
 
 #include "common.h"
 #include "config.h"
+#include "info.h"
 #include "vod.h"
 
 cElvisVOD::cElvisVOD(int idP, int lengthP, int ageLimitP, int yearP, int priceP, const char *titleP, const char *currencyP, const char *coverP, const char *trailerP)
@@ -26,12 +27,16 @@ cElvisVOD::cElvisVOD(int idP, int lengthP, int ageLimitP, int yearP, int priceP,
 
 cElvisVOD::~cElvisVOD()
 {
+  if (infoM) {
+     infoM->Release();
+     infoM = NULL;
+     }
 }
 
 cElvisWidgetVODInfo *cElvisVOD::Info()
 {
   if (!infoM)
-     infoM = cElvisWidget::GetInstance()->GetVODInfo(idM);
+     infoM = cElvisInfoCache::GetInstance()->GetVODInfo(idM);
 
   return infoM;
 }
@@ -95,6 +100,7 @@ void cElvisVODCategory::Refresh(bool foregroundP)
     LOCK_THREAD;
     if (foregroundP) {
        Clear();
+       Validate(false);
        ChangeState();
        }
     else {
@@ -103,6 +109,8 @@ void cElvisVODCategory::Refresh(bool foregroundP)
        }
   }
   cElvisWidget::GetInstance()->GetVOD(*this, *categoryM);
+  if (IsNotModified())
+     return;
   {
     LOCK_THREAD;
     for (cElvisVOD *i = cList<cElvisVOD>::First(); i; i = cList<cElvisVOD>::Next(i)) {
@@ -137,6 +145,8 @@ bool cElvisVODCategory::StateChanged(int &stateP)
 
 void cElvisVODCategory::Action()
 {
+  cElvisWidgetPriority priority(cElvisWidgetPriority::epBackground);
+
   Refresh();
 }
 
@@ -5,14 +5,20 @@
  *
  */
 
+#include <ctype.h>
+#include <dirent.h>
+#include <malloc.h>
 #include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <utime.h>
 
 #include "common.h"
+#include "config.h"
 #include "log.h"
+#include "transport.h"
 #include "widget.h"
 
-#undef USE_COOKIE_JAR
-
 // --- cElvisWidgetEventInfo ------------------------------------------------
 
 cElvisWidgetEventInfo::cElvisWidgetEventInfo(int idP, const char *nameP, const char *channelP, const char *shortTextP, const char *descriptionP, int lengthP, const char *fLengthP,
@@ -46,6 +52,12 @@ cElvisWidgetEventInfo::~cElvisWidgetEventInfo()
 {
 }
 
+size_t cElvisWidgetEventInfo::Size()
+{
+  return sizeof(*this) + strlen(*nameM) + strlen(*channelM) + strlen(*shortTextM) + strlen(*descriptionM) + strlen(*fLengthM) +
+         strlen(*thumbnailM) + strlen(*startTimeM) + strlen(*endTimeM) + strlen(*urlM) + 9;
+}
+
 // --- cElvisWidgetVODInfo --------------------------------------------------
 
 cElvisWidgetVODInfo::cElvisWidgetVODInfo(int idP, int lengthP, int ageLimitP, int yearP, int priceP, const char *titleP, const char *originalTitleP, const char *currencyP,
@@ -70,9 +82,993 @@ cElvisWidgetVODInfo::~cElvisWidgetVODInfo()
 {
 }
 
+size_t cElvisWidgetVODInfo::Size()
+{
+  return sizeof(*this) + strlen(*titleM) + strlen(*originalTitleM) + strlen(*currencyM) + strlen(*shortDescriptionM) + strlen(*infoM) +
+         strlen(*info2M) + strlen(*trailerUrlM) + strlen(*categoriesM) + 8;
+}
+
+// --- cElvisWidgetBuffer ----------------------------------------------
+
+cElvisWidgetBuffer::cElvisWidgetBuffer()
+: dataM(NULL),
+  sizeM(0),
+  lengthM(0),
+  readM(0)
+{
+}
+
+cElvisWidgetBuffer::~cElvisWidgetBuffer()
+{
+  free(dataM);
+}
+
+bool cElvisWidgetBuffer::Put(const char *dataP, size_t lenP)
+{
+  if (lengthM + lenP + 1 > sizeM) {
+     // grow geometrically to keep appending amortized linear
+     size_t size = sizeM ? sizeM : eInitialSize;
+     while (size < lengthM + lenP + 1)
+           size *= 2;
+     char *p = (char *)realloc(dataM, size);
+     if (!p) {
+        error("%s Out of memory (%zu)", __PRETTY_FUNCTION__, size);
+        return false;
+        }
+     dataM = p;
+     sizeM = size;
+     }
+  memcpy(dataM + lengthM, dataP, lenP);
+  lengthM += lenP;
+  dataM[lengthM] = 0;
+
+  return true;
+}
+
+size_t cElvisWidgetBuffer::Get(char *bufferP, size_t lenP)
+{
+  size_t len = min(lenP, lengthM - readM);
+
+  if (len) {
+     memcpy(bufferP, dataM + readM, len);
+     readM += len;
+     }
+
+  return len;
+}
+
+// --- cElvisWidgetDecoder ---------------------------------------------
+
+cElvisWidgetDecoder::cElvisWidgetDecoder()
+: dataM(NULL),
+  sizeM(0),
+  lengthM(0)
+{
+}
+
+cElvisWidgetDecoder::~cElvisWidgetDecoder()
+{
+  free(dataM);
+}
+
+ssize_t cElvisWidgetDecoder::Put(const char *strP)
+{
+  // unescaping never makes the string any longer
+  size_t len = strlen(strP);
+  if (lengthM + len + 1 > sizeM) {
+     size_t size = sizeM ? sizeM : eInitialSize;
+     while (size < lengthM + len + 1)
+           size *= 2;
+     char *p = (char *)realloc(dataM, size);
+     if (!p) {
+        error("%s Out of memory (%zu)", __PRETTY_FUNCTION__, size);
+        return -1;
+        }
+     dataM = p;
+     sizeM = size;
+     }
+  ssize_t offset = lengthM;
+  lengthM += strunescape(dataM + lengthM, strP) + 1;
+
+  return offset;
+}
+
+// --- cElvisWidgetCache -----------------------------------------------
+
+const char *cElvisWidgetCache::baseCacheNameS = "cache";
+
+cElvisWidgetCache::cElvisWidgetCache()
+: directoryM(""),
+  lastCleanupM(0),
+  hitsM(0),
+  missesM(0),
+  removalsM(0)
+{
+}
+
+cElvisWidgetCache::~cElvisWidgetCache()
+{
+}
+
+cString cElvisWidgetCache::FileName(const char *urlP)
+{
+  // 64-bit FNV-1a hash of the url
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (const unsigned char *p = (const unsigned char *)urlP; *p; ++p) {
+      hash ^= *p;
+      hash *= 0x100000001b3ULL;
+      }
+
+  return cString::sprintf("%s/%016llx", *directoryM, (unsigned long long)hash);
+}
+
+bool cElvisWidgetCache::Load(const char *directoryP)
+{
+  cMutexLock MutexLock(&mutexM);
+
+  directoryM = "";
+  if (directoryP) {
+     cString dir = cString::sprintf("%s/%s", directoryP, baseCacheNameS);
+     if (!MakeDirs(*dir, true)) {
+        error("%s (%s) Cannot create cache directory", __PRETTY_FUNCTION__, directoryP);
+        return false;
+        }
+     directoryM = dir;
+     }
+  Cleanup(true);
+
+  return true;
+}
+
+bool cElvisWidgetCache::Validators(const char *urlP, cString &etagP, cString &lastModifiedP)
+{
+  cMutexLock MutexLock(&mutexM);
+  bool found = false;
+
+  if (isempty(*directoryM))
+     return false;
+
+  // the entry starts with the url and the validators on separate lines
+  FILE *f = fopen(*FileName(urlP), "r");
+  if (f) {
+     cReadLine ReadLine;
+     char *s = ReadLine.Read(f);
+     if (s && !strcmp(s, urlP)) {
+        if ((s = ReadLine.Read(f)) != NULL)
+           etagP = s;
+        if ((s = ReadLine.Read(f)) != NULL)
+           lastModifiedP = s;
+        found = (!isempty(*etagP) || !isempty(*lastModifiedP));
+        }
+     fclose(f);
+     }
+
+  return found;
+}
+
+bool cElvisWidgetCache::Get(const char *urlP, cElvisWidgetBuffer &bufferP)
+{
+  cMutexLock MutexLock(&mutexM);
+  bool found = false;
+
+  if (isempty(*directoryM))
+     return false;
+
+  FILE *f = fopen(*FileName(urlP), "r");
+  if (f) {
+     cReadLine ReadLine;
+     char *s = ReadLine.Read(f);
+     if (s && !strcmp(s, urlP) && ReadLine.Read(f) && ReadLine.Read(f)) {
+        char buffer[KILOBYTE(16)];
+        size_t len;
+        found = true;
+        while ((len = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+              if (!bufferP.Put(buffer, len)) {
+                 found = false;
+                 break;
+                 }
+              }
+        if (ferror(f))
+           found = false;
+        }
+     fclose(f);
+     }
+  if (found)
+     utime(*FileName(urlP), NULL); // the modification time tells the last use for the cleanup
+  else
+     error("%s (%s) Cannot read cached reply", __PRETTY_FUNCTION__, urlP);
+
+  return found;
+}
+
+bool cElvisWidgetCache::Put(const char *urlP, const char *etagP, const char *lastModifiedP, const char *dataP, size_t lenP)
+{
+  cMutexLock MutexLock(&mutexM);
+
+  if (isempty(*directoryM) || (isempty(etagP) && isempty(lastModifiedP)))
+     return false;
+
+  // write into a temporary file first, so readers never see a partial entry
+  cString fileName = FileName(urlP);
+  cString tmpName = cString::sprintf("%s.tmp", *fileName);
+  FILE *f = fopen(*tmpName, "w");
+  if (f) {
+     bool ok = (fprintf(f, "%s\n%s\n%s\n", urlP, etagP ? etagP : "", lastModifiedP ? lastModifiedP : "") > 0) && (fwrite(dataP, 1, lenP, f) == lenP);
+     if ((fclose(f) == 0) && ok && (rename(*tmpName, *fileName) == 0))
+        return true;
+     unlink(*tmpName);
+     }
+  error("%s (%s) Cannot write cached reply", __PRETTY_FUNCTION__, urlP);
+
+  return false;
+}
+
+void cElvisWidgetCache::Cleanup(bool forceP)
+{
+  cMutexLock MutexLock(&mutexM);
+  time_t now = time(NULL);
+
+  if (isempty(*directoryM) || (!forceP && ((now - lastCleanupM) < eCleanupInterval)))
+     return;
+  lastCleanupM = now;
+
+  // the entries are listed as "<mtime> <name>", so sorting puts the least recently used first
+  cStringList entries;
+  long long total = 0;
+  cReadDir d(*directoryM);
+  struct dirent *e;
+  while ((e = d.Next()) != NULL) {
+        struct stat st;
+        cString fileName = cString::sprintf("%s/%s", *directoryM, e->d_name);
+        if ((stat(*fileName, &st) != 0) || !S_ISREG(st.st_mode))
+           continue;
+        // the leftovers of interrupted writes are never used
+        if (endswith(e->d_name, ".tmp") || ((now - st.st_mtime) > eMaxAge)) {
+           if (unlink(*fileName) == 0)
+              ++removalsM;
+           continue;
+           }
+        entries.Append(strdup(*cString::sprintf("%010ld %s", (long)st.st_mtime, e->d_name)));
+        total += st.st_size;
+        }
+  if (total > eMaxSize) {
+     entries.Sort();
+     for (int i = 0; (i < entries.Size()) && (total > eMaxSize); ++i) {
+         struct stat st;
+         cString fileName = cString::sprintf("%s/%s", *directoryM, strchr(entries[i], ' ') + 1);
+         if ((stat(*fileName, &st) == 0) && (unlink(*fileName) == 0)) {
+            total -= st.st_size;
+            ++removalsM;
+            }
+         }
+     }
+  debug1("%s Cache size %lld bytes, %lu removals", __PRETTY_FUNCTION__, total, removalsM);
+}
+
+void cElvisWidgetCache::Hit()
+{
+  cMutexLock MutexLock(&mutexM);
+  ++hitsM;
+}
+
+void cElvisWidgetCache::Miss()
+{
+  cMutexLock MutexLock(&mutexM);
+  ++missesM;
+}
+
+cString cElvisWidgetCache::Statistics()
+{
+  cMutexLock MutexLock(&mutexM);
+  return cString::sprintf("Cache: hits=%lu misses=%lu removals=%lu", hitsM, missesM, removalsM);
+}
+
+// --- cElvisWidgetSession ---------------------------------------------
+
+const char *cElvisWidgetSession::baseCookieNameS = "cookie.conf";
+
+cElvisWidgetSession::cElvisWidgetSession()
+: fileNameM(""),
+  generationM(0),
+  validM(true),
+  loginsM(0),
+  coalescedM(0)
+{
+}
+
+cElvisWidgetSession::~cElvisWidgetSession()
+{
+}
+
+bool cElvisWidgetSession::Load(const char *directoryP)
+{
+  cMutexLock MutexLock(&mutexM);
+  bool result = false;
+
+  fileNameM = directoryP ? *cString::sprintf("%s/%s", directoryP, baseCookieNameS) : "";
+  if (isempty(*fileNameM) || access(*fileNameM, R_OK))
+     return false;
+
+  // the handle shares its cookies with every other handle of the transport
+  CURL *handle = cElvisTransport::GetInstance()->Acquire();
+  if (handle) {
+     curl_easy_setopt(handle, CURLOPT_COOKIEFILE, *fileNameM);
+     result = (curl_easy_setopt(handle, CURLOPT_COOKIELIST, "RELOAD") == CURLE_OK);
+     cElvisTransport::GetInstance()->Release(handle);
+     }
+  // an old session is assumed to be valid until the server tells otherwise
+  validM = result;
+  debug2("%s (%s) Loaded cookies: %d", __PRETTY_FUNCTION__, directoryP, result);
+
+  return result;
+}
+
+bool cElvisWidgetSession::Save()
+{
+  cMutexLock MutexLock(&mutexM);
+  bool result = false;
+
+  if (isempty(*fileNameM))
+     return false;
+
+  CURL *handle = cElvisTransport::GetInstance()->Acquire();
+  if (handle) {
+     curl_easy_setopt(handle, CURLOPT_COOKIEJAR, *fileNameM);
+     result = (curl_easy_setopt(handle, CURLOPT_COOKIELIST, "FLUSH") == CURLE_OK);
+     cElvisTransport::GetInstance()->Release(handle);
+     }
+
+  return result;
+}
+
+void cElvisWidgetSession::Clear()
+{
+  cMutexLock MutexLock(&mutexM);
+
+  CURL *handle = cElvisTransport::GetInstance()->Acquire();
+  if (handle) {
+     curl_easy_setopt(handle, CURLOPT_COOKIELIST, "ALL");
+     cElvisTransport::GetInstance()->Release(handle);
+     }
+  if (!isempty(*fileNameM))
+     unlink(*fileNameM);
+  validM = false;
+  ++generationM;
+}
+
+int cElvisWidgetSession::Generation()
+{
+  cMutexLock MutexLock(&mutexM);
+
+  return generationM;
+}
+
+bool cElvisWidgetSession::IsValid()
+{
+  cMutexLock MutexLock(&mutexM);
+
+  return validM;
+}
+
+void cElvisWidgetSession::Renew(bool validP)
+{
+  cMutexLock MutexLock(&mutexM);
+
+  validM = validP;
+  ++generationM;
+  ++loginsM;
+}
+
+void cElvisWidgetSession::Coalesced()
+{
+  cMutexLock MutexLock(&mutexM);
+
+  ++coalescedM;
+}
+
+cString cElvisWidgetSession::Statistics()
+{
+  cMutexLock MutexLock(&mutexM);
+
+  return cString::sprintf("Session: valid=%d logins=%lu coalesced=%lu", validM, loginsM, coalescedM);
+}
+
+// --- cElvisWidgetTimings ---------------------------------------------
+
+cElvisWidgetTimings::cElvisWidgetTimings()
+{
+}
+
+cElvisWidgetTimings::~cElvisWidgetTimings()
+{
+}
+
+void cElvisWidgetTimings::Account(const char *nameP, uint64_t transferMsP, uint64_t totalMsP, size_t bytesP)
+{
+  cMutexLock MutexLock(&mutexM);
+  cTiming *timing = NULL;
+
+  for (cTiming *t = timingsM.First(); t; t = timingsM.Next(t)) {
+      if ((t->nameM == nameP) || !strcmp(t->nameM, nameP)) {
+         timing = t;
+         break;
+         }
+      }
+  if (!timing) {
+     timing = new cTiming(nameP);
+     timingsM.Add(timing);
+     }
+  ++timing->callsM;
+  timing->transferMsM += transferMsP;
+  timing->totalMsM += totalMsP;
+  timing->maxMsM = max(timing->maxMsM, totalMsP);
+  timing->bytesM += bytesP;
+  debug2("%s (%s) transfer=%llums total=%llums bytes=%zu", __PRETTY_FUNCTION__, nameP, (unsigned long long)transferMsP, (unsigned long long)totalMsP, bytesP);
+}
+
+cString cElvisWidgetTimings::Statistics()
+{
+  cMutexLock MutexLock(&mutexM);
+  cString list = "";
+
+  for (cTiming *t = timingsM.First(); t; t = timingsM.Next(t))
+      list = cString::sprintf("%s%s%s: calls=%lu transfer=%llums total=%llums max=%llums bytes=%llu/%llu", *list, isempty(*list) ? "" : "\n", t->nameM, t->callsM,
+                              (unsigned long long)(t->transferMsM / t->callsM), (unsigned long long)(t->totalMsM / t->callsM), (unsigned long long)t->maxMsM,
+                              (unsigned long long)(t->bytesM / t->callsM), (unsigned long long)t->bytesM);
+
+  return list;
+}
+
+// --- cElvisWidgetRequest ---------------------------------------------
+
+cElvisWidgetRequest::cElvisWidgetRequest()
+: engineM(NULL),
+  cacheM(NULL),
+  callbackM(NULL),
+  timingsM(NULL),
+  nameM(NULL),
+  transferMsM(0),
+  receivedM(0),
+  sessionM(0),
+  priorityM(cElvisWidgetPriority::epInteractive),
+  urlM(""),
+  etagM(""),
+  lastModifiedM(""),
+  headerListM(NULL),
+  handleM(NULL),
+  resultM(CURLE_OK),
+  httpCodeM(0),
+  doneM(true),
+  abortM(false)
+{
+}
+
+cElvisWidgetRequest::~cElvisWidgetRequest()
+{
+  // the engine must not touch the request anymore
+  Abort();
+  if (headerListM)
+     curl_slist_free_all(headerListM);
+  // the request lives as long as the call that made it
+  if (timingsM)
+     timingsM->Account(nameM, transferMsM, timerM.Elapsed(), receivedM);
+}
+
+size_t cElvisWidgetRequest::WriteCallback(void *ptrP, size_t sizeP, size_t nmembP, void *dataP)
+{
+  cElvisWidgetRequest *obj = reinterpret_cast<cElvisWidgetRequest *>(dataP);
+  size_t len = sizeP * nmembP;
+
+  if (obj && !obj->Put((const char *)ptrP, len))
+     return 0;
+
+  return len;
+}
+
+size_t cElvisWidgetRequest::ReadCallback(void *bufferP, size_t lenP, void *dataP)
+{
+  cElvisWidgetRequest *obj = reinterpret_cast<cElvisWidgetRequest *>(dataP);
+
+  if (obj) {
+     cMutexLock MutexLock(&obj->mutexM);
+     // wait for more data only after the parser has consumed the buffer
+     while (!obj->bufferM.Available() && !obj->doneM)
+           obj->condM.Wait(obj->mutexM);
+     if (obj->bufferM.Available())
+        return obj->bufferM.Get((char *)bufferP, lenP);
+     if (obj->resultM == CURLE_OK)
+        return 0;
+     }
+
+  return (size_t)-1;
+}
+
+size_t cElvisWidgetRequest::HeaderCallback(void *ptrP, size_t sizeP, size_t nmembP, void *dataP)
+{
+  cElvisWidgetRequest *obj = reinterpret_cast<cElvisWidgetRequest *>(dataP);
+  size_t len = sizeP * nmembP;
+
+  if (obj)
+     obj->PutHeader((const char *)ptrP, len);
+
+  return len;
+}
+
+void cElvisWidgetRequest::PutHeader(const char *dataP, size_t lenP)
+{
+  cMutexLock MutexLock(&mutexM);
+  cString header(dataP, dataP + lenP);
+
+  // a new status line starts the headers of a redirected reply
+  if (startswith(*header, "HTTP/")) {
+     etagM = "";
+     lastModifiedM = "";
+     }
+  else if (!strncasecmp(*header, "ETag:", 5))
+     etagM = strstrip(skipspace(*header + 5), "\r\n");
+  else if (!strncasecmp(*header, "Last-Modified:", 14))
+     lastModifiedM = strstrip(skipspace(*header + 14), "\r\n");
+}
+
+bool cElvisWidgetRequest::Put(const char *dataP, size_t lenP)
+{
+  cMutexLock MutexLock(&mutexM);
+
+  if (abortM)
+     return false;
+  if (!httpCodeM && handleM)
+     curl_easy_getinfo(handleM, CURLINFO_RESPONSE_CODE, &httpCodeM);
+  if (!bufferM.Put(dataP, lenP))
+     return false;
+  receivedM += lenP;
+  condM.Broadcast();
+
+  return true;
+}
+
+void cElvisWidgetRequest::Done(CURLcode resultP)
+{
+  cMutexLock MutexLock(&mutexM);
+
+  if (engineM) {
+     if (!httpCodeM)
+        curl_easy_getinfo(handleM, CURLINFO_RESPONSE_CODE, &httpCodeM);
+     cElvisTransport::GetInstance()->Release(handleM);
+     handleM = NULL;
+     }
+  resultM = resultP;
+  transferMsM = timerM.Elapsed();
+  doneM = true;
+  condM.Broadcast();
+}
+
+bool cElvisWidgetRequest::Aborted()
+{
+  cMutexLock MutexLock(&mutexM);
+  return abortM;
+}
+
+bool cElvisWidgetRequest::WaitData()
+{
+  cMutexLock MutexLock(&mutexM);
+
+  while (!bufferM.Length() && !doneM)
+        condM.Wait(mutexM);
+
+  return (resultM == CURLE_OK);
+}
+
+bool cElvisWidgetRequest::Wait()
+{
+  cMutexLock MutexLock(&mutexM);
+
+  while (!doneM)
+        condM.Wait(mutexM);
+
+  return (resultM == CURLE_OK);
+}
+
+void cElvisWidgetRequest::Abort()
+{
+  cMutexLock MutexLock(&mutexM);
+
+  if (!doneM) {
+     abortM = true;
+     if (engineM)
+        engineM->Wakeup();
+     while (!doneM)
+           condM.Wait(mutexM);
+     }
+}
+
+bool cElvisWidgetRequest::IsLoginRequired()
+{
+  cMutexLock MutexLock(&mutexM);
+  size_t pos = 0;
+
+  // JSON replies never start with markup, so only an HTML page needs to be received completely
+  for (;;) {
+      while (pos < bufferM.Length() && isspace((*bufferM)[pos]))
+            ++pos;
+      if (pos < bufferM.Length() || doneM)
+         break;
+      condM.Wait(mutexM);
+      }
+  if (pos < bufferM.Length() && (*bufferM)[pos] == '<') {
+     while (!doneM)
+           condM.Wait(mutexM);
+     if (strstr(*bufferM, "</html>"))
+        return true;
+     }
+
+  return false;
+}
+
+json_t *cElvisWidgetRequest::Parse(const char *msgP)
+{
+  json_error_t err;
+  // the parser consumes the reply while it's still being received
+  json_t *obj = json_load_callback(cElvisWidgetRequest::ReadCallback, this, 0, &err);
+
+  if (!obj)
+     error("%s (%s) Invalid data at line %d: %s", __PRETTY_FUNCTION__, msgP, err.line, err.text);
+  Abort();
+
+  if (callbackM)
+     callbackM->Validate(obj != NULL);
+  // keep a validated reply for revalidation
+  if (obj && cacheM && (Result() == CURLE_OK) && (HttpCode() == 200))
+     cacheM->Put(*urlM, *etagM, *lastModifiedM, *bufferM, bufferM.Length());
+
+  return obj;
+}
+
+size_t cElvisWidgetRequest::Length()
+{
+  cMutexLock MutexLock(&mutexM);
+  return bufferM.Length();
+}
+
+const char *cElvisWidgetRequest::Data()
+{
+  Wait();
+  return *bufferM;
+}
+
+long cElvisWidgetRequest::HttpCode()
+{
+  cMutexLock MutexLock(&mutexM);
+  return httpCodeM;
+}
+
+CURLcode cElvisWidgetRequest::Result()
+{
+  cMutexLock MutexLock(&mutexM);
+  return resultM;
+}
+
+// --- cElvisWidgetPriority --------------------------------------------
+
+__thread int cElvisWidgetPriority::currentS = cElvisWidgetPriority::epInteractive;
+
+// --- cElvisWidgetEngine ----------------------------------------------
+
+cElvisWidgetEngine::cElvisWidgetEngine()
+: cThread("cElvisWidgetEngine"),
+  multiM(curl_multi_init()),
+  activeM(),
+  tokensM(0),
+  refillM(cTimeMs::Now()),
+  overtakenM(0),
+  throttledM(0)
+{
+  debug1("%s", __PRETTY_FUNCTION__);
+  memset(startedM, 0, sizeof(startedM));
+  if (multiM)
+     Start();
+  else
+     error("%s Cannot initialize multi", __PRETTY_FUNCTION__);
+}
+
+cElvisWidgetEngine::~cElvisWidgetEngine()
+{
+  debug1("%s", __PRETTY_FUNCTION__);
+  Cancel(-1);
+  Wakeup();
+  Cancel(3);
+  cMutexLock MutexLock(&mutexM);
+  for (int i = 0; i < activeM.Size(); ++i) {
+      curl_multi_remove_handle(multiM, activeM[i]->handleM);
+      activeM[i]->Done(CURLE_ABORTED_BY_CALLBACK);
+      }
+  activeM.Clear();
+  for (int i = 0; i < cElvisWidgetPriority::epCount; ++i) {
+      for (int j = 0; j < pendingM[i].Size(); ++j)
+          pendingM[i][j]->Done(CURLE_ABORTED_BY_CALLBACK);
+      pendingM[i].Clear();
+      }
+  if (multiM) {
+     curl_multi_cleanup(multiM);
+     multiM = NULL;
+     }
+}
+
+bool cElvisWidgetEngine::Submit(cElvisWidgetRequest *requestP)
+{
+  if (multiM && requestP && requestP->handleM) {
+     {
+       cMutexLock MutexLock(&requestP->mutexM);
+       requestP->engineM = this;
+       requestP->doneM = false;
+     }
+     if ((requestP->priorityM < 0) || (requestP->priorityM >= cElvisWidgetPriority::epCount))
+        requestP->priorityM = cElvisWidgetPriority::epBackground;
+     cMutexLock MutexLock(&mutexM);
+     pendingM[requestP->priorityM].Append(requestP);
+     Wakeup();
+     return true;
+     }
+
+  return false;
+}
+
+void cElvisWidgetEngine::Wakeup()
+{
+  if (multiM)
+     curl_multi_wakeup(multiM);
+}
+
+void cElvisWidgetEngine::Finish(cElvisWidgetRequest *requestP, CURLcode resultP)
+{
+  // called with the engine lock held
+  curl_multi_remove_handle(multiM, requestP->handleM);
+  activeM.RemoveElement(requestP);
+  requestP->Done(resultP);
+}
+
+int cElvisWidgetEngine::Refill()
+{
+  // called with the engine lock held; the bucket holds at most one second worth of requests
+  int rate = ElvisConfig.GetRequestRate();
+  uint64_t now = cTimeMs::Now();
+
+  if (rate > 0)
+     tokensM = min(tokensM + (double)(now - refillM) * rate / 1000.0, (double)rate);
+  else
+     tokensM = eMaxActiveRequests;
+  refillM = now;
+
+  return rate;
+}
+
+bool cElvisWidgetEngine::Pending()
+{
+  // called with the engine lock held
+  for (int i = 0; i < cElvisWidgetPriority::epCount; ++i) {
+      if (pendingM[i].Size() > 0)
+         return true;
+      }
+
+  return false;
+}
+
+cElvisWidgetRequest *cElvisWidgetEngine::Next()
+{
+  // called with the engine lock held; the lanes are served strictly in the order of priority
+  for (int i = 0; i < cElvisWidgetPriority::epCount; ++i) {
+      if (pendingM[i].Size() > 0) {
+         // the lower lanes leave room for interactive requests
+         if ((i != cElvisWidgetPriority::epInteractive) && (activeM.Size() >= (eMaxActiveRequests - eReservedRequests)))
+            return NULL;
+         cElvisWidgetRequest *request = pendingM[i][0];
+         pendingM[i].Remove(0);
+         if (i == cElvisWidgetPriority::epInteractive) {
+            for (int j = i + 1; j < cElvisWidgetPriority::epCount; ++j) {
+                if (pendingM[j].Size() > 0) {
+                   ++overtakenM;
+                   break;
+                   }
+                }
+            }
+         ++startedM[i];
+         return request;
+         }
+      }
+
+  return NULL;
+}
+
+void cElvisWidgetEngine::Action()
+{
+  debug1("%s Start", __PRETTY_FUNCTION__);
+  while (Running()) {
+        int running_handles = 0;
+        // libcurl shortens the wait to its own timeouts, and the submits and aborts wake the engine up
+        int timeout = eIdleTimeoutMs;
+        CURLMsg *msg;
+        int msgcount;
+
+        mutexM.Lock();
+        // drop the requests abandoned by their callers
+        for (int i = activeM.Size() - 1; i >= 0; --i) {
+            if (activeM[i]->Aborted())
+               Finish(activeM[i], CURLE_ABORTED_BY_CALLBACK);
+            }
+        for (int i = 0; i < cElvisWidgetPriority::epCount; ++i) {
+            for (int j = pendingM[i].Size() - 1; j >= 0; --j) {
+                if (pendingM[i][j]->Aborted()) {
+                   cElvisWidgetRequest *request = pendingM[i][j];
+                   pendingM[i].Remove(j);
+                   request->Done(CURLE_ABORTED_BY_CALLBACK);
+                   }
+                }
+            }
+        // keep the number of concurrent transfers and the request rate bounded
+        int rate = Refill();
+        while ((activeM.Size() < eMaxActiveRequests) && Pending()) {
+              if (tokensM < 1.0) {
+                 // wake up again once the next token is due
+                 ++throttledM;
+                 timeout = min(timeout, (int)((1.0 - tokensM) * 1000.0 / rate) + 1);
+                 break;
+                 }
+              cElvisWidgetRequest *request = Next();
+              if (!request)
+                 break;
+              if (rate > 0)
+                 tokensM -= 1.0;
+              CURLMcode err = curl_multi_add_handle(multiM, request->handleM);
+              if (err != CURLM_OK) {
+                 error("%s Add (%s)", __PRETTY_FUNCTION__, curl_multi_strerror(err));
+                 request->Done(CURLE_FAILED_INIT);
+                 continue;
+                 }
+              activeM.Append(request);
+              }
+        mutexM.Unlock();
+
+        curl_multi_perform(multiM, &running_handles);
+        while ((msg = curl_multi_info_read(multiM, &msgcount)) != NULL) {
+              if (msg->msg == CURLMSG_DONE) {
+                 cMutexLock MutexLock(&mutexM);
+                 for (int i = 0; i < activeM.Size(); ++i) {
+                     if (activeM[i]->handleM == msg->easy_handle) {
+                        debug8("%s Done (%s)", __PRETTY_FUNCTION__, curl_easy_strerror(msg->data.result));
+                        Finish(activeM[i], msg->data.result);
+                        break;
+                        }
+                     }
+                 }
+              }
+
+        curl_multi_poll(multiM, NULL, 0, timeout, NULL);
+        }
+  debug1("%s Stop", __PRETTY_FUNCTION__);
+}
+
+cString cElvisWidgetEngine::Statistics()
+{
+  cMutexLock MutexLock(&mutexM);
+
+  return cString::sprintf("Requests: interactive=%lu prefetch=%lu background=%lu overtaken=%lu throttled=%lu pending=%d/%d/%d active=%d",
+                          startedM[cElvisWidgetPriority::epInteractive], startedM[cElvisWidgetPriority::epPrefetch], startedM[cElvisWidgetPriority::epBackground],
+                          overtakenM, throttledM, pendingM[cElvisWidgetPriority::epInteractive].Size(), pendingM[cElvisWidgetPriority::epPrefetch].Size(),
+                          pendingM[cElvisWidgetPriority::epBackground].Size(), activeM.Size());
+}
+
+// --- cElvisWidgetFields ----------------------------------------------
+
+static const cElvisWidgetField<cElvisWidgetFolderRecord> folderFieldsS[] = {
+  { "id",      &cElvisWidgetFolderRecord::id, NULL, NULL },
+  { "count",   &cElvisWidgetFolderRecord::count, NULL, NULL },
+  { "has_pin", NULL, &cElvisWidgetFolderRecord::has_pin, NULL },
+  { "name",    NULL, NULL, &cElvisWidgetFolderRecord::name },
+};
+
+static const cElvisWidgetField<cElvisWidgetRecordingFolderRecord> recordingFolderFieldsS[] = {
+  { "id",               &cElvisWidgetRecordingFolderRecord::id, NULL, NULL },
+  { "recordings_count", &cElvisWidgetRecordingFolderRecord::recordings_count, NULL, NULL },
+  { "name",             NULL, NULL, &cElvisWidgetRecordingFolderRecord::name },
+  { "size",             NULL, NULL, &cElvisWidgetRecordingFolderRecord::size },
+};
+
+static const cElvisWidgetField<cElvisWidgetRecordingRecord> recordingFieldsS[] = {
+  { "id",         &cElvisWidgetRecordingRecord::id, NULL, NULL },
+  { "program_id", &cElvisWidgetRecordingRecord::program_id, NULL, NULL },
+  { "folder_id",  &cElvisWidgetRecordingRecord::folder_id, NULL, NULL },
+  { "viewcount",  &cElvisWidgetRecordingRecord::viewcount, NULL, NULL },
+  { "length",     &cElvisWidgetRecordingRecord::length, NULL, NULL },
+  { "name",       NULL, NULL, &cElvisWidgetRecordingRecord::name },
+  { "channel",    NULL, NULL, &cElvisWidgetRecordingRecord::channel },
+  { "start_time", NULL, NULL, &cElvisWidgetRecordingRecord::start_time },
+};
+
+static const cElvisWidgetField<cElvisWidgetTimerRecord> timerFieldsS[] = {
+  { "program_id", &cElvisWidgetTimerRecord::program_id, NULL, NULL },
+  { "length",     &cElvisWidgetTimerRecord::length, NULL, NULL },
+  { "name",       NULL, NULL, &cElvisWidgetTimerRecord::name },
+  { "channel",    NULL, NULL, &cElvisWidgetTimerRecord::channel },
+  { "start_time", NULL, NULL, &cElvisWidgetTimerRecord::start_time },
+  { "wild_card",  NULL, NULL, &cElvisWidgetTimerRecord::wild_card },
+};
+
+static const cElvisWidgetField<cElvisWidgetSearchTimerRecord> searchTimerFieldsS[] = {
+  { "recording_id",      &cElvisWidgetSearchTimerRecord::recording_id, NULL, NULL },
+  { "folder",            NULL, NULL, &cElvisWidgetSearchTimerRecord::folder },
+  { "added",             NULL, NULL, &cElvisWidgetSearchTimerRecord::added },
+  { "wild_card_channel", NULL, NULL, &cElvisWidgetSearchTimerRecord::wild_card_channel },
+  { "wild_card",         NULL, NULL, &cElvisWidgetSearchTimerRecord::wild_card },
+};
+
+static const cElvisWidgetField<cElvisWidgetEventRecord> eventFieldsS[] = {
+  { "id",                &cElvisWidgetEventRecord::id, NULL, NULL },
+  { "name",              NULL, NULL, &cElvisWidgetEventRecord::name },
+  { "simple_start_time", NULL, NULL, &cElvisWidgetEventRecord::simple_start_time },
+  { "simple_end_time",   NULL, NULL, &cElvisWidgetEventRecord::simple_end_time },
+  { "start_time",        NULL, NULL, &cElvisWidgetEventRecord::start_time },
+  { "end_time",          NULL, NULL, &cElvisWidgetEventRecord::end_time },
+  { "short_text",        NULL, NULL, &cElvisWidgetEventRecord::short_text },
+};
+
+static const cElvisWidgetField<cElvisWidgetTopEventRecord> topEventFieldsS[] = {
+  { "program_id", &cElvisWidgetTopEventRecord::program_id, NULL, NULL },
+  { "name",       NULL, NULL, &cElvisWidgetTopEventRecord::name },
+  { "channel",    NULL, NULL, &cElvisWidgetTopEventRecord::channel },
+  { "start_time", NULL, NULL, &cElvisWidgetTopEventRecord::start_time },
+  { "end_time",   NULL, NULL, &cElvisWidgetTopEventRecord::end_time },
+};
+
+static const cElvisWidgetField<cElvisWidgetVODRecord> vodFieldsS[] = {
+  { "id",       &cElvisWidgetVODRecord::id, NULL, NULL },
+  { "length",   &cElvisWidgetVODRecord::length, NULL, NULL },
+  { "agelimit", &cElvisWidgetVODRecord::agelimit, NULL, NULL },
+  { "year",     &cElvisWidgetVODRecord::year, NULL, NULL },
+  { "price",    &cElvisWidgetVODRecord::price, NULL, NULL },
+  { "title",    NULL, NULL, &cElvisWidgetVODRecord::title },
+  { "currency", NULL, NULL, &cElvisWidgetVODRecord::currency },
+  { "cover",    NULL, NULL, &cElvisWidgetVODRecord::cover },
+  { "trailer",  NULL, NULL, &cElvisWidgetVODRecord::trailer },
+};
+
+static const cElvisWidgetField<cElvisWidgetEventInfoRecord> eventInfoFieldsS[] = {
+  { "id",                &cElvisWidgetEventInfoRecord::id, NULL, NULL },
+  { "length",            &cElvisWidgetEventInfoRecord::length, NULL, NULL },
+  { "programviewid",     &cElvisWidgetEventInfoRecord::programviewid, NULL, NULL },
+  { "recordingid",       &cElvisWidgetEventInfoRecord::recordingid, NULL, NULL },
+  { "has_started",       NULL, &cElvisWidgetEventInfoRecord::has_started, NULL },
+  { "has_ended",         NULL, &cElvisWidgetEventInfoRecord::has_ended, NULL },
+  { "recorded",          NULL, &cElvisWidgetEventInfoRecord::recorded, NULL },
+  { "ready",             NULL, &cElvisWidgetEventInfoRecord::ready, NULL },
+  { "is_wildcard",       NULL, &cElvisWidgetEventInfoRecord::is_wildcard, NULL },
+  { "scrambled_channel", NULL, &cElvisWidgetEventInfoRecord::scrambled_channel, NULL },
+  { "name",              NULL, NULL, &cElvisWidgetEventInfoRecord::name },
+  { "channel",           NULL, NULL, &cElvisWidgetEventInfoRecord::channel },
+  { "short_text",        NULL, NULL, &cElvisWidgetEventInfoRecord::short_text },
+  { "description",       NULL, NULL, &cElvisWidgetEventInfoRecord::description },
+  { "flength",           NULL, NULL, &cElvisWidgetEventInfoRecord::flength },
+  { "tn",                NULL, NULL, &cElvisWidgetEventInfoRecord::tn },
+  { "start_time",        NULL, NULL, &cElvisWidgetEventInfoRecord::start_time },
+  { "end_time",          NULL, NULL, &cElvisWidgetEventInfoRecord::end_time },
+  { "url",               NULL, NULL, &cElvisWidgetEventInfoRecord::url },
+};
+
+static const cElvisWidgetField<cElvisWidgetVODInfoRecord> vodInfoFieldsS[] = {
+  { "id",             &cElvisWidgetVODInfoRecord::id, NULL, NULL },
+  { "length",         &cElvisWidgetVODInfoRecord::length, NULL, NULL },
+  { "agelimit",       &cElvisWidgetVODInfoRecord::agelimit, NULL, NULL },
+  { "year",           &cElvisWidgetVODInfoRecord::year, NULL, NULL },
+  { "price",          &cElvisWidgetVODInfoRecord::price, NULL, NULL },
+  { "title",          NULL, NULL, &cElvisWidgetVODInfoRecord::title },
+  { "original_title", NULL, NULL, &cElvisWidgetVODInfoRecord::original_title },
+  { "currency",       NULL, NULL, &cElvisWidgetVODInfoRecord::currency },
+  { "short_desc",     NULL, NULL, &cElvisWidgetVODInfoRecord::short_desc },
+  { "info",           NULL, NULL, &cElvisWidgetVODInfoRecord::info_text },
+  { "info2",          NULL, NULL, &cElvisWidgetVODInfoRecord::info2 },
+  { "trailer_url",    NULL, NULL, &cElvisWidgetVODInfoRecord::trailer_url },
+};
+
 // --- cElvisWidget ----------------------------------------------------
 
-const char *cElvisWidget::baseCookieNameS = "cookie.conf";
 const char* cElvisWidget::baseUrlViihdeS = "http://api.elisaviihde.fi/etvrecorder";
 
 cElvisWidget *cElvisWidget::instanceS = NULL;
@@ -91,30 +1087,27 @@ void cElvisWidget::Destroy()
 }
 
 cElvisWidget::cElvisWidget()
-:  dataM(""),
-   handleM(NULL),
+:  baseUrlM(baseUrlViihdeS),
+   engineM(NULL),
+   directoryM(""),
    headerListM(NULL)
 {
 }
 
 cElvisWidget::~cElvisWidget()
 {
-  cMutexLock(mutexM);
-
-  if (handleM) {
-     // cleanup curl stuff
-     if (headerListM) {
-        curl_slist_free_all(headerListM);
-        headerListM = NULL;
-        }
-     curl_easy_cleanup(handleM);
-     handleM = NULL;
+  DELETE_POINTER(engineM);
+  sessionM.Save();
+  // cleanup curl stuff
+  if (headerListM) {
+     curl_slist_free_all(headerListM);
+     headerListM = NULL;
      }
 }
 
 int cElvisWidget::DebugCallback(CURL *handleP, curl_infotype typeP, char *dataP, size_t sizeP, void *userPtrP)
 {
-  cElvisWidget *obj = reinterpret_cast<cElvisWidget *>(userPtrP);
+  cElvisWidgetRequest *obj = reinterpret_cast<cElvisWidgetRequest *>(userPtrP);
 
   if (obj) {
      switch (typeP) {
@@ -141,34 +1134,16 @@ int cElvisWidget::DebugCallback(CURL *handleP, curl_infotype typeP, char *dataP,
   return 0;
 }
 
-size_t cElvisWidget::WriteCallback(void *ptrP, size_t sizeP, size_t nmembP, void *dataP)
-{
-  cElvisWidget *obj = reinterpret_cast<cElvisWidget *>(dataP);
-  size_t len = sizeP * nmembP;
-
-  if (obj)
-     obj->PutData((const char *)ptrP, (int)len);
-
-  return len;
-}
-
 cString cElvisWidget::Unescape(const char *s)
 {
-  cString res; // = strunescape(s);
-  if (handleM) {
-     char *p = curl_easy_unescape(handleM, s, 0, NULL);
-     res = p;
-     curl_free(p);
-     }
-
-  return res;
+  return strunescape(s);
 }
 
 cString cElvisWidget::Escape(const char *s)
 {
   cString res; // = strescape(s);
-  if (handleM) {
-     char *p = curl_easy_escape(handleM, s, 0);
+  char *p = curl_easy_escape(NULL, s, 0);
+  if (p) {
      res = p;
      curl_free(p);
      }
@@ -176,67 +1151,132 @@ cString cElvisWidget::Escape(const char *s)
   return res;
 }
 
-void cElvisWidget::PutData(const char *dataP, unsigned int lenP)
+bool cElvisWidget::Perform(cElvisWidgetRequest &requestP, const char *urlP, const char *msgP, bool streamP, bool cacheP, cElvisWidgetCallbackIf *callbackP)
 {
-  cString data(dataP);
-  data.Truncate(lenP);
-  dataM = cString::sprintf("%s%s", *dataM, *data);
-}
+  debug16("%s (%s, %s, %d, %d)", __PRETTY_FUNCTION__, urlP, msgP, streamP, cacheP);
 
-bool cElvisWidget::Perform(const char *urlP, const char *msgP)
-{
-  debug16("%s (%s, %s)", __PRETTY_FUNCTION__, urlP,  msgP);
+  if (callbackP)
+     callbackP->NotModified(false);
 
-  if (handleM) {
-     CURLcode err;
-     long http_code = 0;
+  if (engineM) {
+     CURL *handle = cElvisTransport::GetInstance()->Acquire();
+     if (!handle) {
+        error("%s (%s, %s) Cannot acquire handle", __PRETTY_FUNCTION__, urlP, msgP);
+        return false;
+        }
 
-     // reset data
-     dataM = "";
+     // verbose output
+     curl_easy_setopt(handle, CURLOPT_VERBOSE, 1L);
+     curl_easy_setopt(handle, CURLOPT_DEBUGFUNCTION, cElvisWidget::DebugCallback);
+     curl_easy_setopt(handle, CURLOPT_DEBUGDATA, &requestP);
 
-     curl_easy_setopt(handleM, CURLOPT_URL, urlP);
-     err = curl_easy_perform(handleM);
-     if (err != CURLE_OK) {
-        error("%s (%s, %s) Perform (%s)", __PRETTY_FUNCTION__, urlP, msgP, curl_easy_strerror(err));
+     // set callbacks
+     curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, cElvisWidgetRequest::WriteCallback);
+     curl_easy_setopt(handle, CURLOPT_WRITEDATA, &requestP);
+     curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, cElvisWidgetRequest::HeaderCallback);
+     curl_easy_setopt(handle, CURLOPT_HEADERDATA, &requestP);
+
+     // set timeout
+     curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT, 5L);
+     curl_easy_setopt(handle, CURLOPT_TIMEOUT, 10L);
+
+     // enable cookies; the session keeps the shared cookies on disk
+     curl_easy_setopt(handle, CURLOPT_COOKIEFILE, "");
+     requestP.sessionM = sessionM.Generation();
+
+     // revalidate a cached reply instead of downloading it again
+     requestP.urlM = urlP;
+     if (cacheP) {
+        cString etag = "", lastModified = "";
+        requestP.cacheM = &cacheM;
+        requestP.callbackM = callbackP;
+        if (cacheM.Validators(urlP, etag, lastModified)) {
+           for (struct curl_slist *p = headerListM; p; p = p->next)
+               requestP.headerListM = curl_slist_append(requestP.headerListM, p->data);
+           if (!isempty(*etag))
+              requestP.headerListM = curl_slist_append(requestP.headerListM, *cString::sprintf("If-None-Match: %s", *etag));
+           if (!isempty(*lastModified))
+              requestP.headerListM = curl_slist_append(requestP.headerListM, *cString::sprintf("If-Modified-Since: %s", *lastModified));
+           }
+        }
+     curl_easy_setopt(handle, CURLOPT_HTTPHEADER, requestP.headerListM ? requestP.headerListM : headerListM);
+
+     // set url
+     curl_easy_setopt(handle, CURLOPT_URL, urlP);
+
+     requestP.handleM = handle;
+     requestP.timingsM = &timingsM;
+     requestP.nameM = msgP;
+     requestP.priorityM = cElvisWidgetPriority::Current();
+     requestP.timerM.Set();
+     if (!engineM->Submit(&requestP)) {
+        requestP.handleM = NULL;
+        cElvisTransport::GetInstance()->Release(handle);
+        error("%s (%s, %s) Cannot submit request", __PRETTY_FUNCTION__, urlP, msgP);
         return false;
         }
 
-     err = curl_easy_getinfo(handleM, CURLINFO_RESPONSE_CODE, &http_code);
-     if (err != CURLE_OK) {
-        error("%s (%s, %s) Getinfo (%s)", __PRETTY_FUNCTION__, urlP, msgP, curl_easy_strerror(err));
+     // streamed replies are handed over to the parser as soon as the first bytes have arrived
+     if (!(streamP ? requestP.WaitData() : requestP.Wait())) {
+        error("%s (%s, %s) Perform (%s)", __PRETTY_FUNCTION__, urlP, msgP, curl_easy_strerror(requestP.Result()));
         return false;
         }
 
-     if (http_code != 200) {
-        error("%s (%s, %s) Invalid HTTP code (%ld)", __PRETTY_FUNCTION__, urlP, msgP, http_code);
+     if (cacheP && (requestP.HttpCode() == 304)) {
+        cacheM.Hit();
+        // nothing to parse if the caller still holds the previous reply
+        if (callbackP && callbackP->IsValid()) {
+           debug2("%s (%s, %s) Not modified", __PRETTY_FUNCTION__, urlP, msgP);
+           callbackP->NotModified(true);
+           return true;
+           }
+        requestP.cacheM = NULL;
+        return cacheM.Get(urlP, requestP.bufferM);
+        }
+     else if (cacheP)
+        cacheM.Miss();
+
+     if (requestP.HttpCode() != 200) {
+        error("%s (%s, %s) Invalid HTTP code (%ld)", __PRETTY_FUNCTION__, urlP, msgP, requestP.HttpCode());
+        requestP.Abort();
         return false;
         }
 
-     if (isempty(*dataM)) {
-        debug2("%s (%s, %s) Empty data", __PRETTY_FUNCTION__, urlP,  msgP);
+     // a streamed reply is still being received, so only the arrival of its first bytes is checked
+     if (streamP ? !requestP.Length() : isempty(requestP.Data())) {
+        debug2("%s (%s, %s) Empty data", __PRETTY_FUNCTION__, urlP, msgP);
         return false;
         }
+
+     return true;
      }
 
-  return true;
+  return false;
 }
 
-bool cElvisWidget::Login()
+bool cElvisWidget::Login(cElvisWidgetRequest &requestP)
 {
   if (isempty(ElvisConfig.GetUsername()) || isempty(ElvisConfig.GetPassword())) {
      error("Invalid credentials");
      return false;
      }
 
-  if (!IsLogged() && handleM) {
-#ifdef USE_COOKIE_JAR
-     cString url = cString::sprintf("%s/login.sl?username=%s&password=%s&savelogin=true&ajax=true", baseUrlViihdeS, ElvisConfig.GetUsername(), ElvisConfig.GetPassword());
-#else
-     cString url = cString::sprintf("%s/login.sl?username=%s&password=%s&ajax=true", baseUrlViihdeS, ElvisConfig.GetUsername(), ElvisConfig.GetPassword());
-#endif
-
-     if (Perform(*url, "Login"))
-        return strstr(*dataM, "TRUE");
+  // serialize concurrent relogins
+  cMutexLock MutexLock(&mutexM);
+  // the session has already been renewed after the request was made
+  if (sessionM.Generation() != requestP.sessionM) {
+     sessionM.Coalesced();
+     return sessionM.IsValid();
+     }
+  if (engineM) {
+     cString url = cString::sprintf("%s/login.sl?username=%s&password=%s&savelogin=true&ajax=true", *baseUrlM, ElvisConfig.GetUsername(), ElvisConfig.GetPassword());
+     cElvisWidgetRequest request;
+     bool result = (Perform(request, *url, "Login") && strstr(request.Data(), "TRUE"));
+
+     sessionM.Renew(result);
+     if (result)
+        sessionM.Save();
+     return result;
      }
 
   return false;
@@ -244,134 +1284,214 @@ bool cElvisWidget::Login()
 
 bool cElvisWidget::Logout()
 {
-  if (IsLogged() && handleM) {
-     cString url = cString::sprintf("%s/logout.sl?ajax=true", baseUrlViihdeS);
+  if (sessionM.IsValid() && engineM) {
+     cString url = cString::sprintf("%s/logout.sl?ajax=true", *baseUrlM);
+     cElvisWidgetRequest request;
 
-     return Perform(*url, "Logout");
+     if (Perform(request, *url, "Logout")) {
+        sessionM.Clear();
+        return true;
+        }
      }
 
   return false;
 }
 
-bool cElvisWidget::IsLogged()
+bool cElvisWidget::Invalidate()
 {
-  if (handleM) {
-     cString url = cString::sprintf("%s/login.sl?islogged", baseUrlViihdeS);
-
-     if (Perform(*url, "IsLogged"))
-        return strstr(*dataM, "TRUE");
-     }
+  // start a new session by erasing all cookies
+  sessionM.Clear();
 
-  return false;
+  return true;
 }
 
-bool cElvisWidget::Invalidate()
+bool cElvisWidget::Load(const char *directoryP, const char *serverP)
 {
-  if (handleM) {
-#ifdef USE_COOKIE_JAR
-     // erase all cookies
-     curl_easy_setopt(handleM, CURLOPT_COOKIELIST, "ALL");
-#endif
-
-     // start a new session
-     curl_easy_setopt(handleM, CURLOPT_COOKIESESSION, 1L);
+  if (!isempty(serverP)) {
+     // strip the trailing slashes as all the paths are appended with one
+     baseUrlM = serverP;
+     while (endswith(*baseUrlM, "/"))
+           baseUrlM.Truncate(-1);
+     info("%s Using server %s", __PRETTY_FUNCTION__, *baseUrlM);
+     }
+  directoryM = directoryP;
+  cacheM.Load(directoryP);
+  sessionM.Load(directoryP);
 
-     return true;
+  // always revalidate with the server, but allow conditional replies
+  if (!headerListM) {
+     headerListM = curl_slist_append(headerListM, "Cache-Control: no-cache");
+     headerListM = curl_slist_append(headerListM, "Pragma: no-cache");
      }
 
-  return false;
+  // start the request engine
+  if (!engineM)
+     engineM = new cElvisWidgetEngine();
+
+  return (engineM && headerListM);
 }
 
-bool cElvisWidget::IsLoginRequired(const char *stringP)
+void cElvisWidget::Housekeeping()
 {
-  if (strstr(stringP, "</html>"))
-     return true;
-
-  return false;
+  cacheM.Cleanup();
 }
 
-bool cElvisWidget::Load(const char *directoryP)
+cString cElvisWidget::Statistics()
 {
-  // initialize the curl session
-  if (!handleM)
-     handleM = curl_easy_init();
-
-  if (handleM) {
-     // verbose output
-     curl_easy_setopt(handleM, CURLOPT_VERBOSE, 1L);
-     curl_easy_setopt(handleM, CURLOPT_DEBUGFUNCTION, cElvisWidget::DebugCallback);
-     curl_easy_setopt(handleM, CURLOPT_DEBUGDATA, this);
-
-     // set callback
-     curl_easy_setopt(handleM, CURLOPT_WRITEFUNCTION, cElvisWidget::WriteCallback);
-     curl_easy_setopt(handleM, CURLOPT_WRITEDATA, this);
+  cString timings = timingsM.Statistics();
 
-     // no progress meter and no signaling
-     curl_easy_setopt(handleM, CURLOPT_NOPROGRESS, 1L);
-     curl_easy_setopt(handleM, CURLOPT_NOSIGNAL, 1L);
-
-     // set timeout
-     curl_easy_setopt(handleM, CURLOPT_CONNECTTIMEOUT, 5L);
-     curl_easy_setopt(handleM, CURLOPT_TIMEOUT, 10L);
-
-     // set user-agent
-     curl_easy_setopt(handleM, CURLOPT_USERAGENT, *cString::sprintf("vdr-%s/%s", PLUGIN_NAME_I18N, VERSION));
-
-     // follow location
-     curl_easy_setopt(handleM, CURLOPT_FOLLOWLOCATION, 1L);
+  return cString::sprintf("%s\n%s\n%s%s%s", engineM ? *engineM->Statistics() : "Requests: none", *cacheM.Statistics(), *sessionM.Statistics(), isempty(*timings) ? "" : "\n", *timings);
+}
 
-     // enable cookies
-#ifdef USE_COOKIE_JAR
-     curl_easy_setopt(handleM, CURLOPT_COOKIEJAR, directoryP ? *cString::sprintf("%s/%s", directoryP, baseCookieNameS) : "-");
+// --- cElvisWidgetBenchmark -------------------------------------------
+
+// counts the items of every reply and remembers an id of each kind for the calls needing one
+class cElvisWidgetBenchmark : public cElvisWidgetFolderCallbackIf, public cElvisWidgetRecordingCallbackIf, public cElvisWidgetTimerCallbackIf,
+                              public cElvisWidgetSearchTimerCallbackIf, public cElvisWidgetChannelCallbackIf, public cElvisWidgetEventCallbackIf,
+                              public cElvisWidgetEPGCallbackIf, public cElvisWidgetTopEventCallbackIf, public cElvisWidgetVODCallbackIf {
+public:
+  unsigned long itemsM;
+  int folderIdM;
+  int eventIdM;
+  int vodIdM;
+  cString channelM;
+  cElvisWidgetBenchmark() : itemsM(0), folderIdM(-1), eventIdM(0), vodIdM(0), channelM("") {}
+  virtual void AddFolder(int folderIdP, const char *folderNameP, int recCountP, bool protectedP) { ++itemsM; folderIdM = folderIdP; }
+  virtual void AddFolder(int idP, int countP, const char *nameP, const char *sizeP) { ++itemsM; }
+  virtual void AddRecording(int idP, int programIdP, int folderIdP, int countP, int lengthP, const char *nameP, const char *channelP, const char *startTimeP) { ++itemsM; }
+  virtual void AddTimer(int idP, int lengthP, const char *nameP, const char *channelP, const char *startTimeP, const char *wildcardP) { ++itemsM; }
+  virtual void AddSearchTimer(int idP, const char *folderP, const char *addedP, const char *channelP, const char *wildcardP) { ++itemsM; }
+  virtual void AddChannel(const char *nameP, const char *logoP) { if (!itemsM++) channelM = nameP; }
+  virtual void AddEvent(int idP, const char *nameP, const char *simpleStartTimeP, const char *simpleEndTimeP, const char *startTimeP, const char *endTimeP) { ++itemsM; }
+  virtual void AddEvent(const char *channelP, int idP, const char *nameP, const char *simpleStartTimeP, const char *simpleEndTimeP, const char *startTimeP, const char *endTimeP, const char *descriptionP) { ++itemsM; eventIdM = idP; }
+  virtual void AddEvent(int idP, const char *nameP, const char *channelP, const char *startTimeP, const char *endTimeP) { ++itemsM; }
+  virtual void AddVOD(int idP, int lengthP, int ageLimitP, int yearP, int priceP, const char *titleP, const char *currencyP, const char *coverP, const char *trailerP) { ++itemsM; vodIdM = idP; }
+};
+
+static long HeapInUse()
+{
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 33)))
+  return (long)mallinfo2().uordblks;
 #else
-     curl_easy_setopt(handleM, CURLOPT_COOKIEFILE, "");
+  return 0;
 #endif
+}
 
-     // set additional headers to prevent caching
-     headerListM = curl_slist_append(headerListM, "Cache-Control: no-store, no-cache, must-revalidate");
-     headerListM = curl_slist_append(headerListM, "Cache-Control: post-check=0, pre-check=0");
-     headerListM = curl_slist_append(headerListM, "Pragma: no-cache");
-     headerListM = curl_slist_append(headerListM, "Expires: Mon, 26 Jul 1997 05:00:00 GMT");
-     curl_easy_setopt(handleM, CURLOPT_HTTPHEADER, headerListM);
-
-     //Login();
-
-     return true;
-     }
-
-  return false;
+cString cElvisWidget::Benchmark(int roundsP)
+{
+  enum { eCalls = 13 };
+  static const char *namesS[eCalls] = { "GetChannels", "GetFolders", "GetRecordings", "GetRecordings(folder)", "GetTimers", "GetSearchTimers", "GetEvents",
+                                        "GetEPG", "GetTopEvents", "GetVOD", "SearchVOD", "GetEventInfo", "GetVODInfo" };
+  cElvisWidgetBenchmark benchmark;
+  cString list = "";
+  struct rusage usage;
+
+  // the service itself must never be loaded like this
+  if (!strcmp(*baseUrlM, baseUrlViihdeS))
+     return "Benchmark requires a local server given with --server";
+  if ((roundsP <= 0) || (roundsP > 1000))
+     return "Invalid parameters";
+
+  // the replies are never kept valid, so every round parses them in full; the first one only warms up the server
+  for (int c = 0; c < eCalls; ++c) {
+      uint64_t totalMs = 0, maxMs = 0;
+      unsigned long items = 0;
+      int failures = 0;
+      long heap = HeapInUse();
+      for (int r = -1; r < roundsP; ++r) {
+          bool result = false;
+          benchmark.itemsM = 0;
+          cTimeMs timer;
+          switch (c) {
+            case 0:
+                 static_cast<cElvisWidgetChannelCallbackIf &>(benchmark).Validate(false);
+                 result = GetChannels(benchmark);
+                 break;
+            case 1:
+                 static_cast<cElvisWidgetFolderCallbackIf &>(benchmark).Validate(false);
+                 result = GetFolders(benchmark);
+                 break;
+            case 2:
+            case 3:
+                 static_cast<cElvisWidgetRecordingCallbackIf &>(benchmark).Validate(false);
+                 result = GetRecordings(benchmark, (c == 2) ? -1 : benchmark.folderIdM);
+                 break;
+            case 4:
+                 static_cast<cElvisWidgetTimerCallbackIf &>(benchmark).Validate(false);
+                 result = GetTimers(benchmark);
+                 break;
+            case 5:
+                 static_cast<cElvisWidgetSearchTimerCallbackIf &>(benchmark).Validate(false);
+                 result = GetSearchTimers(benchmark);
+                 break;
+            case 6:
+                 static_cast<cElvisWidgetEventCallbackIf &>(benchmark).Validate(false);
+                 result = GetEvents(benchmark, *benchmark.channelM);
+                 break;
+            case 7:
+                 static_cast<cElvisWidgetEPGCallbackIf &>(benchmark).Validate(false);
+                 result = GetEPG(benchmark);
+                 break;
+            case 8:
+                 static_cast<cElvisWidgetTopEventCallbackIf &>(benchmark).Validate(false);
+                 result = GetTopEvents(benchmark);
+                 break;
+            case 9:
+            case 10:
+                 static_cast<cElvisWidgetVODCallbackIf &>(benchmark).Validate(false);
+                 result = (c == 9) ? GetVOD(benchmark, "new") : SearchVOD(benchmark, "Elokuva", "", false);
+                 break;
+            case 11:
+            case 12: {
+                 cElvisWidgetInfo *info = (c == 11) ? (cElvisWidgetInfo *)GetEventInfo(benchmark.eventIdM) : (cElvisWidgetInfo *)GetVODInfo(benchmark.vodIdM);
+                 if (info) {
+                    benchmark.itemsM = 1;
+                    info->Release();
+                    result = true;
+                    }
+                 }
+                 break;
+            default:
+                 break;
+            }
+          uint64_t ms = timer.Elapsed();
+          if (r < 0) {
+             heap = HeapInUse();
+             continue;
+             }
+          totalMs += ms;
+          maxMs = max(maxMs, ms);
+          items += benchmark.itemsM;
+          if (!result)
+             ++failures;
+          }
+      list = cString::sprintf("%s%s: rounds=%d failures=%d items=%lu avg=%llums max=%llums heap=%+ldkB\n", *list, namesS[c], roundsP, failures, items / roundsP,
+                              (unsigned long long)(totalMs / roundsP), (unsigned long long)maxMs, (HeapInUse() - heap) / KILOBYTE(1));
+      }
+  getrusage(RUSAGE_SELF, &usage);
+
+  // the timings of the calls tell the transfer apart from the parsing
+  return cString::sprintf("%sMaximum resident set: %ldkB\n%s", *list, usage.ru_maxrss, *timingsM.Statistics());
 }
 
 void cElvisWidget::ParseFolders(cElvisWidgetFolderCallbackIf &callbackP, json_t *objP, int folderIdP)
 {
+    cElvisWidgetDecoder decoder;
     void *iter = json_object_iter(objP);
     while (iter) {
         const char *key = json_object_iter_key(iter);
         json_t *value = json_object_iter_value(iter);
         if ((!strcmp(key, "folders") || !strcmp(key, "subfolders")) && json_is_array(value)) {
             for (unsigned int i = 0; i < json_array_size(value); i++) {
-                cString name = "";
-                int id = 0, count = 0;
-                bool has_pin = false;
+                cElvisWidgetFolderRecord r;
                 json_t *obj3 = json_array_get(value, i);
-                json_t *obj4 = json_object_get(obj3, "id");
-                if (json_is_string(obj4))
-                    id = (int)strtol(json_string_value(obj4), NULL, 10);
-                obj4 = json_object_get(obj3, "count");
-                if (json_is_string(obj4))
-                    count = (int)strtol(json_string_value(obj4), NULL, 10);
-                obj4 = json_object_get(obj3, "name");
-                if (json_is_string(obj4))
-                    name = Unescape(json_string_value(obj4));
-                obj4 = json_object_get(obj3, "has_pin");
-                if (json_is_string(obj4) && !strcasecmp(json_string_value(obj4), "true"))
-                    has_pin = true;
-                obj4 = json_object_get(obj3, "subfolders");
-                if (json_array_size(obj4)) {
-                    ParseFolders(callbackP, json_deep_copy(obj3), id);
+                if (!decoder.Decode(obj3, folderFieldsS, r))
+                    continue;
+                if (json_array_size(json_object_get(obj3, "subfolders"))) {
+                    ParseFolders(callbackP, json_incref(obj3), r.id);
                 }
-                debug2("%s (, , %d) id=%d name='%s' count=%d protected=%d", __PRETTY_FUNCTION__, folderIdP, id, *name, count, has_pin);
-                callbackP.AddFolder(id, *name, count, has_pin);
+                debug2("%s (, , %d) id=%d name='%s' count=%d protected=%d", __PRETTY_FUNCTION__, folderIdP, r.id, r.name, r.count, r.has_pin);
+                callbackP.AddFolder(r.id, r.name, r.count, r.has_pin);
             }
         }
         iter = json_object_iter_next(objP, iter);
@@ -382,22 +1502,20 @@ void cElvisWidget::ParseFolders(cElvisWidgetFolderCallbackIf &callbackP, json_t
 
 bool cElvisWidget::GetFolders(cElvisWidgetFolderCallbackIf &callbackP)
 {
-  cMutexLock(mutexM);
-
-  if (handleM) {
-     cString url = cString::sprintf("%s/ready.sl?folderlist&ajax=true", baseUrlViihdeS);
+  if (engineM) {
+     cString url = cString::sprintf("%s/ready.sl?folderlist&ajax=true", *baseUrlM);
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         if (Perform(*url, "GetFolders")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "GetFolders", true, true, &callbackP)) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
-               Login();
+               Login(request);
                continue;
                }
+            else if (callbackP.IsNotModified())
+               return true;
             else {
-               json_error_t error;
-               json_t *obj = json_loads(*dataM, 0, &error);
+               json_t *obj = request.Parse(__PRETTY_FUNCTION__);
                if (obj)
                   ParseFolders(callbackP, obj);
                return true;
@@ -411,24 +1529,23 @@ bool cElvisWidget::GetFolders(cElvisWidgetFolderCallbackIf &callbackP)
 
 bool cElvisWidget::GetRecordings(cElvisWidgetRecordingCallbackIf &callbackP, int folderIdP)
 {
-  cMutexLock(mutexM);
-
-  if (handleM) {
-     cString url = (folderIdP < 0) ? cString::sprintf("%s/ready.sl?ajax=true&clear=true", baseUrlViihdeS) :
-                                     cString::sprintf("%s/ready.sl?folderid=%d&ajax=true&clear=true", baseUrlViihdeS, folderIdP);
+  if (engineM) {
+     cString url = (folderIdP < 0) ? cString::sprintf("%s/ready.sl?ajax=true&clear=true", *baseUrlM) :
+                                     cString::sprintf("%s/ready.sl?folderid=%d&ajax=true&clear=true", *baseUrlM, folderIdP);
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         if (Perform(*url, "GetRecordings")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "GetRecordings", true, true, &callbackP)) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
-               Login();
+               Login(request);
                continue;
                }
+            else if (callbackP.IsNotModified())
+               return true;
             else {
-               json_error_t error;
-               json_t *obj = json_loads(*dataM, 0, &error);
+               json_t *obj = request.Parse(__PRETTY_FUNCTION__);
                if (obj) {
+                  cElvisWidgetDecoder decoder;
                   void *iter = json_object_iter(obj);
                   while (iter) {
                         const char *key = json_object_iter_key(iter);
@@ -442,59 +1559,20 @@ bool cElvisWidget::GetRecordings(cElvisWidgetRecordingCallbackIf &callbackP, int
                                      json_t *value2 = json_object_iter_value(iter2);
                                      if (!strcmp(key2, "folders") && json_is_array(value2)) {
                                         for (unsigned int j = 0; j < json_array_size(value2); j++) {
-                                            cString name = "", size = "";
-                                            int id = 0, count = 0;
-                                            json_t *obj3 = json_array_get(value2, j);
-                                            json_t *obj4 = json_object_get(obj3, "id");
-                                            if (json_is_string(obj4))
-                                               id = (int)strtol(json_string_value(obj4), NULL, 10);
-                                            obj4 = json_object_get(obj3, "name");
-                                            if (json_is_string(obj4))
-                                               name = Unescape(json_string_value(obj4));
-                                            obj4 = json_object_get(obj3, "size");
-                                            if (json_is_string(obj4))
-                                               size = Unescape(json_string_value(obj4));
-                                            obj4 = json_object_get(obj3, "recordings_count");
-                                            if (json_is_string(obj4))
-                                               count = (int)strtol(json_string_value(obj4), NULL, 10);
-                                            debug2("%s (, %d): id=%d count=%d name='%s' size='%s'", __PRETTY_FUNCTION__, folderIdP, id, count, *name, *size);
-                                            callbackP.AddFolder(id, count, *name, *size);
+                                            cElvisWidgetRecordingFolderRecord r;
+                                            if (decoder.Decode(json_array_get(value2, j), recordingFolderFieldsS, r)) {
+                                               debug2("%s (, %d): id=%d count=%d name='%s' size='%s'", __PRETTY_FUNCTION__, folderIdP, r.id, r.recordings_count, r.name, r.size);
+                                               callbackP.AddFolder(r.id, r.recordings_count, r.name, r.size);
+                                               }
                                             }
                                         }
                                      else if (!strcmp(key2, "recordings") && json_is_array(value2)) {
                                         for (unsigned int j = 0; j < json_array_size(value2); j++) {
-                                            cString name = "", channel = "", start_time = "", timestamp = "";
-                                            int id = 0, program_id = 0, folder_id = 0, count = 0, length = 0;
-                                            json_t *obj3 = json_array_get(value2, j);
-                                            json_t *obj4 = json_object_get(obj3, "id");
-                                            if (json_is_string(obj4))
-                                               id = (int)strtol(json_string_value(obj4), NULL, 10);
-                                            obj4 = json_object_get(obj3, "program_id");
-                                            if (json_is_string(obj4))
-                                               program_id = (int)strtol(json_string_value(obj4), NULL, 10);
-                                            obj4 = json_object_get(obj3, "folder_id");
-                                            if (json_is_string(obj4))
-                                               folder_id = (int)strtol(json_string_value(obj4), NULL, 10);
-                                            obj4 = json_object_get(obj3, "name");
-                                            if (json_is_string(obj4))
-                                               name = Unescape(json_string_value(obj4));
-                                            obj4 = json_object_get(obj3, "channel");
-                                            if (json_is_string(obj4))
-                                               channel = Unescape(json_string_value(obj4));
-                                            obj4 = json_object_get(obj3, "start_time");
-                                            if (json_is_string(obj4))
-                                               start_time = Unescape(json_string_value(obj4));
-                                            obj4 = json_object_get(obj3, "timestamp");
-                                            if (json_is_string(obj4))
-                                               timestamp = Unescape(json_string_value(obj4));
-                                            obj4 = json_object_get(obj3, "viewcount");
-                                            if (json_is_string(obj4))
-                                               count = (int)strtol(json_string_value(obj4), NULL, 10);
-                                            obj4 = json_object_get(obj3, "length");
-                                            if (json_is_string(obj4))
-                                               length = (int)strtol(json_string_value(obj4), NULL, 10);
-                                            debug2("%s (, %d): id=%d program_id=%d folder_id=%d count=%d length=%d name='%s' channel='%s' start_time='%s'", __PRETTY_FUNCTION__, folderIdP, id, program_id, folder_id, count, length, *name, *channel, *start_time);
-                                            callbackP.AddRecording(id, program_id, folder_id, count, length, *name, *channel, *start_time);
+                                            cElvisWidgetRecordingRecord r;
+                                            if (decoder.Decode(json_array_get(value2, j), recordingFieldsS, r)) {
+                                               debug2("%s (, %d): id=%d program_id=%d folder_id=%d count=%d length=%d name='%s' channel='%s' start_time='%s'", __PRETTY_FUNCTION__, folderIdP, r.id, r.program_id, r.folder_id, r.viewcount, r.length, r.name, r.channel, r.start_time);
+                                               callbackP.AddRecording(r.id, r.program_id, r.folder_id, r.viewcount, r.length, r.name, r.channel, r.start_time);
+                                               }
                                             }
                                         }
                                      iter2 = json_object_iter_next(obj2, iter2);
@@ -515,17 +1593,14 @@ bool cElvisWidget::GetRecordings(cElvisWidgetRecordingCallbackIf &callbackP, int
 
 bool cElvisWidget::RemoveRecording(int idP)
 {
-  cMutexLock(mutexM);
-
-  if (handleM && (idP > 0)) {
-     cString url = cString::sprintf("%s/program.sl?remove=true&removep=%d&ajax=true", baseUrlViihdeS, idP);
+  if (engineM && (idP > 0)) {
+     cString url = cString::sprintf("%s/program.sl?remove=true&removep=%d&ajax=true", *baseUrlM, idP);
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         if (Perform(*url, "RemoveRecording")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "RemoveRecording")) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
-               Login();
+               Login(request);
                continue;
                }
             else {
@@ -541,17 +1616,14 @@ bool cElvisWidget::RemoveRecording(int idP)
 
 bool cElvisWidget::RemoveFolder(int idP)
 {
-  cMutexLock(mutexM);
-
-  if (handleM && (idP > 0)) {
-     cString url = cString::sprintf("%s/ready.sl?delete_folder=%d&ajax=true", baseUrlViihdeS, idP);
+  if (engineM && (idP > 0)) {
+     cString url = cString::sprintf("%s/ready.sl?delete_folder=%d&ajax=true", *baseUrlM, idP);
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         if (Perform(*url, "RemoveFolder")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "RemoveFolder")) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
-               Login();
+               Login(request);
                continue;
                }
             else {
@@ -567,17 +1639,14 @@ bool cElvisWidget::RemoveFolder(int idP)
 
 bool cElvisWidget::RenameFolder(int idP, const char *nameP)
 {
-  cMutexLock(mutexM);
-
-  if (handleM && (idP > 0)) {
-     cString url = cString::sprintf("%s/ready.sl?rename_folder=%d&name=%s&ajax=true", baseUrlViihdeS, idP, *Escape(nameP));
+  if (engineM && (idP > 0)) {
+     cString url = cString::sprintf("%s/ready.sl?rename_folder=%d&name=%s&ajax=true", *baseUrlM, idP, *Escape(nameP));
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         if (Perform(*url, "RenameFolder")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "RenameFolder")) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
-               Login();
+               Login(request);
                continue;
                }
             else {
@@ -593,17 +1662,14 @@ bool cElvisWidget::RenameFolder(int idP, const char *nameP)
 
 bool cElvisWidget::CreateFolder(const char *nameP, int parentFolderIdP)
 {
-  cMutexLock(mutexM);
-
-  if (handleM && nameP && !isempty(nameP)) {
-     cString url = cString::sprintf("%s/ready.sl?create_subfolder=true&folder=%s%s&ajax=true", baseUrlViihdeS, *Escape(nameP), (parentFolderIdP > 0) ? *cString::sprintf("&parent=%d", parentFolderIdP) : "");
+  if (engineM && nameP && !isempty(nameP)) {
+     cString url = cString::sprintf("%s/ready.sl?create_subfolder=true&folder=%s%s&ajax=true", *baseUrlM, *Escape(nameP), (parentFolderIdP > 0) ? *cString::sprintf("&parent=%d", parentFolderIdP) : "");
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         if (Perform(*url, "CreateFolder")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "CreateFolder")) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
-               Login();
+               Login(request);
                continue;
                }
             else {
@@ -619,53 +1685,32 @@ bool cElvisWidget::CreateFolder(const char *nameP, int parentFolderIdP)
 
 bool cElvisWidget::GetTimers(cElvisWidgetTimerCallbackIf &callbackP)
 {
-  cMutexLock(mutexM);
-
-  if (handleM) {
-     cString url = cString::sprintf("%s/recordings.sl?ajax=true", baseUrlViihdeS);
+  if (engineM) {
+     cString url = cString::sprintf("%s/recordings.sl?ajax=true", *baseUrlM);
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         if (Perform(*url, "GetTimers")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "GetTimers", true, true, &callbackP)) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
-               Login();
+               Login(request);
                continue;
                }
+            else if (callbackP.IsNotModified())
+               return true;
             else {
-               json_error_t error;
-               json_t *obj = json_loads(*dataM, 0, &error);
+               json_t *obj = request.Parse(__PRETTY_FUNCTION__);
                if (obj) {
+                  cElvisWidgetDecoder decoder;
                   void *iter = json_object_iter(obj);
                   while (iter) {
                         const char *key = json_object_iter_key(iter);
                         json_t *value = json_object_iter_value(iter);
                         if (!strcmp(key, "recordings") && json_is_array(value)) {
                            for (unsigned int i = 0; i < json_array_size(value); i++) {
-                               json_t *obj2 = json_array_get(value, i);
-                               if (json_is_object(obj2)) {
-                                  int program_id = 0, length = 0;
-                                  cString name = "", channel = "", start_time = "", wild_card = "";
-                                  json_t *obj3 = json_object_get(obj2, "program_id");
-                                  if (json_is_string(obj3))
-                                     program_id = (int)strtol(json_string_value(obj3), NULL, 10);
-                                  obj3 = json_object_get(obj2, "length");
-                                  if (json_is_string(obj3))
-                                     length = (int)strtol(json_string_value(obj3), NULL, 10);
-                                  obj3 = json_object_get(obj2, "name");
-                                  if (json_is_string(obj3))
-                                     name = Unescape(json_string_value(obj3));
-                                  obj3 = json_object_get(obj2, "channel");
-                                  if (json_is_string(obj3))
-                                     channel = Unescape(json_string_value(obj3));
-                                  obj3 = json_object_get(obj2, "start_time");
-                                  if (json_is_string(obj3))
-                                     start_time = Unescape(json_string_value(obj3));
-                                  obj3 = json_object_get(obj2, "wild_card");
-                                  if (json_is_string(obj3))
-                                     wild_card = Unescape(json_string_value(obj3));
-                                  debug2("%s program_id=%d length=%d name='%s' channel='%s' start_time='%s' wild_card='%s'", __PRETTY_FUNCTION__, program_id, length, *name, *channel, *start_time, *wild_card);
-                                  callbackP.AddTimer(program_id, length, *name, *channel, *start_time, *wild_card);
+                               cElvisWidgetTimerRecord r;
+                               if (decoder.Decode(json_array_get(value, i), timerFieldsS, r)) {
+                                  debug2("%s program_id=%d length=%d name='%s' channel='%s' start_time='%s' wild_card='%s'", __PRETTY_FUNCTION__, r.program_id, r.length, r.name, r.channel, r.start_time, r.wild_card);
+                                  callbackP.AddTimer(r.program_id, r.length, r.name, r.channel, r.start_time, r.wild_card);
                                   }
                                }
                            }
@@ -684,22 +1729,18 @@ bool cElvisWidget::GetTimers(cElvisWidgetTimerCallbackIf &callbackP)
 
 bool cElvisWidget::AddTimer(int programIdP, int folderIdP)
 {
-  cMutexLock(mutexM);
-
-  if (handleM && (programIdP > 0)) {
-     cString url = (folderIdP < 0) ? cString::sprintf("%s/program.sl?programid=%d&record=%d&ajax=true", baseUrlViihdeS, programIdP, programIdP) :
-                                     cString::sprintf("%s/program.sl?programid=%d&record=%d&folderid=%d&ajax=true", baseUrlViihdeS, programIdP, programIdP, folderIdP);
+  if (engineM && (programIdP > 0)) {
+     cString url = (folderIdP < 0) ? cString::sprintf("%s/program.sl?programid=%d&record=%d&ajax=true", *baseUrlM, programIdP, programIdP) :
+                                     cString::sprintf("%s/program.sl?programid=%d&record=%d&folderid=%d&ajax=true", *baseUrlM, programIdP, programIdP, folderIdP);
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         // always login
-         Login();
-         if (Perform(*url, "AddTimer")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "AddTimer")) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
+               Login(request);
                continue;
                }
-            else if (strstr(*dataM, "TRUE")) {
+            else if (strstr(request.Data(), "TRUE")) {
                debug2("%s (%d, %d) Added timer", __PRETTY_FUNCTION__, programIdP, folderIdP);
                return true;
                }
@@ -712,18 +1753,14 @@ bool cElvisWidget::AddTimer(int programIdP, int folderIdP)
 
 bool cElvisWidget::RemoveTimer(int idP)
 {
-  cMutexLock(mutexM);
-
-  if (handleM && (idP > 0)) {
-     cString url = cString::sprintf("%s/program.sl?remover=%d&ajax=true", baseUrlViihdeS, idP);
+  if (engineM && (idP > 0)) {
+     cString url = cString::sprintf("%s/program.sl?remover=%d&ajax=true", *baseUrlM, idP);
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         // always login
-         Login();
-         if (Perform(*url, "RemoveTimer")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "RemoveTimer")) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
+               Login(request);
                continue;
                }
             else {
@@ -739,49 +1776,33 @@ bool cElvisWidget::RemoveTimer(int idP)
 
 bool cElvisWidget::GetSearchTimers(cElvisWidgetSearchTimerCallbackIf &callbackP)
 {
-  cMutexLock(mutexM);
-
-  if (handleM) {
-     cString url = cString::sprintf("%s/wildcards.sl?ajax=true", baseUrlViihdeS);
+  if (engineM) {
+     cString url = cString::sprintf("%s/wildcards.sl?ajax=true", *baseUrlM);
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         if (Perform(*url, "GetSearchTimers")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "GetSearchTimers", true, true, &callbackP)) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
-               Login();
+               Login(request);
                continue;
                }
+            else if (callbackP.IsNotModified())
+               return true;
             else {
-               json_error_t error;
-               json_t *obj = json_loads(*dataM, 0, &error);
+               json_t *obj = request.Parse(__PRETTY_FUNCTION__);
                if (obj) {
+                  cElvisWidgetDecoder decoder;
                   void *iter = json_object_iter(obj);
                   while (iter) {
                         const char *key = json_object_iter_key(iter);
                         json_t *value = json_object_iter_value(iter);
                         if (!strcmp(key, "wildcardrecordings") && json_is_array(value)) {
                            for (unsigned int i = 0; i < json_array_size(value); i++) {
-                               int recording_id = 0;
-                               cString folder = "", added = "", wild_card_channel = "", wild_card = "";
-                               json_t *obj2 = json_array_get(value, i);
-                               json_t *obj3 = json_object_get(obj2, "recording_id");
-                               if (json_is_string(obj3))
-                                  recording_id = (int)strtol(json_string_value(obj3), NULL, 10);
-                               obj3 = json_object_get(obj2, "folder");
-                               if (json_is_string(obj3))
-                                  folder = Unescape(json_string_value(obj3));
-                               obj3 = json_object_get(obj2, "added");
-                               if (json_is_string(obj3))
-                                  added = Unescape(json_string_value(obj3));
-                               obj3 = json_object_get(obj2, "wild_card_channel");
-                               if (json_is_string(obj3))
-                                  wild_card_channel = Unescape(json_string_value(obj3));
-                               obj3 = json_object_get(obj2, "wild_card");
-                               if (json_is_string(obj3))
-                                  wild_card = Unescape(json_string_value(obj3));
-                               debug2("%s recording_id=%d folder='%s' added='%s' wild_card_channel='%s' wild_card='%s'", __PRETTY_FUNCTION__, recording_id, *folder, *added, *wild_card_channel, *wild_card);
-                               callbackP.AddSearchTimer(recording_id, *folder, *added, *wild_card_channel, *wild_card);
+                               cElvisWidgetSearchTimerRecord r;
+                               if (decoder.Decode(json_array_get(value, i), searchTimerFieldsS, r)) {
+                                  debug2("%s recording_id=%d folder='%s' added='%s' wild_card_channel='%s' wild_card='%s'", __PRETTY_FUNCTION__, r.recording_id, r.folder, r.added, r.wild_card_channel, r.wild_card);
+                                  callbackP.AddSearchTimer(r.recording_id, r.folder, r.added, r.wild_card_channel, r.wild_card);
+                                  }
                                }
                            }
                         iter = json_object_iter_next(obj, iter);
@@ -799,23 +1820,20 @@ bool cElvisWidget::GetSearchTimers(cElvisWidgetSearchTimerCallbackIf &callbackP)
 
 bool cElvisWidget::AddSearchTimer(const char *channelP, const char *wildcardP, int folderIdP, int wildcardIdP)
 {
-  cMutexLock(mutexM);
-
-  if (handleM && channelP && wildcardP) {
-     cString url = (wildcardIdP < 0) ? cString::sprintf("%s/wildcards.sl?channel=%s&folderid=%s&wildcard=%s&record=true&ajax=true", baseUrlViihdeS, *Escape(channelP),
+  if (engineM && channelP && wildcardP) {
+     cString url = (wildcardIdP < 0) ? cString::sprintf("%s/wildcards.sl?channel=%s&folderid=%s&wildcard=%s&record=true&ajax=true", *baseUrlM, *Escape(channelP),
                                                         (folderIdP < 0) ? "" : *cString::sprintf("%d", folderIdP), *Escape(wildcardP)) :
-                                       cString::sprintf("%s/wildcards.sl?edit_wildcard=%d&channel=%s&folderid=%s&wildcard=%s&record=true&ajax=true", baseUrlViihdeS,
+                                       cString::sprintf("%s/wildcards.sl?edit_wildcard=%d&channel=%s&folderid=%s&wildcard=%s&record=true&ajax=true", *baseUrlM,
                                                         wildcardIdP, *Escape(channelP), (folderIdP < 0) ? "" : *cString::sprintf("%d", folderIdP), *Escape(wildcardP));
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         if (Perform(*url, "AddSearchTimer")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "AddSearchTimer")) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
-               Login();
+               Login(request);
                continue;
                }
-            else if (strstr(*dataM, "TRUE")) {
+            else if (strstr(request.Data(), "TRUE")) {
                if (wildcardIdP < 0) {
                   debug2("%s (%s, %s, %d, %d) Added search timer", __PRETTY_FUNCTION__, channelP, wildcardP, folderIdP, wildcardIdP);
                   }
@@ -833,17 +1851,14 @@ bool cElvisWidget::AddSearchTimer(const char *channelP, const char *wildcardP, i
 
 bool cElvisWidget::RemoveSearchTimer(int idP)
 {
-  cMutexLock(mutexM);
-
-  if (handleM && (idP > 0)) {
-     cString url = cString::sprintf("%s/wildcards.sl?remover=%d&ajax=true", baseUrlViihdeS, idP);
+  if (engineM && (idP > 0)) {
+     cString url = cString::sprintf("%s/wildcards.sl?remover=%d&ajax=true", *baseUrlM, idP);
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         if (Perform(*url, "RemoveSearchTimer")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "RemoveSearchTimer")) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
-               Login();
+               Login(request);
                continue;
                }
             else {
@@ -859,22 +1874,20 @@ bool cElvisWidget::RemoveSearchTimer(int idP)
 
 bool cElvisWidget::GetChannels(cElvisWidgetChannelCallbackIf &callbackP)
 {
-  cMutexLock(mutexM);
-
-  if (handleM) {
-     cString url = cString::sprintf("%s/ajaxprograminfo.sl?channellist&ajax=true", baseUrlViihdeS);
+  if (engineM) {
+     cString url = cString::sprintf("%s/ajaxprograminfo.sl?channellist&ajax=true", *baseUrlM);
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         if (Perform(*url, "GetChannels")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "GetChannels", true, true, &callbackP)) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
-               Login();
+               Login(request);
                continue;
                }
+            else if (callbackP.IsNotModified())
+               return true;
             else {
-               json_error_t error;
-               json_t *obj = json_loads(*dataM, 0, &error);
+               json_t *obj = request.Parse(__PRETTY_FUNCTION__);
                if (obj) {
                   void *iter = json_object_iter(obj);
                   while (iter) {
@@ -884,6 +1897,11 @@ bool cElvisWidget::GetChannels(cElvisWidgetChannelCallbackIf &callbackP)
                            for (unsigned int i = 0; i < json_array_size(value); i++) {
                                json_t *obj2 = json_array_get(value, i);
                                if (json_is_string(obj2)) {
+                                  cString name = Unescape(json_string_value(obj2));
+                                  debug2("%s channel='%s'", __PRETTY_FUNCTION__, *name);
+                                  callbackP.AddChannel(*name, "");
+                                  }
+                               else if (json_is_object(obj2)) {
                                   cString name = "", logo = "";
                                   json_t *obj3 = json_object_get(obj2, "name");
                                   if (json_is_string(obj3))
@@ -911,23 +1929,22 @@ bool cElvisWidget::GetChannels(cElvisWidgetChannelCallbackIf &callbackP)
 
 bool cElvisWidget::GetEvents(cElvisWidgetEventCallbackIf &callbackP, const char *channelP)
 {
-  cMutexLock(mutexM);
-
-  if (handleM && channelP && !isempty(channelP)) {
-     cString url = cString::sprintf("%s/ajaxprograminfo.sl?channel=%s&ajax=true", baseUrlViihdeS, *Escape(channelP));
+  if (engineM && channelP && !isempty(channelP)) {
+     cString url = cString::sprintf("%s/ajaxprograminfo.sl?channel=%s&ajax=true", *baseUrlM, *Escape(channelP));
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         if (Perform(*url, "GetEvents")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "GetEvents", true, true, &callbackP)) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
-               Login();
+               Login(request);
                continue;
                }
+            else if (callbackP.IsNotModified())
+               return true;
             else {
-               json_error_t error;
-               json_t *obj = json_loads(*dataM, 0, &error);
+               json_t *obj = request.Parse(__PRETTY_FUNCTION__);
                if (obj) {
+                  cElvisWidgetDecoder decoder;
                   void *iter = json_object_iter(obj);
                   while (iter) {
                         const char *key = json_object_iter_key(iter);
@@ -939,29 +1956,11 @@ bool cElvisWidget::GetEvents(cElvisWidgetEventCallbackIf &callbackP, const char
                            }
                         else if (!strcmp(key, "programs") && json_is_array(value)) {
                            for (unsigned int i = 0; i < json_array_size(value); i++) {
-                               int id = 0;
-                               cString name = "", simple_start_time = "", simple_end_time = "", start_time = "", end_time = "";
-                               json_t *obj2 = json_array_get(value, i);
-                               json_t *obj3 = json_object_get(obj2, "id");
-                               if (json_is_string(obj3))
-                                  id = (int)strtol(json_string_value(obj3), NULL, 10);
-                               obj3 = json_object_get(obj2, "name");
-                               if (json_is_string(obj3))
-                                  name = Unescape(json_string_value(obj3));
-                               obj3 = json_object_get(obj2, "simple_start_time");
-                               if (json_is_string(obj3))
-                                  simple_start_time = Unescape(json_string_value(obj3));
-                               obj3 = json_object_get(obj2, "simple_end_time");
-                               if (json_is_string(obj3))
-                                  simple_end_time = Unescape(json_string_value(obj3));
-                               obj3 = json_object_get(obj2, "start_time");
-                               if (json_is_string(obj3))
-                                  start_time = Unescape(json_string_value(obj3));
-                               obj3 = json_object_get(obj2, "end_time");
-                               if (json_is_string(obj3))
-                                  end_time = Unescape(json_string_value(obj3));
-                               debug2("%s (%s) id=%d name='%s' simple_start_time='%s' simple_end_time='%s' start_time='%s' end_time='%s'", __PRETTY_FUNCTION__, channelP, id, *name, *simple_start_time, *simple_end_time, *start_time, *end_time);
-                               callbackP.AddEvent(id, *name, *simple_start_time, *simple_end_time, *start_time, *end_time);
+                               cElvisWidgetEventRecord r;
+                               if (decoder.Decode(json_array_get(value, i), eventFieldsS, r)) {
+                                  debug2("%s (%s) id=%d name='%s' simple_start_time='%s' simple_end_time='%s' start_time='%s' end_time='%s'", __PRETTY_FUNCTION__, channelP, r.id, r.name, r.simple_start_time, r.simple_end_time, r.start_time, r.end_time);
+                                  callbackP.AddEvent(r.id, r.name, r.simple_start_time, r.simple_end_time, r.start_time, r.end_time);
+                                  }
                                }
                            }
                         iter = json_object_iter_next(obj, iter);
@@ -979,23 +1978,22 @@ bool cElvisWidget::GetEvents(cElvisWidgetEventCallbackIf &callbackP, const char
 
 bool cElvisWidget::GetEPG(cElvisWidgetEPGCallbackIf &callbackP)
 {
-  cMutexLock(mutexM);
-
-  if (handleM) {
-     cString url = cString::sprintf("%s/ajaxprograminfo.sl?ajax=true", baseUrlViihdeS);
+  if (engineM) {
+     cString url = cString::sprintf("%s/ajaxprograminfo.sl?ajax=true", *baseUrlM);
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         if (Perform(*url, "GetEPG")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "GetEPG", true, true, &callbackP)) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
-               Login();
+               Login(request);
                continue;
                }
+            else if (callbackP.IsNotModified())
+               return true;
             else {
-               json_error_t error;
-               json_t *obj = json_loads(*dataM, 0, &error);
+               json_t *obj = request.Parse(__PRETTY_FUNCTION__);
                if (obj) {
+                  cElvisWidgetDecoder decoder;
                   void *iter = json_object_iter(obj);
                   while (iter) {
                         const char *key = json_object_iter_key(iter);
@@ -1010,32 +2008,11 @@ bool cElvisWidget::GetEPG(cElvisWidgetEPGCallbackIf &callbackP)
                                         json_t *value2 = json_object_iter_value(iter2);
                                         if (json_is_array(value2)) {
                                            for (unsigned int j = 0; j < json_array_size(value2); j++) {
-                                               int id = 0;
-                                               cString name = "", simple_start_time = "", simple_end_time = "", start_time = "", end_time = "", short_text = "";
-                                               json_t *obj3 = json_array_get(value2, j);
-                                               json_t *obj4 = json_object_get(obj3, "id");
-                                               if (json_is_string(obj4))
-                                                  id = (int)strtol(json_string_value(obj4), NULL, 10);
-                                               obj4 = json_object_get(obj3, "name");
-                                               if (json_is_string(obj4))
-                                                  name = Unescape(json_string_value(obj4));
-                                               obj4 = json_object_get(obj3, "simple_start_time");
-                                               if (json_is_string(obj4))
-                                                  simple_start_time = Unescape(json_string_value(obj4));
-                                               obj4 = json_object_get(obj3, "simple_end_time");
-                                               if (json_is_string(obj4))
-                                                  simple_end_time = Unescape(json_string_value(obj4));
-                                               obj4 = json_object_get(obj3, "start_time");
-                                               if (json_is_string(obj4))
-                                                  start_time = Unescape(json_string_value(obj4));
-                                               obj4 = json_object_get(obj3, "end_time");
-                                               if (json_is_string(obj4))
-                                                  end_time = Unescape(json_string_value(obj4));
-                                               obj4 = json_object_get(obj3, "short_text");
-                                               if (json_is_string(obj4))
-                                                  short_text = Unescape(json_string_value(obj4));
-                                               debug2("%s channel='%s' id=%d name='%s' simple_start_time='%s' simple_end_time='%s' start_time='%s' end_time='%s' short_text='%s'", __PRETTY_FUNCTION__, *channel, id, *name, *simple_start_time, *simple_end_time, *start_time, *end_time, *short_text);
-                                               callbackP.AddEvent(*channel, id, *name, *simple_start_time, *simple_end_time, *start_time, *end_time, *short_text);
+                                               cElvisWidgetEventRecord r;
+                                               if (decoder.Decode(json_array_get(value2, j), eventFieldsS, r)) {
+                                                  debug2("%s channel='%s' id=%d name='%s' simple_start_time='%s' simple_end_time='%s' start_time='%s' end_time='%s' short_text='%s'", __PRETTY_FUNCTION__, *channel, r.id, r.name, r.simple_start_time, r.simple_end_time, r.start_time, r.end_time, r.short_text);
+                                                  callbackP.AddEvent(*channel, r.id, r.name, r.simple_start_time, r.simple_end_time, r.start_time, r.end_time, r.short_text);
+                                                  }
                                                }
                                            }
                                         iter2 = json_object_iter_next(obj2, iter2);
@@ -1058,50 +2035,32 @@ bool cElvisWidget::GetEPG(cElvisWidgetEPGCallbackIf &callbackP)
 
 bool cElvisWidget::GetTopEvents(cElvisWidgetTopEventCallbackIf &callbackP)
 {
-  cMutexLock(mutexM);
-
-  if (handleM) {
-     cString url = cString::sprintf("%s/channels.sl?ajax=true", baseUrlViihdeS);
+  if (engineM) {
+     cString url = cString::sprintf("%s/channels.sl?ajax=true", *baseUrlM);
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         if (Perform(*url, "GetEvents")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "GetTopEvents", true, true, &callbackP)) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
-               Login();
+               Login(request);
                continue;
                }
+            else if (callbackP.IsNotModified())
+               return true;
             else {
-               json_error_t error;
-               json_t *obj = json_loads(*dataM, 0, &error);
+               json_t *obj = request.Parse(__PRETTY_FUNCTION__);
                if (obj) {
+                  cElvisWidgetDecoder decoder;
                   void *iter = json_object_iter(obj);
                   while (iter) {
                         const char *key = json_object_iter_key(iter);
                         json_t *value = json_object_iter_value(iter);
                         if (!strcmp(key, "programs") && json_is_array(value)) {
                            for (unsigned int i = 0; i < json_array_size(value); i++) {
-                               json_t *obj2 = json_array_get(value, i);
-                               if (json_is_object(obj2)) {
-                                  int id = 0;
-                                  cString name = "", channel = "", start_time = "", end_time = "";
-                                  json_t *obj3 = json_object_get(obj2, "program_id");
-                                  if (json_is_string(obj3))
-                                     id = (int)strtol(json_string_value(obj3), NULL, 10);
-                                  obj3 = json_object_get(obj2, "name");
-                                  if (json_is_string(obj3))
-                                     name = Unescape(json_string_value(obj3));
-                                  obj3 = json_object_get(obj2, "channel");
-                                  if (json_is_string(obj3))
-                                     channel = Unescape(json_string_value(obj3));
-                                  obj3 = json_object_get(obj2, "start_time");
-                                  if (json_is_string(obj3))
-                                     start_time = Unescape(json_string_value(obj3));
-                                  obj3 = json_object_get(obj2, "end_time");
-                                  if (json_is_string(obj3))
-                                     end_time = Unescape(json_string_value(obj3));
-                                  debug2("%s id=%d name='%s' channel='%s' start_time='%s' end_time='%s'", __PRETTY_FUNCTION__, id, *name, *channel, *start_time, *end_time);
-                                  callbackP.AddEvent(id, *name, *channel, *start_time, *end_time);
+                               cElvisWidgetTopEventRecord r;
+                               if (decoder.Decode(json_array_get(value, i), topEventFieldsS, r)) {
+                                  debug2("%s id=%d name='%s' channel='%s' start_time='%s' end_time='%s'", __PRETTY_FUNCTION__, r.program_id, r.name, r.channel, r.start_time, r.end_time);
+                                  callbackP.AddEvent(r.program_id, r.name, r.channel, r.start_time, r.end_time);
                                   }
                                }
                            }
@@ -1120,62 +2079,34 @@ bool cElvisWidget::GetTopEvents(cElvisWidgetTopEventCallbackIf &callbackP)
 
 bool cElvisWidget::GetVOD(cElvisWidgetVODCallbackIf &callbackP, const char *categoryP, unsigned int countP)
 {
-  cMutexLock(mutexM);
-
-  if (handleM) {
-     cString url = !strcmp(categoryP, "favorites") ? cString::sprintf("%s/vod.sl?data=true&favorites=true&loadfavorites&ajax=true", baseUrlViihdeS) :
-                                                     cString::sprintf("%s/vod.sl?data=true&category=%s&count=%d&ajax=true", baseUrlViihdeS, *Escape(categoryP), countP);
+  if (engineM) {
+     cString url = !strcmp(categoryP, "favorites") ? cString::sprintf("%s/vod.sl?data=true&favorites=true&loadfavorites&ajax=true", *baseUrlM) :
+                                                     cString::sprintf("%s/vod.sl?data=true&category=%s&count=%d&ajax=true", *baseUrlM, *Escape(categoryP), countP);
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         if (Perform(*url, "GetVOD")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "GetVOD", true, true, &callbackP)) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
-               Login();
+               Login(request);
                continue;
                }
+            else if (callbackP.IsNotModified())
+               return true;
             else {
-               json_error_t error;
-               json_t *obj = json_loads(*dataM, 0, &error);
+               json_t *obj = request.Parse(__PRETTY_FUNCTION__);
                if (obj) {
+                  cElvisWidgetDecoder decoder;
                   void *iter = json_object_iter(obj);
                   while (iter) {
                         const char *key = json_object_iter_key(iter);
                         json_t *value = json_object_iter_value(iter);
                         if (!strcmp(key, "vods") && json_is_array(value)) {
                            for (unsigned int i = 0; i < json_array_size(value); i++) {
-                               int id = 0, length = 0, agelimit = 0, year = 0, price = 0;
-                               cString title = "", currency = "", cover = "", trailer = "";
-                               json_t *obj2 = json_array_get(value, i);
-                               json_t *obj3 = json_object_get(obj2, "id");
-                               if (json_is_string(obj3))
-                                  id = (int)strtol(json_string_value(obj3), NULL, 10);
-                               obj3 = json_object_get(obj2, "length");
-                               if (json_is_string(obj3))
-                                  length = (int)strtol(json_string_value(obj3), NULL, 10);
-                               obj3 = json_object_get(obj2, "agelimit");
-                               if (json_is_string(obj3))
-                                  agelimit = (int)strtol(json_string_value(obj3), NULL, 10);
-                               obj3 = json_object_get(obj2, "year");
-                               if (json_is_string(obj3))
-                                  year = (int)strtol(json_string_value(obj3), NULL, 10);
-                               obj3 = json_object_get(obj2, "price");
-                               if (json_is_string(obj3))
-                                  price = (int)strtol(json_string_value(obj3), NULL, 10);
-                               obj3 = json_object_get(obj2, "title");
-                               if (json_is_string(obj3))
-                                  title = Unescape(json_string_value(obj3));
-                               obj3 = json_object_get(obj2, "currency");
-                               if (json_is_string(obj3))
-                                  currency = Unescape(json_string_value(obj3));
-                               obj3 = json_object_get(obj2, "cover");
-                               if (json_is_string(obj3))
-                                  cover = Unescape(json_string_value(obj3));
-                               obj3 = json_object_get(obj2, "trailer");
-                               if (json_is_string(obj3))
-                                  trailer = Unescape(json_string_value(obj3));
-                               debug2("%s (%s, %u): id=%d length=%d agelimit=%d year=%d price=%d title='%s' currency='%s' cover='%s' trailer='%s'", __PRETTY_FUNCTION__, categoryP, countP, id, length, agelimit, year, price, *title, *currency, *cover, *trailer);
-                               callbackP.AddVOD(id, length, agelimit, year, price, *title, *currency, *cover, *trailer);
+                               cElvisWidgetVODRecord r;
+                               if (decoder.Decode(json_array_get(value, i), vodFieldsS, r)) {
+                                  debug2("%s (%s, %u): id=%d length=%d agelimit=%d year=%d price=%d title='%s' currency='%s' cover='%s' trailer='%s'", __PRETTY_FUNCTION__, categoryP, countP, r.id, r.length, r.agelimit, r.year, r.price, r.title, r.currency, r.cover, r.trailer);
+                                  callbackP.AddVOD(r.id, r.length, r.agelimit, r.year, r.price, r.title, r.currency, r.cover, r.trailer);
+                                  }
                                }
                            }
                         iter = json_object_iter_next(obj, iter);
@@ -1193,89 +2124,32 @@ bool cElvisWidget::GetVOD(cElvisWidgetVODCallbackIf &callbackP, const char *cate
 
 cElvisWidgetEventInfo *cElvisWidget::GetEventInfo(int idP)
 {
-  cMutexLock(mutexM);
-  if (handleM && (idP > 0)) {
-     cString url = cString::sprintf("%s/program.sl?programid=%d&ajax=true", baseUrlViihdeS, idP);
+  if (engineM && (idP > 0)) {
+     cString url = cString::sprintf("%s/program.sl?programid=%d&ajax=true", *baseUrlM, idP);
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         if (Perform(*url, "GetEventInfo")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "GetEventInfo", true, true)) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
-               Login();
+               Login(request);
                continue;
                }
             else {
-               json_error_t error;
-               json_t *obj = json_loads(*dataM, 0, &error);
+               json_t *obj = request.Parse(__PRETTY_FUNCTION__);
                if (obj) {
-                  bool has_started = false, has_ended = false, recorded = false, ready = false, is_wildcard = false, scrambled_channel = false;
-                  int id = 0, length = 0, programviewid = 0, recordingid = 0;
-                  cString name = "", channel = "", short_text = "", description = "", flength = "", tn = "", start_time = "", end_time = "", url = "";
-                  json_t *obj2 = json_object_get(obj, "id");
-                  if (json_is_string(obj2))
-                     id = (int)strtol(json_string_value(obj2), NULL, 10);
-                  obj2 = json_object_get(obj, "length");
-                  if (json_is_string(obj2))
-                     length = (int)strtol(json_string_value(obj2), NULL, 10);
-                  obj2 = json_object_get(obj, "programviewid");
-                  if (json_is_string(obj2))
-                     programviewid = (int)strtol(json_string_value(obj2), NULL, 10);
-                  obj2 = json_object_get(obj, "recordingid");
-                  if (json_is_string(obj2))
-                     recordingid = (int)strtol(json_string_value(obj2), NULL, 10);
-                  obj2 = json_object_get(obj, "name");
-                  if (json_is_string(obj2))
-                     name = Unescape(json_string_value(obj2));
-                  obj2 = json_object_get(obj, "channel");
-                  if (json_is_string(obj2))
-                     channel = Unescape(json_string_value(obj2));
-                  obj2 = json_object_get(obj, "short_text");
-                  if (json_is_string(obj2))
-                     short_text = Unescape(json_string_value(obj2));
-                  obj2 = json_object_get(obj, "description");
-                  if (json_is_string(obj2))
-                     description = Unescape(json_string_value(obj2));
-                  obj2 = json_object_get(obj, "flength");
-                  if (json_is_string(obj2))
-                     flength = Unescape(json_string_value(obj2));
-                  obj2 = json_object_get(obj, "tn");
-                  if (json_is_string(obj2))
-                     tn = Unescape(json_string_value(obj2));
-                  obj2 = json_object_get(obj, "start_time");
-                  if (json_is_string(obj2))
-                     start_time = Unescape(json_string_value(obj2));
-                  obj2 = json_object_get(obj, "end_time");
-                  if (json_is_string(obj2))
-                     end_time = Unescape(json_string_value(obj2));
-                  obj2 = json_object_get(obj, "url");
-                  if (json_is_string(obj2))
-                     url = Unescape(json_string_value(obj2));
-                  obj2 = json_object_get(obj, "has_started");
-                  if (json_is_string(obj2) && !strcasecmp(json_string_value(obj2), "true"))
-                     has_started = true;
-                  obj2 = json_object_get(obj, "has_ended");
-                  if (json_is_string(obj2) && !strcasecmp(json_string_value(obj2), "true"))
-                     has_ended = true;
-                  obj2 = json_object_get(obj, "recorded");
-                  if (json_is_string(obj2) && !strcasecmp(json_string_value(obj2), "true"))
-                     recorded = true;
-                  obj2 = json_object_get(obj, "ready");
-                  if (json_is_string(obj2) && !strcasecmp(json_string_value(obj2), "true"))
-                     ready = true;
-                  obj2 = json_object_get(obj, "is_wildcard");
-                  if (json_is_string(obj2) && !strcasecmp(json_string_value(obj2), "true"))
-                     is_wildcard = true;
-                  obj2 = json_object_get(obj, "scrambled_channel");
-                  if (json_is_string(obj2) && !strcasecmp(json_string_value(obj2), "true"))
-                     scrambled_channel = true;
-                  debug2("%s (%d) id=%d name='%s' channel='%s' short_text='%s' description='%s' length=%d flength='%s' tn='%s' start_time='%s' end_time='%s' url='%s' "
-                        "programviewid=%d recordingid=%d has_started=%d has_ended=%d recorded=%d ready=%d is_wildcard=%d scrambled_channel=%d", __PRETTY_FUNCTION__, idP,
-                        id, *name, *channel, *short_text, *description, length, *flength, *tn, *start_time, *end_time, *url, programviewid, recordingid, has_started,
-                        has_ended, recorded, ready, is_wildcard, scrambled_channel);
+                  cElvisWidgetDecoder decoder;
+                  cElvisWidgetEventInfoRecord r;
+                  cElvisWidgetEventInfo *info = NULL;
+                  if (decoder.Decode(obj, eventInfoFieldsS, r)) {
+                     debug2("%s (%d) id=%d name='%s' channel='%s' short_text='%s' description='%s' length=%d flength='%s' tn='%s' start_time='%s' end_time='%s' url='%s' "
+                           "programviewid=%d recordingid=%d has_started=%d has_ended=%d recorded=%d ready=%d is_wildcard=%d scrambled_channel=%d", __PRETTY_FUNCTION__, idP,
+                           r.id, r.name, r.channel, r.short_text, r.description, r.length, r.flength, r.tn, r.start_time, r.end_time, r.url, r.programviewid, r.recordingid, r.has_started,
+                           r.has_ended, r.recorded, r.ready, r.is_wildcard, r.scrambled_channel);
+                     info = new cElvisWidgetEventInfo(r.id, r.name, r.channel, r.short_text, r.description, r.length, r.flength, r.tn, r.start_time, r.end_time, r.url, r.programviewid,
+                                                      r.recordingid, r.has_started, r.has_ended, r.recorded, r.ready, r.is_wildcard, r.scrambled_channel);
+                     }
                   json_decref(obj);
-                  return new cElvisWidgetEventInfo(id, *name, *channel, *short_text, *description, length, *flength, *tn, *start_time, *end_time, *url, programviewid,
-                                               recordingid, has_started, has_ended, recorded, ready, is_wildcard, scrambled_channel);
+                  return info;
                   }
                }
             }
@@ -1287,61 +2161,27 @@ cElvisWidgetEventInfo *cElvisWidget::GetEventInfo(int idP)
 
 cElvisWidgetVODInfo *cElvisWidget::GetVODInfo(int idP)
 {
-  cMutexLock(mutexM);
-  if (handleM && (idP > 0)) {
-     cString url = cString::sprintf("%s/vod.sl?data=true&vod=%d&ajax=true", baseUrlViihdeS, idP);
+  if (engineM && (idP > 0)) {
+     cString url = cString::sprintf("%s/vod.sl?data=true&vod=%d&ajax=true", *baseUrlM, idP);
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         if (Perform(*url, "GetVODInfo")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "GetVODInfo", true, true)) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
-               Login();
+               Login(request);
                continue;
                }
             else {
-               json_error_t error;
-               json_t *obj = json_loads(*dataM, 0, &error);
+               json_t *obj = request.Parse(__PRETTY_FUNCTION__);
                if (obj) {
-                  int id = 0, length = 0, agelimit = 0, year = 0, price = 0;
-                  cString title = "", original_title = "", currency = "", short_desc = "", info = "", info2 = "", trailer_url = "", categories = "";
-                  json_t *obj2 = json_object_get(obj, "id");
-                  if (json_is_string(obj2))
-                     id = (int)strtol(json_string_value(obj2), NULL, 10);
-                  obj2 = json_object_get(obj, "length");
-                  if (json_is_string(obj2))
-                     length = (int)strtol(json_string_value(obj2), NULL, 10);
-                  obj2 = json_object_get(obj, "agelimit");
-                  if (json_is_string(obj2))
-                     agelimit = (int)strtol(json_string_value(obj2), NULL, 10);
-                  obj2 = json_object_get(obj, "year");
-                  if (json_is_string(obj2))
-                     year = (int)strtol(json_string_value(obj2), NULL, 10);
-                  obj2 = json_object_get(obj, "price");
-                  if (json_is_string(obj2))
-                     price = (int)strtol(json_string_value(obj2), NULL, 10);
-                  obj2 = json_object_get(obj, "title");
-                  if (json_is_string(obj2))
-                     title = Unescape(json_string_value(obj2));
-                  obj2 = json_object_get(obj, "original_title");
-                  if (json_is_string(obj2))
-                     original_title = Unescape(json_string_value(obj2));
-                  obj2 = json_object_get(obj, "currency");
-                  if (json_is_string(obj2))
-                     currency = Unescape(json_string_value(obj2));
-                  obj2 = json_object_get(obj, "short_desc");
-                  if (json_is_string(obj2))
-                     short_desc = Unescape(json_string_value(obj2));
-                  obj2 = json_object_get(obj, "info");
-                  if (json_is_string(obj2))
-                     info = Unescape(strstrip(json_string_value(obj2), "\r"));
-                  obj2 = json_object_get(obj, "info2");
-                  if (json_is_string(obj2))
-                     info2 = Unescape(json_string_value(obj2));
-                  obj2 = json_object_get(obj, "trailer_url");
-                  if (json_is_string(obj2))
-                     trailer_url = Unescape(json_string_value(obj2));
-                  obj2 = json_object_get(obj, "categories");
+                  cElvisWidgetDecoder decoder;
+                  cElvisWidgetVODInfoRecord r;
+                  cString categories = "";
+                  if (!decoder.Decode(obj, vodInfoFieldsS, r)) {
+                     json_decref(obj);
+                     return NULL;
+                     }
+                  json_t *obj2 = json_object_get(obj, "categories");
                   if (json_is_array(obj2)) {
                      for (unsigned int i = 0; i < json_array_size(obj2); i++) {
                          json_t *obj3 = json_array_get(obj2, i);
@@ -1357,11 +2197,14 @@ cElvisWidgetVODInfo *cElvisWidget::GetVODInfo(int idP)
                             }
                          }
                      }
+                  cString info = strstrip(r.info_text, "\r");
                   debug2("%s (%d) id=%d length=%d agelimit=%d year=%d price=%d title='%s' original_title='%s' currency='%s' short_desc='%s' info='%s' info2='%s' "
-                        "trailer_url='%s' categories='%s'", __PRETTY_FUNCTION__, idP, id, length, agelimit, year, price, *title, *original_title, *currency,
-                        *short_desc, *info, *info2, *trailer_url, *categories);
+                        "trailer_url='%s' categories='%s'", __PRETTY_FUNCTION__, idP, r.id, r.length, r.agelimit, r.year, r.price, r.title, r.original_title, r.currency,
+                        r.short_desc, *info, r.info2, r.trailer_url, *categories);
+                  cElvisWidgetVODInfo *vodInfo = new cElvisWidgetVODInfo(r.id, r.length, r.agelimit, r.year, r.price, r.title, r.original_title, r.currency, r.short_desc, *info, r.info2,
+                                                                       r.trailer_url, *categories);
                   json_decref(obj);
-                  return new cElvisWidgetVODInfo(id, length, agelimit, year, price, *title, *original_title, *currency, *short_desc, *info, *info2, *trailer_url, *categories);
+                  return vodInfo;
                   }
                }
             }
@@ -1373,68 +2216,39 @@ cElvisWidgetVODInfo *cElvisWidget::GetVODInfo(int idP)
 
 bool cElvisWidget::SearchVOD(cElvisWidgetVODCallbackIf &callbackP, const char *titleP, const char *descP, bool hdP)
 {
-  cMutexLock(mutexM);
   cString term = cString::sprintf("&format=%s", hdP ? "HD" : "NONHD");
 
   if (titleP && !isempty(titleP))
      term = cString::sprintf("%s&title=%s", *term, *Escape(titleP));
   if (descP && !isempty(descP))
      term = cString::sprintf("%s&description=%s", *term, *Escape(descP));
-  if (handleM && !isempty(*term)) {
-     cString url = cString::sprintf("%s/vod.sl?data=true&category=all&advancedsearch=true&ajax=true%s", baseUrlViihdeS, *term);
+  if (engineM && !isempty(*term)) {
+     cString url = cString::sprintf("%s/vod.sl?data=true&category=all&advancedsearch=true&ajax=true%s", *baseUrlM, *term);
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         if (Perform(*url, "SearchVOD")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "SearchVOD", true)) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
-               Login();
+               Login(request);
                continue;
                }
             else {
-               json_error_t error;
-               json_t *obj = json_loads(*dataM, 0, &error);
+               json_t *obj = request.Parse(__PRETTY_FUNCTION__);
                if (obj) {
+                  cElvisWidgetDecoder decoder;
                   void *iter = json_object_iter(obj);
                   while (iter) {
                         const char *key = json_object_iter_key(iter);
                         json_t *value = json_object_iter_value(iter);
                         if (!strcmp(key, "vods") && json_is_array(value)) {
                            for (unsigned int i = 0; i < json_array_size(value); i++) {
-                               int id = 0, length = 0, agelimit = 0, year = 0, price = 0;
-                               cString title = "", currency = "", cover = "", trailer = "";
-                               json_t *obj2 = json_array_get(value, i);
-                               json_t *obj3 = json_object_get(obj2, "id");
-                               if (json_is_string(obj3))
-                                  id = (int)strtol(json_string_value(obj3), NULL, 10);
-                               obj3 = json_object_get(obj2, "length");
-                               if (json_is_string(obj3))
-                                  length = (int)strtol(json_string_value(obj3), NULL, 10);
-                               obj3 = json_object_get(obj2, "agelimit");
-                               if (json_is_string(obj3))
-                                  agelimit = (int)strtol(json_string_value(obj3), NULL, 10);
-                               obj3 = json_object_get(obj2, "year");
-                               if (json_is_string(obj3))
-                                  year = (int)strtol(json_string_value(obj3), NULL, 10);
-                               obj3 = json_object_get(obj2, "price");
-                               if (json_is_string(obj3))
-                                  price = (int)strtol(json_string_value(obj3), NULL, 10);
-                               obj3 = json_object_get(obj2, "title");
-                               if (json_is_string(obj3))
-                                  title = Unescape(json_string_value(obj3));
-                               obj3 = json_object_get(obj2, "currency");
-                               if (json_is_string(obj3))
-                                  currency = Unescape(json_string_value(obj3));
-                               obj3 = json_object_get(obj2, "cover");
-                               if (json_is_string(obj3))
-                                  cover = Unescape(json_string_value(obj3));
-                               obj3 = json_object_get(obj2, "trailer");
-                               if (json_is_string(obj3))
-                                  trailer = Unescape(json_string_value(obj3));
-                               debug2("%s (, %s, %s, %d) id=%d length=%d agelimit=%d year=%d price=%d title='%s' currency='%s' cover='%s' trailer='%s'",
-                                      __PRETTY_FUNCTION__, titleP, descP, hdP,
-                                      id, length, agelimit, year, price, *title, *currency, *cover, *trailer);
-                               callbackP.AddVOD(id, length, agelimit, year, price, *title, *currency, *cover, *trailer);
+                               cElvisWidgetVODRecord r;
+                               if (decoder.Decode(json_array_get(value, i), vodFieldsS, r)) {
+                                  debug2("%s (, %s, %s, %d) id=%d length=%d agelimit=%d year=%d price=%d title='%s' currency='%s' cover='%s' trailer='%s'",
+                                         __PRETTY_FUNCTION__, titleP, descP, hdP,
+                                         r.id, r.length, r.agelimit, r.year, r.price, r.title, r.currency, r.cover, r.trailer);
+                                  callbackP.AddVOD(r.id, r.length, r.agelimit, r.year, r.price, r.title, r.currency, r.cover, r.trailer);
+                                  }
                                }
                            }
                         iter = json_object_iter_next(obj, iter);
@@ -1452,20 +2266,17 @@ bool cElvisWidget::SearchVOD(cElvisWidgetVODCallbackIf &callbackP, const char *t
 
 bool cElvisWidget::SetVODFavorite(int idP, bool onOffP)
 {
-  cMutexLock(mutexM);
-
-  if (handleM && (idP > 0)) {
-     cString url = cString::sprintf("%s/vod.sl?action=true&%sfavorite=%d&ajax=true", baseUrlViihdeS, onOffP ? "add" : "remove", idP);
+  if (engineM && (idP > 0)) {
+     cString url = cString::sprintf("%s/vod.sl?action=true&%sfavorite=%d&ajax=true", *baseUrlM, onOffP ? "add" : "remove", idP);
      for (int retries = 0; retries < eLoginRetries; ++retries) {
-         if (retries > 0)
-            cCondWait::SleepMs(eLoginTimeout);
-         if (Perform(*url, "SetVODFavorite")) {
-            if (IsLoginRequired(*dataM)) {
+         cElvisWidgetRequest request;
+         if (Perform(request, *url, "SetVODFavorite")) {
+            if (request.IsLoginRequired()) {
                info("%s Relogin...", __PRETTY_FUNCTION__);
-               Login();
+               Login(request);
                continue;
                }
-            else if (strstr(*dataM, "OK")) {
+            else if (strstr(request.Data(), "OK")) {
                return true;
                }
             }
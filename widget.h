@@ -22,14 +22,29 @@
 
 // --- cElvisWidgetCallbacks -------------------------------------------
 
-class cElvisWidgetFolderCallbackIf {
+class cElvisWidgetCallbackIf {
+private:
+  bool validM;
+  bool notModifiedM;
+public:
+  cElvisWidgetCallbackIf() : validM(false), notModifiedM(false) {}
+  virtual ~cElvisWidgetCallbackIf() {}
+  // the callback still holds everything parsed from the previous reply
+  void Validate(bool onOffP) { validM = onOffP; }
+  bool IsValid() { return validM; }
+  // the previous reply was revalidated and nothing was parsed
+  void NotModified(bool onOffP) { notModifiedM = onOffP; }
+  bool IsNotModified() { return notModifiedM; }
+};
+
+class cElvisWidgetFolderCallbackIf : public cElvisWidgetCallbackIf {
 public:
   cElvisWidgetFolderCallbackIf() {}
   virtual ~cElvisWidgetFolderCallbackIf() {}
   virtual void AddFolder(int folderIdP, const char *folderNameP, int recCountP, bool protectedP) = 0;
 };
 
-class cElvisWidgetRecordingCallbackIf {
+class cElvisWidgetRecordingCallbackIf : public cElvisWidgetCallbackIf {
 public:
   cElvisWidgetRecordingCallbackIf() {}
   virtual ~cElvisWidgetRecordingCallbackIf() {}
@@ -37,58 +52,76 @@ public:
   virtual void AddRecording(int idP, int programIdP, int folderIdP, int countP, int lengthP, const char *nameP, const char *channelP, const char *startTimeP) = 0;
 };
 
-class cElvisWidgetTimerCallbackIf {
+class cElvisWidgetTimerCallbackIf : public cElvisWidgetCallbackIf {
 public:
   cElvisWidgetTimerCallbackIf() {}
   virtual ~cElvisWidgetTimerCallbackIf() {}
   virtual void AddTimer(int idP, int lengthP, const char *nameP, const char *channelP, const char *startTimeP, const char *wildcardP) = 0;
 };
 
-class cElvisWidgetSearchTimerCallbackIf {
+class cElvisWidgetSearchTimerCallbackIf : public cElvisWidgetCallbackIf {
 public:
   cElvisWidgetSearchTimerCallbackIf() {}
   virtual ~cElvisWidgetSearchTimerCallbackIf() {}
   virtual void AddSearchTimer(int idP, const char *folderP, const char *addedP, const char *channelP, const char *wildcardP) = 0;
 };
 
-class cElvisWidgetChannelCallbackIf {
+class cElvisWidgetChannelCallbackIf : public cElvisWidgetCallbackIf {
 public:
   cElvisWidgetChannelCallbackIf() {}
   virtual ~cElvisWidgetChannelCallbackIf() {}
   virtual void AddChannel(const char *nameP, const char *logoP) = 0;
 };
 
-class cElvisWidgetEventCallbackIf {
+class cElvisWidgetEventCallbackIf : public cElvisWidgetCallbackIf {
 public:
   cElvisWidgetEventCallbackIf() {}
   virtual ~cElvisWidgetEventCallbackIf() {}
   virtual void AddEvent(int idP, const char *nameP, const char *simpleStartTimeP, const char *simpleEndTimeP, const char *startTimeP, const char *endTimeP) = 0;
 };
 
-class cElvisWidgetEPGCallbackIf {
+class cElvisWidgetEPGCallbackIf : public cElvisWidgetCallbackIf {
 public:
   cElvisWidgetEPGCallbackIf() {}
   virtual ~cElvisWidgetEPGCallbackIf() {}
   virtual void AddEvent(const char *channelP, int idP, const char *nameP, const char *simpleStartTimeP, const char *simpleEndTimeP, const char *startTimeP, const char *endTimeP, const char *descriptionP) = 0;
 };
 
-class cElvisWidgetTopEventCallbackIf {
+class cElvisWidgetTopEventCallbackIf : public cElvisWidgetCallbackIf {
 public:
   cElvisWidgetTopEventCallbackIf() {}
   virtual ~cElvisWidgetTopEventCallbackIf() {}
   virtual void AddEvent(int idP, const char *nameP, const char *channelP, const char *startTimeP, const char *endTimeP) = 0;
 };
 
-class cElvisWidgetVODCallbackIf {
+class cElvisWidgetVODCallbackIf : public cElvisWidgetCallbackIf {
 public:
   cElvisWidgetVODCallbackIf() {}
   virtual ~cElvisWidgetVODCallbackIf() {}
   virtual void AddVOD(int idP, int lengthP, int ageLimitP, int yearP, int priceP, const char *titleP, const char *currencyP, const char *coverP, const char *trailerP) = 0;
 };
 
+// --- cElvisWidgetInfo -----------------------------------------------------
+
+// info objects are shared by all of their holders and deleted by the last Release()
+class cElvisWidgetInfo {
+private:
+  int refsM;
+  // to prevent copy constructor and assignment
+  cElvisWidgetInfo(const cElvisWidgetInfo&);
+  cElvisWidgetInfo& operator=(const cElvisWidgetInfo&);
+protected:
+  virtual ~cElvisWidgetInfo() {}
+public:
+  cElvisWidgetInfo() : refsM(1) {}
+  void AddRef() { __sync_add_and_fetch(&refsM, 1); }
+  void Release() { if (__sync_sub_and_fetch(&refsM, 1) == 0) delete this; }
+  virtual size_t Size() = 0;
+};
+
 // --- cElvisWidgetEventInfo ------------------------------------------------
 
-class cElvisWidgetEventInfo {
+class cElvisWidgetEventInfo : public cElvisWidgetInfo {
 private:
   int idM;
   int lengthM;
@@ -116,11 +149,13 @@ private:
   // to prevent copy constructor and assignment
   cElvisWidgetEventInfo(const cElvisWidgetEventInfo&);
   cElvisWidgetEventInfo& operator=(const cElvisWidgetEventInfo&);
+protected:
+  virtual ~cElvisWidgetEventInfo();
 public:
   cElvisWidgetEventInfo(int idP, const char *nameP, const char *channelP, const char *shortTextP, const char *descriptionP, int lengthP, const char *fLengthP,
                     const char *thumbnailP, const char *startTimeP, const char *endTimeP, const char *urlP, int programViewIdP, int recordingIdP,
                     bool hasStartedP, bool hasEndedP, bool isRecordedP, bool isReadyP, bool isWildcardP, bool isEncrypted);
-  virtual ~cElvisWidgetEventInfo();
+  virtual size_t Size();
   int Id() { return idM; }
   int LengthValue() { return lengthM; }
   const char *Name() { return *nameM; }
@@ -138,7 +173,7 @@ public:
 
 // --- cElvisWidgetVODInfo --------------------------------------------------
 
-class cElvisWidgetVODInfo {
+class cElvisWidgetVODInfo : public cElvisWidgetInfo {
 private:
   int idM;
   int lengthM;
@@ -158,10 +193,12 @@ private:
   // to prevent copy constructor and assignment
   cElvisWidgetVODInfo(const cElvisWidgetVODInfo&);
   cElvisWidgetVODInfo& operator=(const cElvisWidgetVODInfo&);
+protected:
+  virtual ~cElvisWidgetVODInfo();
 public:
   cElvisWidgetVODInfo(int idP, int lengthP, int ageLimitP, int yearP, int priceP, const char *titleP, const char *originalTitleP, const char *currencyP,
                       const char *shortDescriptionP, const char *infoP, const char *info2P, const char *trailerUrlP, const char *categoriesP);
-  virtual ~cElvisWidgetVODInfo();
+  virtual size_t Size();
   int Id() { return idM; }
   int Length() { return lengthM; }
   int AgeLimit() { return ageLimitM; }
@@ -177,30 +214,450 @@ public:
   const char *Categories() { return *categoriesM; }
 };
 
+// --- cElvisWidgetRecords ---------------------------------------------
+
+// decoded strings are only valid until the next record is decoded or the reply is released
+struct cElvisWidgetFolderRecord {
+  int id;
+  int count;
+  bool has_pin;
+  const char *name;
+  cElvisWidgetFolderRecord() : id(0), count(0), has_pin(false), name("") {}
+};
+
+struct cElvisWidgetRecordingFolderRecord {
+  int id;
+  int recordings_count;
+  const char *name;
+  const char *size;
+  cElvisWidgetRecordingFolderRecord() : id(0), recordings_count(0), name(""), size("") {}
+};
+
+struct cElvisWidgetRecordingRecord {
+  int id;
+  int program_id;
+  int folder_id;
+  int viewcount;
+  int length;
+  const char *name;
+  const char *channel;
+  const char *start_time;
+  cElvisWidgetRecordingRecord() : id(0), program_id(0), folder_id(0), viewcount(0), length(0), name(""), channel(""), start_time("") {}
+};
+
+struct cElvisWidgetTimerRecord {
+  int program_id;
+  int length;
+  const char *name;
+  const char *channel;
+  const char *start_time;
+  const char *wild_card;
+  cElvisWidgetTimerRecord() : program_id(0), length(0), name(""), channel(""), start_time(""), wild_card("") {}
+};
+
+struct cElvisWidgetSearchTimerRecord {
+  int recording_id;
+  const char *folder;
+  const char *added;
+  const char *wild_card_channel;
+  const char *wild_card;
+  cElvisWidgetSearchTimerRecord() : recording_id(0), folder(""), added(""), wild_card_channel(""), wild_card("") {}
+};
+
+struct cElvisWidgetEventRecord {
+  int id;
+  const char *name;
+  const char *simple_start_time;
+  const char *simple_end_time;
+  const char *start_time;
+  const char *end_time;
+  const char *short_text;
+  cElvisWidgetEventRecord() : id(0), name(""), simple_start_time(""), simple_end_time(""), start_time(""), end_time(""), short_text("") {}
+};
+
+struct cElvisWidgetTopEventRecord {
+  int program_id;
+  const char *name;
+  const char *channel;
+  const char *start_time;
+  const char *end_time;
+  cElvisWidgetTopEventRecord() : program_id(0), name(""), channel(""), start_time(""), end_time("") {}
+};
+
+struct cElvisWidgetVODRecord {
+  int id;
+  int length;
+  int agelimit;
+  int year;
+  int price;
+  const char *title;
+  const char *currency;
+  const char *cover;
+  const char *trailer;
+  cElvisWidgetVODRecord() : id(0), length(0), agelimit(0), year(0), price(0), title(""), currency(""), cover(""), trailer("") {}
+};
+
+struct cElvisWidgetEventInfoRecord {
+  int id;
+  int length;
+  int programviewid;
+  int recordingid;
+  bool has_started;
+  bool has_ended;
+  bool recorded;
+  bool ready;
+  bool is_wildcard;
+  bool scrambled_channel;
+  const char *name;
+  const char *channel;
+  const char *short_text;
+  const char *description;
+  const char *flength;
+  const char *tn;
+  const char *start_time;
+  const char *end_time;
+  const char *url;
+  cElvisWidgetEventInfoRecord() : id(0), length(0), programviewid(0), recordingid(0), has_started(false), has_ended(false), recorded(false), ready(false),
+                                  is_wildcard(false), scrambled_channel(false), name(""), channel(""), short_text(""), description(""), flength(""), tn(""),
+                                  start_time(""), end_time(""), url("") {}
+};
+
+struct cElvisWidgetVODInfoRecord {
+  int id;
+  int length;
+  int agelimit;
+  int year;
+  int price;
+  const char *title;
+  const char *original_title;
+  const char *currency;
+  const char *short_desc;
+  const char *info_text;
+  const char *info2;
+  const char *trailer_url;
+  cElvisWidgetVODInfoRecord() : id(0), length(0), agelimit(0), year(0), price(0), title(""), original_title(""), currency(""), short_desc(""), info_text(""),
+                                info2(""), trailer_url("") {}
+};
+
+// --- cElvisWidgetDecoder ---------------------------------------------
+
+// exactly one of the member pointers is set for each field
+template<class T> struct cElvisWidgetField {
+  const char *name;
+  int T::*integer;
+  bool T::*boolean;
+  const char *T::*string;
+};
+
+class cElvisWidgetDecoder {
+private:
+  enum {
+    eInitialSize = 1024
+  };
+  char *dataM;
+  size_t sizeM;
+  size_t lengthM;
+  ssize_t Put(const char *strP);
+  // to prevent copy constructor and assignment
+  cElvisWidgetDecoder(const cElvisWidgetDecoder&);
+  cElvisWidgetDecoder& operator=(const cElvisWidgetDecoder&);
+public:
+  cElvisWidgetDecoder();
+  virtual ~cElvisWidgetDecoder();
+  template<class T, size_t N> bool Decode(json_t *objP, const cElvisWidgetField<T> (&fieldsP)[N], T &recordP);
+};
+
+template<class T, size_t N> bool cElvisWidgetDecoder::Decode(json_t *objP, const cElvisWidgetField<T> (&fieldsP)[N], T &recordP)
+{
+  ssize_t offset[N];
+
+  if (!json_is_object(objP))
+     return false;
+
+  recordP = T();
+  lengthM = 0;
+  for (size_t i = 0; i < N; ++i)
+      offset[i] = -1;
+  // single pass over the object; strings are stored as offsets as the scratch buffer may move
+  for (void *iter = json_object_iter(objP); iter; iter = json_object_iter_next(objP, iter)) {
+      json_t *value = json_object_iter_value(iter);
+      if (!json_is_string(value))
+         continue;
+      const char *key = json_object_iter_key(iter);
+      for (size_t i = 0; i < N; ++i) {
+          if ((*key == *fieldsP[i].name) && !strcmp(key, fieldsP[i].name)) {
+             const char *str = json_string_value(value);
+             if (fieldsP[i].integer)
+                recordP.*fieldsP[i].integer = (int)strtol(str, NULL, 10);
+             else if (fieldsP[i].boolean)
+                recordP.*fieldsP[i].boolean = !strcasecmp(str, "true");
+             else if (fieldsP[i].string && !strchr(str, '%'))
+                recordP.*fieldsP[i].string = str; // nothing to unescape, so refer to the reply itself
+             else if (fieldsP[i].string)
+                offset[i] = Put(str);
+             break;
+             }
+          }
+      }
+  for (size_t i = 0; i < N; ++i) {
+      if (offset[i] >= 0)
+         recordP.*fieldsP[i].string = dataM + offset[i];
+      }
+
+  return true;
+}
+
+// --- cElvisWidgetBuffer ----------------------------------------------
+
+class cElvisWidgetBuffer {
+private:
+  enum {
+    eInitialSize = 16384
+  };
+  char *dataM;
+  size_t sizeM;
+  size_t lengthM;
+  size_t readM;
+  // to prevent copy constructor and assignment
+  cElvisWidgetBuffer(const cElvisWidgetBuffer&);
+  cElvisWidgetBuffer& operator=(const cElvisWidgetBuffer&);
+public:
+  cElvisWidgetBuffer();
+  virtual ~cElvisWidgetBuffer();
+  const char *operator*() const { return dataM ? dataM : ""; }
+  size_t Length() const { return lengthM; }
+  size_t Available() const { return lengthM - readM; }
+  bool Put(const char *dataP, size_t lenP);
+  size_t Get(char *bufferP, size_t lenP);
+};
+
+// --- cElvisWidgetCache -----------------------------------------------
+
+class cElvisWidgetCache {
+private:
+  enum {
+    eMaxAge          = 7 * 86400, // 7d since the last use
+    eMaxSize         = MEGABYTE(16),
+    eCleanupInterval = 3600       // 60min
+  };
+  static const char *baseCacheNameS;
+  cMutex mutexM;
+  cString directoryM;
+  time_t lastCleanupM;
+  unsigned long hitsM;
+  unsigned long missesM;
+  unsigned long removalsM;
+  cString FileName(const char *urlP);
+  // to prevent copy constructor and assignment
+  cElvisWidgetCache(const cElvisWidgetCache&);
+  cElvisWidgetCache& operator=(const cElvisWidgetCache&);
+public:
+  cElvisWidgetCache();
+  virtual ~cElvisWidgetCache();
+  bool Load(const char *directoryP);
+  bool Validators(const char *urlP, cString &etagP, cString &lastModifiedP);
+  bool Get(const char *urlP, cElvisWidgetBuffer &bufferP);
+  bool Put(const char *urlP, const char *etagP, const char *lastModifiedP, const char *dataP, size_t lenP);
+  // removes the entries unused for too long and then the least recently used ones over the size limit
+  void Cleanup(bool forceP = false);
+  void Hit();
+  void Miss();
+  cString Statistics();
+};
+
+// --- cElvisWidgetSession ---------------------------------------------
+
+class cElvisWidgetSession {
+private:
+  static const char *baseCookieNameS;
+  cMutex mutexM;
+  cString fileNameM;
+  int generationM;
+  bool validM;
+  unsigned long loginsM;
+  unsigned long coalescedM;
+  // to prevent copy constructor and assignment
+  cElvisWidgetSession(const cElvisWidgetSession&);
+  cElvisWidgetSession& operator=(const cElvisWidgetSession&);
+public:
+  cElvisWidgetSession();
+  virtual ~cElvisWidgetSession();
+  bool Load(const char *directoryP);
+  bool Save();
+  void Clear();
+  // every successful login starts a new generation of the session
+  int Generation();
+  bool IsValid();
+  void Renew(bool validP);
+  void Coalesced();
+  cString Statistics();
+};
+
+// --- cElvisWidgetTimings ---------------------------------------------
+
+class cElvisWidgetTimings {
+private:
+  class cTiming : public cListObject {
+  public:
+    const char *nameM;
+    unsigned long callsM;
+    uint64_t transferMsM;
+    uint64_t totalMsM;
+    uint64_t maxMsM;
+    uint64_t bytesM;
+    cTiming(const char *nameP) : nameM(nameP), callsM(0), transferMsM(0), totalMsM(0), maxMsM(0), bytesM(0) {}
+  };
+  cMutex mutexM;
+  cList<cTiming> timingsM;
+  // to prevent copy constructor and assignment
+  cElvisWidgetTimings(const cElvisWidgetTimings&);
+  cElvisWidgetTimings& operator=(const cElvisWidgetTimings&);
+public:
+  cElvisWidgetTimings();
+  virtual ~cElvisWidgetTimings();
+  // the name must be a string literal
+  void Account(const char *nameP, uint64_t transferMsP, uint64_t totalMsP, size_t bytesP);
+  cString Statistics();
+};
+
+// --- cElvisWidgetPriority --------------------------------------------
+
+// selects the scheduling lane of the requests made by the current thread
+// for as long as the object is in scope
+class cElvisWidgetPriority {
+public:
+  enum ePriority {
+    epInteractive = 0,
+    epPrefetch,
+    epBackground,
+    epCount
+  };
+private:
+  static __thread int currentS;
+  int previousM;
+  // to prevent copy constructor and assignment
+  cElvisWidgetPriority(const cElvisWidgetPriority&);
+  cElvisWidgetPriority& operator=(const cElvisWidgetPriority&);
+public:
+  cElvisWidgetPriority(ePriority priorityP) : previousM(currentS) { currentS = priorityP; }
+  ~cElvisWidgetPriority() { currentS = previousM; }
+  static int Current() { return currentS; }
+};
+
+// --- cElvisWidgetRequest ---------------------------------------------
+
+class cElvisWidgetEngine;
+
+class cElvisWidgetRequest {
+  friend class cElvisWidget;
+  friend class cElvisWidgetEngine;
+private:
+  static size_t WriteCallback(void *ptrP, size_t sizeP, size_t nmembP, void *dataP);
+  static size_t ReadCallback(void *bufferP, size_t lenP, void *dataP);
+  static size_t HeaderCallback(void *ptrP, size_t sizeP, size_t nmembP, void *dataP);
+  cElvisWidgetEngine *engineM;
+  cElvisWidgetCache *cacheM;
+  cElvisWidgetCallbackIf *callbackM;
+  cElvisWidgetTimings *timingsM;
+  const char *nameM;
+  cTimeMs timerM;
+  uint64_t transferMsM;
+  size_t receivedM;
+  int sessionM;
+  int priorityM;
+  cString urlM;
+  cString etagM;
+  cString lastModifiedM;
+  struct curl_slist *headerListM;
+  CURL *handleM;
+  cElvisWidgetBuffer bufferM;
+  cMutex mutexM;
+  cCondVar condM;
+  CURLcode resultM;
+  long httpCodeM;
+  bool doneM;
+  bool abortM;
+  bool Put(const char *dataP, size_t lenP);
+  void PutHeader(const char *dataP, size_t lenP);
+  void Done(CURLcode resultP);
+  bool Aborted();
+  // to prevent copy constructor and assignment
+  cElvisWidgetRequest(const cElvisWidgetRequest&);
+  cElvisWidgetRequest& operator=(const cElvisWidgetRequest&);
+public:
+  cElvisWidgetRequest();
+  virtual ~cElvisWidgetRequest();
+  bool WaitData();
+  bool Wait();
+  void Abort();
+  bool IsLoginRequired();
+  json_t *Parse(const char *msgP);
+  // the length of the data received so far, without waiting for the transfer to complete
+  size_t Length();
+  // waits for the transfer to complete
+  const char *Data();
+  long HttpCode();
+  CURLcode Result();
+};
+
+// --- cElvisWidgetEngine ----------------------------------------------
+
+class cElvisWidgetEngine : public cThread {
+private:
+  enum {
+    eMaxActiveRequests = 4,
+    eReservedRequests  = 1,    // slots kept free for interactive requests
+    eIdleTimeoutMs     = 60000 // in milliseconds, the engine is woken up for any new work
+  };
+  CURLM *multiM;
+  cMutex mutexM;
+  cVector<cElvisWidgetRequest *> pendingM[cElvisWidgetPriority::epCount];
+  cVector<cElvisWidgetRequest *> activeM;
+  double tokensM;
+  uint64_t refillM;
+  unsigned long startedM[cElvisWidgetPriority::epCount];
+  unsigned long overtakenM;
+  unsigned long throttledM;
+  void Finish(cElvisWidgetRequest *requestP, CURLcode resultP);
+  int Refill();
+  cElvisWidgetRequest *Next();
+  bool Pending();
+  // to prevent copy constructor and assignment
+  cElvisWidgetEngine(const cElvisWidgetEngine&);
+  cElvisWidgetEngine& operator=(const cElvisWidgetEngine&);
+protected:
+  virtual void Action();
+public:
+  cElvisWidgetEngine();
+  virtual ~cElvisWidgetEngine();
+  bool Submit(cElvisWidgetRequest *requestP);
+  void Wakeup();
+  cString Statistics();
+};
+
 // --- cElvisWidget ----------------------------------------------------
 
 class cElvisWidget {
 private:
   enum {
-    eLoginRetries = 2,
-    eLoginTimeout = 1000 // in milliseconds
+    eLoginRetries = 2
   };
-  static const char *baseCookieNameS;
   static const char *baseUrlViihdeS;
+  cString baseUrlM;
   static cElvisWidget *instanceS;
   static int DebugCallback(CURL *handleP, curl_infotype typeP, char *dataP, size_t sizeP, void *userPtrP);
-  static size_t WriteCallback(void *ptrP, size_t sizeP, size_t nmembP, void *dataP);
-  cString dataM;
   cMutex mutexM;
-  CURL *handleM;
+  cElvisWidgetEngine *engineM;
+  cElvisWidgetCache cacheM;
+  cElvisWidgetSession sessionM;
+  cElvisWidgetTimings timingsM;
+  cString directoryM;
   struct curl_slist *headerListM;
   cString Unescape(const char *s);
   cString Escape(const char *s);
-  bool Perform(const char *urlP, const char *msgP);
-  bool Login();
+  bool Perform(cElvisWidgetRequest &requestP, const char *urlP, const char *msgP, bool streamP = false, bool cacheP = false, cElvisWidgetCallbackIf *callbackP = NULL);
+  bool Login(cElvisWidgetRequest &requestP);
   bool Logout();
-  bool IsLogged();
-  bool IsLoginRequired(const char *stringP);
   void ParseFolders(cElvisWidgetFolderCallbackIf &callbackP, json_t *objP, int folderIdP = -1);
   // constructor
   cElvisWidget();
@@ -212,8 +669,11 @@ public:
   static void Destroy();
   virtual ~cElvisWidget();
   bool Invalidate();
-  bool Load(const char *directoryP);
-  void PutData(const char *dataP, unsigned int lenP);
+  bool Load(const char *directoryP, const char *serverP = NULL);
+  void Housekeeping();
+  cString Statistics();
+  // times every call against a local server given with --server
+  cString Benchmark(int roundsP);
   bool GetFolders(cElvisWidgetFolderCallbackIf &callbackP);
   bool GetRecordings(cElvisWidgetRecordingCallbackIf &callbackP, int folderIdP = -1);
   bool RemoveRecording(int idP);